@@ -0,0 +1,114 @@
+#pragma once
+#include "async.hpp"
+#include "file.hpp"
+#include "path.hpp"
+#include <3ds.h>
+#include <future>
+#include <memory>
+
+namespace fslib
+{
+    /// @brief File whose requests run on the async worker pool. Requests made on the same AsyncFile run in the order they were
+    /// made. Requests on different AsyncFiles can run in parallel.
+    /// @note Buffers passed to this need to stay valid until the request using them is done. An AsyncFile can be destroyed or waited on
+    /// from one of its own completion functions. Doing that to a different AsyncFile from a completion function can deadlock the pool.
+    class AsyncFile
+    {
+        public:
+            /// @brief Default AsyncFile constructor.
+            AsyncFile(void);
+
+            /// @brief Waits for any requests still pending and closes the file.
+            ~AsyncFile();
+
+            // None of this. Requests still pending hold a pointer to the file.
+            AsyncFile(const AsyncFile &) = delete;
+            AsyncFile(AsyncFile &&) = delete;
+            AsyncFile &operator=(const AsyncFile &) = delete;
+            AsyncFile &operator=(AsyncFile &&) = delete;
+
+            /**
+             * @brief Opens the file at filePath with openFlags.
+             *
+             * @param filePath Path to file.
+             * @param openFlags Flags from Ctrulib to use to open the file with.
+             * @param fileSize Optional. Creates the file with a starting size defined.
+             * @param onComplete Optional. Called from the worker thread once the file is opened.
+             * @return Future for whether or not the file was opened.
+             */
+            std::future<fslib::async::Completion<bool>> open(const fslib::Path &filePath,
+                                                             uint32_t openFlags,
+                                                             uint64_t fileSize = 0,
+                                                             fslib::async::CompletionFunction<bool> onComplete = {});
+
+            /// @brief Reads up to bufferSize bytes from the current offset into buffer.
+            /// @param buffer Buffer to read into.
+            /// @param bufferSize Size of the buffer.
+            /// @param onComplete Optional. Called from the worker thread once the read is done.
+            /// @return Future for the number of bytes read. -1 on failure.
+            std::future<fslib::async::Completion<ssize_t>> read(void *buffer,
+                                                                size_t bufferSize,
+                                                                fslib::async::CompletionFunction<ssize_t> onComplete = {});
+
+            /**
+             * @brief Reads up to bufferSize bytes from offset into buffer without moving the current offset.
+             *
+             * @param offset Offset to read from.
+             * @param buffer Buffer to read into.
+             * @param bufferSize Size of the buffer.
+             * @param onComplete Optional. Called from the worker thread once the read is done.
+             * @return Future for the number of bytes read. -1 on failure.
+             */
+            std::future<fslib::async::Completion<ssize_t>> readAt(int64_t offset,
+                                                                  void *buffer,
+                                                                  size_t bufferSize,
+                                                                  fslib::async::CompletionFunction<ssize_t> onComplete = {});
+
+            /// @brief Writes bufferSize bytes from buffer at the current offset.
+            /// @param buffer Data to write.
+            /// @param bufferSize Size of the data.
+            /// @param onComplete Optional. Called from the worker thread once the write is done.
+            /// @return Future for the number of bytes written. -1 on failure.
+            std::future<fslib::async::Completion<ssize_t>> write(const void *buffer,
+                                                                 size_t bufferSize,
+                                                                 fslib::async::CompletionFunction<ssize_t> onComplete = {});
+
+            /**
+             * @brief Writes bufferSize bytes from buffer at offset without moving the current offset.
+             *
+             * @param offset Offset to write to.
+             * @param buffer Data to write.
+             * @param bufferSize Size of the data.
+             * @param onComplete Optional. Called from the worker thread once the write is done.
+             * @return Future for the number of bytes written. -1 on failure.
+             */
+            std::future<fslib::async::Completion<ssize_t>> writeAt(int64_t offset,
+                                                                   const void *buffer,
+                                                                   size_t bufferSize,
+                                                                   fslib::async::CompletionFunction<ssize_t> onComplete = {});
+
+            /// @brief Flushes the file.
+            /// @param onComplete Optional. Called from the worker thread once the file is flushed.
+            /// @return Future for whether or not the flush succeeded.
+            std::future<fslib::async::Completion<bool>> flush(fslib::async::CompletionFunction<bool> onComplete = {});
+
+            /// @brief Closes the file.
+            /// @param onComplete Optional. Called from the worker thread once the file is closed.
+            /// @return Future that's ready once the file is closed.
+            std::future<fslib::async::Completion<bool>> close(fslib::async::CompletionFunction<bool> onComplete = {});
+
+            /// @brief Waits for every request already made on the file to finish.
+            void wait(void);
+
+            /// @brief Waits for every request already made on the file to finish and returns whether or not it's open.
+            /// @return True if the file is open. False if it isn't.
+            bool isOpen(void);
+
+        private:
+            /// @brief Underlying file. This is only touched from the worker running the file's current request.
+            fslib::File m_file;
+
+            /// @brief Strand the file's requests run on.
+            std::shared_ptr<fslib::async::Strand> m_strand;
+    };
+} // namespace fslib
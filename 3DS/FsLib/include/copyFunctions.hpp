@@ -0,0 +1,96 @@
+#pragma once
+#include "hash.hpp"
+#include "path.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+namespace fslib
+{
+    /// @brief Function used to report copy progress. The first argument is the number of bytes written so far, the second is the
+    /// total number of bytes being copied.
+    using CopyProgressFunction = std::function<void(int64_t, int64_t)>;
+
+    /// @brief Options for copyFile.
+    struct CopyOptions
+    {
+            /// @brief Size of each buffer in the ring.
+            size_t bufferSize = 0x40000;
+
+            /// @brief Number of buffers in the ring. At least two are needed for reading and writing to overlap.
+            size_t bufferCount = 4;
+
+            /// @brief Optional. Called from the thread copyFile was called from after every write.
+            fslib::CopyProgressFunction progress;
+
+            /// @brief Optional. Hasher the data is fed to as it's read. This is done on the reading thread, so it overlaps with writing.
+            /// @note This is ignored by copyDirectoryRecursively since it copies files in parallel.
+            fslib::Hasher *hasher = nullptr;
+    };
+
+    /// @brief Options for copyDirectoryRecursively.
+    struct DirectoryCopyOptions
+    {
+            /// @brief Number of files copied at the same time.
+            size_t workerCount = 4;
+
+            /// @brief Maximum number of handles open at once. Every file being copied needs two and one is used to read directories, so
+            /// this also limits workerCount.
+            size_t maxOpenHandles = 9;
+
+            /// @brief Options used to copy each file. Each worker copies through one buffer of bufferSize, so bufferCount isn't used. If
+            /// set, the progress function is called from the worker threads.
+            fslib::CopyOptions fileOptions;
+    };
+
+    /// @brief Statistics for copyDirectoryRecursively. All times are in nanoseconds.
+    struct CopyStats
+    {
+            /// @brief Number of files copied.
+            int64_t fileCount = 0;
+
+            /// @brief Number of directories copied.
+            int64_t directoryCount = 0;
+
+            /// @brief Total number of bytes copied.
+            int64_t bytesCopied = 0;
+
+            /// @brief Time spent reading the source tree and creating directories.
+            uint64_t scanTime = 0;
+
+            /// @brief Time from the first file being queued to the last one finishing.
+            uint64_t copyTime = 0;
+
+            /// @brief Total time the copy took.
+            uint64_t totalTime = 0;
+    };
+
+    /**
+     * @brief Attempts to copy source to destination.
+     * @param source Path of the file to copy.
+     * @param destination Path to copy the file to. If it already exists, it's replaced.
+     * @param options Optional. Options for the copy.
+     * @return True on success. False on failure.
+     * @note Reading is done on a second thread into a ring of buffers while the calling thread writes them out, so reading from one
+     * device and writing to another overlap instead of waiting on each other. The destination is created at the source's size
+     * before anything is written, so it never needs to be resized and Extra Data destinations work without any extra steps. Data
+     * copied to save archives still needs to be committed afterwards.
+     */
+    bool copyFile(const fslib::Path &source, const fslib::Path &destination, const fslib::CopyOptions &options = {});
+
+    /**
+     * @brief Attempts to copy the directory source and everything in it to destination.
+     * @param source Path of the directory to copy.
+     * @param destination Path to copy the directory to. It's created if it doesn't exist.
+     * @param options Optional. Options for the copy.
+     * @param statsOut Optional. Pointer to write statistics for the copy to.
+     * @return True on success. False if anything failed to copy.
+     * @note The source tree is read on the calling thread. Each directory is created before its files are queued, and a pool of worker
+     * threads copies the queued files while the rest of the tree is still being read. This keeps several small files in flight at
+     * once instead of waiting on each one. Copying stops at the first failure.
+     */
+    bool copyDirectoryRecursively(const fslib::Path &source,
+                                  const fslib::Path &destination,
+                                  const fslib::DirectoryCopyOptions &options = {},
+                                  fslib::CopyStats *statsOut = nullptr);
+} // namespace fslib
@@ -31,6 +31,11 @@ namespace fslib
             /// @return Number of entries read from directory.
             uint32_t getCount(void) const;
 
+            /// @brief Returns the size of the entry at Index.
+            /// @param index Index of entry.
+            /// @return Size of entry. 0 if Index is out of bounds.
+            uint64_t getEntrySize(int index) const;
+
             /// @brief Returns whether or not the entry at Index in directory listing is a directory or not.
             /// @param index Index of entry to check.
             /// @return True if the entry is a directory. False if not or Index is out of bounds.
@@ -46,15 +51,55 @@ namespace fslib
             /// @return Name of entry. If out of bounds, nullptr.
             const char16_t *operator[](int index) const;
 
+            /**
+             * @brief Sorts the listing.
+             *
+             * @param sortOrder Order to sort by. Can be one of the following:
+             *      1. Directory::sortName. Alphabetically, ignoring case.
+             *      2. Directory::sortNatural. Alphabetically ignoring case, but runs of digits are compared by value so 2 comes before 10.
+             *      3. Directory::sortSize. By entry size.
+             *      4. Directory::sortTimestamp. By last modified time. This needs one request per entry and only works on archives that
+             *         support it, like SDMC.
+             * @param directoriesFirst Optional. Whether or not directories are kept before files. This is the default.
+             * @param descending Optional. Whether or not to sort largest/last first.
+             * @return True on success. False on failure.
+             * @note Each entry's collation key is only built once per sort. Entries that tie are ordered by name.
+             */
+            bool sort(uint8_t sortOrder, bool directoriesFirst = true, bool descending = false);
+
+            /// @brief Sorts alphabetically, ignoring case.
+            static constexpr uint8_t sortName = 0;
+            /// @brief Sorts alphabetically ignoring case, with numbers compared by value.
+            static constexpr uint8_t sortNatural = 1;
+            /// @brief Sorts by entry size.
+            static constexpr uint8_t sortSize = 2;
+            /// @brief Sorts by last modified time.
+            static constexpr uint8_t sortTimestamp = 3;
+
         private:
             /// @brief DirectoryHandle.
             Handle m_directoryHandle;
 
+            /// @brief Path of the directory. This is needed to fetch timestamps when sorting.
+            fslib::Path m_directoryPath;
+
             /// @brief Whether or not Directory::Open was successful.
             bool m_wasOpened = false;
 
-            /// @brief Vector of 3DS FS_DirectoryEntry's. 3DS has no way of retrieving a count first or this wouldn't be a vector.
-            std::vector<FS_DirectoryEntry> m_directoryList;
+            /// @brief Every entry's name packed back to back. Each name is NUL terminated so it can be returned directly.
+            std::vector<char16_t> m_nameArena;
+
+            /// @brief Offset of each entry's name in the arena.
+            std::vector<uint32_t> m_nameOffsets;
+
+            /// @brief Length of each entry's name, not counting the NUL terminator.
+            std::vector<uint16_t> m_nameLengths;
+
+            /// @brief Size of each entry.
+            std::vector<uint64_t> m_entrySizes;
+
+            /// @brief Whether or not each entry is a directory.
+            std::vector<uint8_t> m_entryIsDirectory;
 
             /// @brief Closes directory handle. The directory is read in its entirety when open is called. Public access is not needed.
             /// @return
@@ -1,9 +1,14 @@
 #pragma once
 #include "path.hpp"
+#include <functional>
+#include <string_view>
 
 namespace fslib
 {
-    /// @brief Attempts to open directory at Directory path to see if it exists and is a directory.
+    /// @brief Function called with the number of entries deleted so far by deleteDirectoryRecursively's fallback.
+    using DeleteProgressFunction = std::function<void(int64_t)>;
+
+    /// @brief Checks to see if the directory at DirectoryPath exists and is a directory.
     /// @param directoryPath Path to test.
     /// @return True if the directory exists and can be opened. False if it does not.
     bool directoryExists(const fslib::Path &directoryPath);
@@ -13,10 +18,26 @@ namespace fslib
     /// @return True on success. False on failure.
     bool createDirectory(const fslib::Path &directoryPath);
 
-    /// @brief Attempts to create every directory in Directory path. Does not need a trailing slash. Warning: This is a bit slow.
-    /// @return True on success. False on failure.
+    /**
+     * @brief Attempts to create every directory in Directory path. Does not need a trailing slash.
+     *
+     * @param directoryPath Path of directories.
+     * @return True on success. False on failure.
+     * @note This works backwards from the end of the path until it finds a directory that exists, then only creates what's missing
+     * after it. A few directories known to exist are remembered per device so creating lots of directories next to each other doesn't
+     * check the same parents over and over.
+     */
     bool createDirectoriesRecursively(const fslib::Path &directoryPath);
 
+    /**
+     * @brief Forgets the directories createDirectoriesRecursively remembers as existing on DeviceName.
+     *
+     * @param deviceName Name of the device.
+     * @note FsLib already does this when deleting or renaming directories and closing devices. This only needs to be called if
+     * directories are removed some other way.
+     */
+    void forgetKnownDirectories(std::u16string_view deviceName);
+
     /// @brief Attempts to rename directory from OldPath to NewPath. Both must be on the same device.
     /// @param oldPath Original name of target directory.
     /// @param newPath New name of target directory.
@@ -28,8 +49,14 @@ namespace fslib
     /// @return True on success. False on failure.
     bool deleteDirectory(const fslib::Path &directoryPath);
 
-    /// @brief Attempts to recursively delete DirectoryPath
-    /// @param directoryPath Path to the directory to delete.
-    /// @return True on success. False on failure.
-    bool deleteDirectoryRecursively(const fslib::Path &directoryPath);
+    /**
+     * @brief Attempts to recursively delete DirectoryPath
+     *
+     * @param directoryPath Path to the directory to delete. If this is the root of a device, everything in it is deleted instead.
+     * @param progress Optional. Called after each entry is deleted when the fallback is used.
+     * @return True on success. False on failure.
+     * @note FS is asked to delete the whole tree in one request first. If the archive rejects that, or DirectoryPath is the root, the
+     * tree is walked and each entry is deleted one at a time instead. Progress is only reported in that case.
+     */
+    bool deleteDirectoryRecursively(const fslib::Path &directoryPath, const fslib::DeleteProgressFunction &progress = {});
 } // namespace fslib
@@ -0,0 +1,113 @@
+#pragma once
+#include "path.hpp"
+#include <3ds.h>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace fslib
+{
+    /// @brief What FsLib was doing when the last error on a thread was recorded.
+    enum class Operation : uint8_t
+    {
+        None,
+        Initialize,
+        MapDevice,
+        FindDevice,
+        CommitDevice,
+        CloseDevice,
+        OpenArchive,
+        DeleteExtData,
+        GetSecureValue,
+        SetSecureValue,
+        OpenFile,
+        ReadFile,
+        WriteFile,
+        FlushFile,
+        ResizeFile,
+        GetFileSize,
+        SetBufferSize,
+        CreateFile,
+        DeleteFile,
+        RenameFile,
+        GetEntryInfo,
+        OpenDirectory,
+        ReadDirectory,
+        CloseDirectory,
+        CreateDirectory,
+        DeleteDirectory,
+        RenameDirectory,
+        Copy,
+        Walk
+    };
+
+    /// @brief Returns the Result of the last error on the calling thread.
+    /// @return Result. 0 if the last error didn't come from FS.
+    Result getLastResult(void);
+
+    /// @brief Returns what FsLib was doing when the last error on the calling thread was recorded.
+    /// @return Operation. Operation::None if no errors have been recorded on the thread.
+    fslib::Operation getLastOperation(void);
+
+    /// @brief Contains the functions FsLib uses internally to record errors.
+    /// @note Errors are recorded per thread and only turned into a string when getErrorString is called.
+    namespace error
+    {
+        /**
+         * @brief Records that operation failed with result.
+         *
+         * @param operation Operation that failed.
+         * @param result Result returned by FS.
+         * @param path Optional. Path or device the operation was on.
+         */
+        void setResult(fslib::Operation operation, Result result, std::u16string_view path = {});
+
+        /// @brief Records that operation failed with result.
+        /// @param operation Operation that failed.
+        /// @param result Result returned by FS.
+        /// @param path Path the operation was on.
+        void setResult(fslib::Operation operation, Result result, const fslib::Path &path);
+
+        /**
+         * @brief Records that operation failed for a reason other than an FS error.
+         *
+         * @param operation Operation that failed.
+         * @param reason Why it failed. This is stored as is, so it needs to be a string literal.
+         * @param path Optional. Path or device the operation was on.
+         */
+        void setReason(fslib::Operation operation, const char *reason, std::u16string_view path = {});
+
+        /// @brief Records that operation failed for a reason other than an FS error.
+        /// @param operation Operation that failed.
+        /// @param reason Why it failed. This is stored as is, so it needs to be a string literal.
+        /// @param path Path the operation was on.
+        void setReason(fslib::Operation operation, const char *reason, const fslib::Path &path);
+
+        /// @brief Clears the calling thread's error so errors recorded afterwards can be told apart from older ones.
+        void clear(void);
+
+        /// @brief Copy of a thread's error. Worker threads use this to hand their error back to the thread that started them.
+        struct Record
+        {
+                /// @brief Result returned by FS. 0 if the error didn't come from FS.
+                Result result = 0;
+
+                /// @brief Operation that failed.
+                fslib::Operation operation = fslib::Operation::None;
+
+                /// @brief Why it failed if it wasn't an FS error. Always a string literal or nullptr.
+                const char *reason = nullptr;
+
+                /// @brief Path or device the operation was on.
+                std::u16string path;
+        };
+
+        /// @brief Returns a copy of the calling thread's error.
+        /// @return Copy of the error.
+        fslib::error::Record capture(void);
+
+        /// @brief Records record on the calling thread as if the error had happened there.
+        /// @param record Error to record.
+        void restore(const fslib::error::Record &record);
+    } // namespace error
+} // namespace fslib
@@ -1,13 +1,37 @@
 #pragma once
+#include "hash.hpp"
 #include "path.hpp"
 #include <3ds.h>
 #include <cstdint>
+#include <memory>
+#include <mutex>
+#include <span>
 
 // This is to make this easier.
 static constexpr uint32_t FS_OPEN_APPEND = BIT(3);
 
 namespace fslib
 {
+    /// @brief Buffer used for vectored reads.
+    struct ReadVector
+    {
+            /// @brief Buffer to read into.
+            void *buffer;
+
+            /// @brief Size of Buffer.
+            size_t bufferSize;
+    };
+
+    /// @brief Buffer used for vectored writes.
+    struct WriteVector
+    {
+            /// @brief Buffer to write from.
+            const void *buffer;
+
+            /// @brief Size of Buffer.
+            size_t bufferSize;
+    };
+
     /// @brief Class for reading and writing to files.
     class File
     {
@@ -53,7 +77,7 @@ namespace fslib
             /// @return True if the end is reached. False if not.
             bool endOfFile(void) const;
 
-            /// @brief Seeks to a position in file. Offsets are bounds checked.
+            /// @brief Seeks to a position in file. Offsets are bounds checked. Any buffered writes are flushed first.
             /// @param offset Offset to seek to.
             /// @param origin Position to seek from.
             void seek(int64_t Offset, uint8_t Origin);
@@ -79,12 +103,43 @@ namespace fslib
             /// @return Byte read on success. -1 on failure.
             signed char getByte(void);
 
+            /**
+             * @brief Attempts to read from the file at offset without using or changing the file's current offset.
+             * @param offset Offset in the file to read from.
+             * @param buffer Buffer to read into.
+             * @param bufferSize Size of Buffer.
+             * @return Number of bytes read. -1 on error.
+             * @note Calls to readAt and writeAt on the same File can run on multiple threads at once. Nothing else can run on the File
+             * at the same time, including read, write, seek, flush, and close, since those change the file's size and buffers without
+             * synchronizing. The read and write buffers aren't used, so anything still waiting in the write buffer won't be seen until
+             * it's flushed.
+             */
+            ssize_t readAt(int64_t offset, void *buffer, size_t bufferSize);
+
+            /**
+             * @brief Reads from the file into each buffer in vectors in order, starting at the current offset.
+             * @param vectors Buffers to read into.
+             * @return Total number of bytes read. -1 on error.
+             * @note If everything combined is small enough, it's read with one request and split up afterwards. Otherwise, each buffer
+             * is read directly.
+             */
+            ssize_t readv(std::span<const fslib::ReadVector> vectors);
+
             /// @brief Attempts to write Buffer to File. File is automatically resized to fit Buffer if needed.
             /// @param buffer Buffer to write to file.
             /// @param bufferSize Size of Buffer
             /// @return Number of bytes written on success. -1 on complete failure.
             ssize_t write(const void *buffer, size_t bufferSize);
 
+            /**
+             * @brief Writes each buffer in vectors to the file in order, starting at the current offset.
+             * @param vectors Buffers to write.
+             * @return Total number of bytes written. -1 on error.
+             * @note The file is only resized once to fit everything. If everything combined is small enough, it's merged and written
+             * with one request. Otherwise, each buffer is written directly.
+             */
+            ssize_t writev(std::span<const fslib::WriteVector> vectors);
+
             /// @brief Attempts to write a formatted string to file.
             /// @param format Format of string.
             /// @param arguments
@@ -102,10 +157,71 @@ namespace fslib
             /// @return True on success. False on failure.
             bool putByte(char byte);
 
-            /// @brief Flushes the file.
+            /**
+             * @brief Attempts to write to the file at offset without using or changing the file's current offset. The file is grown to
+             * fit if needed.
+             * @param offset Offset in the file to write to.
+             * @param buffer Buffer to write.
+             * @param bufferSize Size of Buffer.
+             * @return Number of bytes written. -1 on error.
+             * @note Calls to readAt and writeAt on the same File can run on multiple threads at once. Nothing else can run on the File
+             * at the same time, including read, write, seek, flush, and close. Only growing the file takes a lock. The write buffer isn't
+             * used.
+             */
+            ssize_t writeAt(int64_t offset, const void *buffer, size_t bufferSize);
+
+            /// @brief Writes out anything still in the write buffer, trims the file to its real size, and flushes it.
             /// @return True on success. False on failure.
             bool flush(void);
 
+            /**
+             * @brief Enables or disables buffered reading for the file.
+             * @param bufferSize Size of the read buffer. Passing 0 disables buffering and frees the buffer.
+             * @return True on success. False if the buffer couldn't be allocated.
+             * @note When enabled, getByte, readLine, and reads smaller than the buffer are served from memory instead of going to FS
+             * for every call. The buffer is kept if the file is closed and reopened.
+             */
+            bool setReadBufferSize(size_t bufferSize);
+
+            /**
+             * @brief Enables or disables write buffering for the file.
+             * @param bufferSize Size of the write buffer. Passing 0 writes out anything pending, disables buffering, and frees the buffer.
+             * @return True on success. False if pending data couldn't be written or the buffer couldn't be allocated.
+             * @note When enabled, writes smaller than the buffer are merged in memory and written to the file in one go when the buffer
+             * fills up, or flush, seek, or close are called. The file is only resized once per flush instead of once per write.
+             */
+            bool setWriteBufferSize(size_t bufferSize);
+
+            /**
+             * @brief Sets how the file grows when a write goes past the end of it.
+             * @param growthMode How to grow the file. Can be one of the following:
+             *      1. File::growExact. The file is resized to exactly what's needed every time.
+             *      2. File::growDouble. The file's size is doubled. This is the default.
+             *      3. File::growFixed. The file grows in extents of ExtentSize.
+             * @param extentSize Optional. Size of the extents used by File::growFixed.
+             * @param maxGrowth Optional. The most the file is allowed to grow at once. 0 means no limit.
+             * @note Any space allocated past what was actually written is trimmed off when the file is flushed or closed. If growing
+             * past what's needed fails, FsLib falls back to the exact size needed. Extra Data files can't be resized, so this has no
+             * effect on them.
+             */
+            void setGrowthPolicy(uint8_t growthMode, int64_t extentSize = 0x100000, int64_t maxGrowth = 0x1000000);
+
+            /**
+             * @brief Attaches a hasher to the file. Everything read through read, readv, readLine, and getByte is fed to it as it's
+             * read.
+             * @param hasher Hasher to attach. Passing nullptr detaches the current one.
+             * @note Positional reads aren't hashed since they don't move through the file in order. The hasher isn't owned by the file and
+             * needs to outlive it or be detached.
+             */
+            void setHasher(fslib::Hasher *hasher);
+
+            /// @brief Grows the file to exactly the size needed to fit the write.
+            static constexpr uint8_t growExact = 0;
+            /// @brief Doubles the file's size until the write fits.
+            static constexpr uint8_t growDouble = 1;
+            /// @brief Grows the file in fixed size extents.
+            static constexpr uint8_t growFixed = 2;
+
             /// @brief Used to seek from the beginning of the file.
             static constexpr uint8_t beginning = 0;
             /// @brief Used to seek from the current offset of the file.
@@ -126,13 +242,98 @@ namespace fslib
             /// @brief Store the current offset in the file and the size of the file.
             int64_t m_offset, m_fileSize;
 
+            /// @brief Optional read buffer.
+            std::unique_ptr<unsigned char[]> m_readBuffer;
+
+            /// @brief Size of the read buffer.
+            size_t m_readBufferSize = 0;
+
+            /// @brief Offset in the file the read buffer's data begins at.
+            int64_t m_readBufferOffset = 0;
+
+            /// @brief Number of valid bytes in the read buffer.
+            size_t m_readBufferLength = 0;
+
+            /// @brief Optional write buffer.
+            std::unique_ptr<unsigned char[]> m_writeBuffer;
+
+            /// @brief Size of the write buffer.
+            size_t m_writeBufferSize = 0;
+
+            /// @brief Offset in the file the data in the write buffer is written to.
+            int64_t m_writeBufferOffset = 0;
+
+            /// @brief Number of bytes waiting in the write buffer.
+            size_t m_writeBufferLength = 0;
+
+            /// @brief Actual size of the file on the device. m_fileSize can run ahead of this while writes are buffered and fall behind
+            /// it when the file has been grown ahead of time.
+            int64_t m_allocatedSize = 0;
+
+            /// @brief How the file grows when writing past the end.
+            uint8_t m_growthMode = File::growDouble;
+
+            /// @brief Extent size for File::growFixed.
+            int64_t m_extentSize = 0x100000;
+
+            /// @brief Maximum the file can grow at once. 0 is unlimited.
+            int64_t m_maxGrowth = 0x1000000;
+
+            /// @brief Only held while writeAt is growing the file.
+            std::mutex m_resizeLock;
+
+            /// @brief Optional hasher data read is fed to.
+            fslib::Hasher *m_hasher = nullptr;
+
+            /// @brief Feeds data to the hasher if one is attached.
+            /// @param data Data to hash.
+            /// @param dataSize Size of data.
+            inline void hashData(const void *data, size_t dataSize)
+            {
+                if (m_hasher && dataSize > 0)
+                {
+                    m_hasher->update(data, dataSize);
+                }
+            }
+
             /// @brief Private: Corrects if offset is out of bounds. Ex: m_Offset < 0 or m_Offset > m_FileSize
             void ensureOffsetIsValid(void);
 
-            /// @brief Attempts to resize a file if the buffer size is too large to fit in the remaining space.
-            /// @param BufferSize Size of buffer to check.
+            /// @brief Fills the read buffer starting at the current offset.
+            /// @return True if anything was read. False on failure or end of file.
+            bool fillReadBuffer(void);
+
+            /// @brief Copies as much as possible from the read buffer at the current offset to Buffer.
+            /// @param buffer Buffer to copy to.
+            /// @param bufferSize Size of Buffer.
+            /// @return Number of bytes copied.
+            size_t readFromBuffer(void *buffer, size_t bufferSize);
+
+            /// @brief Returns whether the current offset falls within the read buffer's data.
+            /// @return True if it does. False if it doesn't.
+            inline bool offsetIsBuffered(void) const
+            {
+                return m_offset >= m_readBufferOffset && m_offset < m_readBufferOffset + static_cast<int64_t>(m_readBufferLength);
+            }
+
+            /// @brief Writes anything waiting in the write buffer to the file.
+            /// @return True on success or nothing to write. False on failure.
+            bool flushWriteBuffer(void);
+
+            /// @brief Attempts to resize a file if the buffer size is too large to fit in the space remaining after Offset.
+            /// @param offset Offset the buffer is going to be written to.
+            /// @param bufferSize Size of buffer to check.
             /// @return True on success. False on failure.
-            bool resizeIfNeeded(size_t bufferSize);
+            bool resizeIfNeeded(int64_t offset, size_t bufferSize);
+
+            /// @brief Calculates the size to grow the file to according to the growth policy.
+            /// @param requiredSize Minimum size the file needs to be.
+            /// @return Size to allocate.
+            int64_t getGrowthSize(int64_t requiredSize) const;
+
+            /// @brief Trims anything allocated past the file's real size.
+            /// @return True on success or nothing to trim. False on failure.
+            bool trimToSize(void);
 
             /// @brief Returns whether or not the file is open for reading by checking m_Flags.
             /// @return True if it is. False if it isn't.
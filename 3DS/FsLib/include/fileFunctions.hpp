@@ -1,15 +1,38 @@
 #pragma once
 #include "path.hpp"
+#include <3ds.h>
 
 namespace fslib
 {
+    /// @brief Flag for getEntryInfo to fetch the size of files.
+    static constexpr uint8_t ENTRY_INFO_SIZE = BIT(0);
+
+    /// @brief Flag for getEntryInfo to fetch the timestamp.
+    static constexpr uint8_t ENTRY_INFO_TIMESTAMPS = BIT(1);
+
+    /// @brief Information about a file or directory returned by getEntryInfo.
+    struct EntryInfo
+    {
+            /// @brief Whether or not the entry is a directory.
+            bool isDirectory = false;
+
+            /// @brief Size of the entry. Always 0 for directories or when the size wasn't requested.
+            uint64_t size = 0;
+
+            /// @brief Whether or not the timestamp below was read. Only some archives, like SDMC, support it.
+            bool hasTimestamps = false;
+
+            /// @brief Last modification time as reported by the archive.
+            uint64_t modified = 0;
+    };
+
     /// @brief This is a shortcut function to create an empty file.
     /// @param filePath Path to file to create.
     /// @param fileSize Optional. Starting size of file.
     /// @return True on success. False on failure.
     bool createFile(const fslib::Path &filePath, uint64_t fileSize = 0);
 
-    /// @brief Attempts to open FilePath for reading to check if it exists.
+    /// @brief Checks to see if FilePath exists and is a file.
     /// @param filePath Path to file to check.
     /// @return True if file exists. False if it doesn't.
     bool fileExists(const fslib::Path &filePath);
@@ -20,6 +43,19 @@ namespace fslib
     /// @return True on success. False on failure.
     bool getFileSize(const fslib::Path &filePath, uint64_t &fileSizeOut);
 
+    /**
+     * @brief Gets the type, size, and timestamp of the entry at EntryPath.
+     *
+     * @param entryPath Path of the entry.
+     * @param infoOut Set to the entry's information on success.
+     * @param infoFlags Optional. Which extra information to fetch. The type is always fetched.
+     * @return True on success. False if the entry doesn't exist or on error.
+     * @note 3DS has no way to ask for an entry's type directly, so the entry is opened as a file, then as a directory if that fails. A
+     * file's size is read while it's open. The timestamp is one more request. fileExists and directoryExists only need to know about
+     * one type, so they open the entry once instead of going through this.
+     */
+    bool getEntryInfo(const fslib::Path &entryPath, fslib::EntryInfo &infoOut, uint8_t infoFlags = ENTRY_INFO_SIZE | ENTRY_INFO_TIMESTAMPS);
+
     /// @brief Attempts to rename file from OldPath to NewPath. Both must exist on the same device.
     /// @param oldPath Original path to target file.
     /// @param newPath New path of target file.
@@ -1,18 +1,30 @@
 #pragma once
+#include "async.hpp"
+#include "asyncFile.hpp"
+#include "copyFunctions.hpp"
 #include "dev.hpp"
 #include "directory.hpp"
 #include "directoryFunctions.hpp"
+#include "directoryIterator.hpp"
+#include "error.hpp"
 #include "extData.hpp"
 #include "file.hpp"
 #include "fileFunctions.hpp"
 #include "path.hpp"
+#include "pathBuilder.hpp"
+#include "pathLiteral.hpp"
+#include "pathView.hpp"
 #include "saveDataArchive.hpp"
 #include "secureValue.hpp"
+#include "walk.hpp"
 #include <3ds.h>
 #include <string>
 
 namespace fslib
 {
+    /// @brief Device ID that is never given to a device.
+    static constexpr uint32_t INVALID_DEVICE_ID = 0;
+
     /// @brief Opens and mounts SD card to u"sdmc:/"
     /// @return True on success. False on failure.
     bool initialize(void);
@@ -20,26 +32,46 @@ namespace fslib
     /// @brief Exits and closes all open handles.
     void exit(void);
 
-    /// @brief Returns internal error string with slightly more information than just a bool can provide.
-    /// @return Error string.
+    /**
+     * @brief Returns a string describing the last error on the calling thread. This has slightly more information than just a bool.
+     *
+     * @return Error string. This stays valid until getErrorString is called again on the same thread.
+     * @note Errors are recorded per thread as the Result, operation, and path. The string is only built when this is called.
+     */
     const char *getErrorString(void);
 
     /// @brief Adds Archive to devices.
     /// @param deviceName Name of the device. Ex: u"sdmc".
     /// @param archive Archive to map.
     /// @return True on success. False on failure.
+    /// @note Device names can be up to 16 characters long. Replacing a device has the same restriction as closeDevice.
     bool mapArchiveToDevice(std::u16string_view deviceName, FS_Archive archive);
 
+    /// @brief Returns the ID of the device mapped to deviceName.
+    /// @param deviceName Name of the device. Ex: u"sdmc".
+    /// @return Device ID. INVALID_DEVICE_ID if nothing is mapped to deviceName.
+    /// @note IDs stay valid until the device is closed or remapped and are never reused right away. Functions taking an ID fail instead
+    /// of reaching whatever was mapped to the name afterwards.
+    uint32_t getDeviceID(std::u16string_view deviceName);
+
     /// @brief Attempts to retrieve the archive mapped to DeviceName.
     /// @param deviceName Name of the archive to retrieve. Ex: u"sdmc"
     /// @param archiveOut Pointer to Archive to write to.
     /// @return True if the archive is found. False if it is not.
     bool getArchiveByDeviceName(std::u16string_view deviceName, FS_Archive *archiveOut);
 
+    /// @brief Attempts to retrieve the archive mapped to deviceID.
+    /// @param deviceID ID of the device.
+    /// @param archiveOut Pointer to Archive to write to.
+    /// @return True if the device is still mapped. False if it is not.
+    bool getArchiveByDeviceID(uint32_t deviceID, FS_Archive *archiveOut);
+
     /// @brief Processes and returns if the path is valid and the archive exists and is open.
     /// @param path Path to process.
     /// @param archiveOut FS_Archive retrieved from map.
     /// @return True on success. False on failure.
+    /// @note The ID of the device is cached in path. Later calls with the same path skip searching for the device until it's closed or
+    /// remapped.
     bool processDeviceAndPath(const fslib::Path &path, FS_Archive *archiveOut);
 
     /// @brief Performs control on DeviceName AKA commits data to it. This is not required for Extra Data types or SDMC.
@@ -47,8 +79,23 @@ namespace fslib
     /// @return True on success. False on failure.
     bool controlDevice(std::u16string_view deviceName);
 
-    /// @brief Closes the archive mapped to DeviceName.
-    /// @param deviceName Name of the device to close.
+    /// @brief Performs control on the device with deviceID.
+    /// @param deviceID ID of the device to control.
     /// @return True on success. False on failure.
+    bool controlDevice(uint32_t deviceID);
+
+    /**
+     * @brief Closes the archive mapped to DeviceName.
+     *
+     * @param deviceName Name of the device to close.
+     * @return True on success. False on failure.
+     * @note Only finding a device is safe to race with closing or remapping it. The archive handle a lookup returns isn't protected
+     * once it's handed out, so nothing can still be using the device on another thread when it's closed or remapped.
+     */
     bool closeDevice(std::u16string_view deviceName);
+
+    /// @brief Closes the archive with deviceID.
+    /// @param deviceID ID of the device to close.
+    /// @return True on success. False on failure.
+    bool closeDevice(uint32_t deviceID);
 } // namespace fslib
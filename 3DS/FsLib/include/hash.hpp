@@ -0,0 +1,73 @@
+#pragma once
+#include <3ds.h>
+#include <cstddef>
+#include <cstdint>
+
+// Ctrulib doesn't have this like LibNX does.
+static constexpr size_t SHA256_HASH_SIZE = 0x20;
+
+namespace fslib
+{
+    /**
+     * @brief Class for calculating CRC32 and SHA-256 hashes of data as it's streamed.
+     * @note The 3DS's hashing hardware isn't available to normal applications, so this uses portable implementations. CRC32 is done
+     * eight bytes at a time with lookup tables generated at compile time. A Hasher isn't thread safe and should only be fed from one
+     * thread at a time.
+     */
+    class Hasher
+    {
+        public:
+            /// @brief Creates a new hasher.
+            /// @param hashTypes Optional. Which hashes to calculate. Can be Hasher::crc32, Hasher::sha256, or both OR'd together.
+            Hasher(uint8_t hashTypes = Hasher::crc32 | Hasher::sha256);
+
+            /// @brief Resets the hasher so it can be used for new data.
+            void reset(void);
+
+            /// @brief Feeds data to the hasher.
+            /// @param data Data to hash.
+            /// @param dataSize Size of Data.
+            void update(const void *data, size_t dataSize);
+
+            /// @brief Returns the CRC32 of everything fed to the hasher so far.
+            /// @return CRC32. 0 if CRC32 isn't being calculated.
+            uint32_t getCrc32(void) const;
+
+            /// @brief Gets the SHA-256 of everything fed to the hasher so far. The hasher can keep being fed after.
+            /// @param hashOut Buffer to write the hash to. This must be at least SHA256_HASH_SIZE bytes.
+            void getSha256(uint8_t *hashOut) const;
+
+            /// @brief Returns the number of bytes fed to the hasher.
+            /// @return Number of bytes hashed.
+            uint64_t getLength(void) const;
+
+            /// @brief Calculate CRC32.
+            static constexpr uint8_t crc32 = BIT(0);
+            /// @brief Calculate SHA-256.
+            static constexpr uint8_t sha256 = BIT(1);
+
+        private:
+            /// @brief Which hashes are being calculated.
+            uint8_t m_hashTypes = 0;
+
+            /// @brief Running CRC32.
+            uint32_t m_crc32 = 0;
+
+            /// @brief SHA-256 state.
+            uint32_t m_sha256State[8];
+
+            /// @brief Data waiting for a full 64 byte SHA-256 block.
+            uint8_t m_sha256Block[64];
+
+            /// @brief Number of bytes waiting in m_sha256Block.
+            size_t m_sha256BlockLength = 0;
+
+            /// @brief Number of bytes hashed.
+            uint64_t m_length = 0;
+
+            /// @brief Runs the SHA-256 compression function over one 64 byte block.
+            /// @param state State to update.
+            /// @param block Block to process.
+            static void sha256ProcessBlock(uint32_t *state, const uint8_t *block);
+    };
+} // namespace fslib
@@ -1,5 +1,6 @@
 #pragma once
 #include <3ds.h>
+#include <atomic>
 #include <cstdint>
 #include <memory>
 #include <string>
@@ -9,6 +10,9 @@ namespace fslib
     /// @brief The maximum path length FsLib on 3DS supports.
     static constexpr size_t MAX_PATH = 0x301;
 
+    // Forward declared to avoid a circular include.
+    class PathLiteral;
+
     /// @brief Class to make working with UTF-16 paths easier to manage.
     class Path
     {
@@ -20,6 +24,10 @@ namespace fslib
             /// @param path Path to assign from.
             Path(const Path &path);
 
+            /// @brief Creates a new path by taking the buffer from path if it has one.
+            /// @param path Path to move from. This is left empty.
+            Path(Path &&path) noexcept;
+
             /// @brief Creates a new path for use with FsLib
             /// @param pathData UTF-16 string to assign from.
             Path(const char16_t *P);
@@ -36,6 +44,10 @@ namespace fslib
             /// @param pathData UTF-16 string to assign from.
             Path(std::u16string_view P);
 
+            /// @brief Creates a new path from one checked at compile time without parsing it again.
+            /// @param literal PathLiteral to assign from.
+            Path(const fslib::PathLiteral &literal);
+
             /// @brief Frees path buffer.
             ~Path();
 
@@ -84,11 +96,24 @@ namespace fslib
             /// @return Length of path string.
             size_t getLength(void) const;
 
+            /// @brief Returns the device ID cached by FsLib's internal functions.
+            /// @return Cached device. 0 if nothing has been cached.
+            uint32_t getDeviceCache(void) const;
+
+            /// @brief Caches the device ID for FsLib's internal functions.
+            /// @param deviceCache Value to cache.
+            void setDeviceCache(uint32_t deviceCache) const;
+
             /// @brief Assigns Path from various standard UTF-16 string types.
             /// @param path Path to assign from
             /// @return Reference to current path.
             Path &operator=(const Path &path);
 
+            /// @brief Moves path into Path, taking its buffer if it has one.
+            /// @param path Path to move from. This is left empty.
+            /// @return Reference to current path.
+            Path &operator=(Path &&path) noexcept;
+
             /// @brief Assigns Path from various standard UTF-16 string types.
             /// @param pathData UTF-16 string to assign from
             /// @return Reference to current path.
@@ -109,6 +134,11 @@ namespace fslib
             /// @return Reference to current path.
             Path &operator=(std::u16string_view pathData);
 
+            /// @brief Assigns a path checked at compile time without parsing it again.
+            /// @param literal PathLiteral to assign from.
+            /// @return Reference to current path.
+            Path &operator=(const fslib::PathLiteral &literal);
+
             /// @brief Preferred appending operator. Adds / if needed between paths. Also trims slashes from input.
             /// @param pathData UTF-16 string to append.
             /// @return Reference to current Path
@@ -152,26 +182,59 @@ namespace fslib
             /// @brief This is the value that is returned when find[X]Of can't find the character.
             static constexpr uint16_t notFound = -1;
 
+            /// @brief Number of characters stored inside Path itself. Paths shorter than this don't allocate anything.
+            static constexpr size_t inlineSize = 0x40;
+
         private:
-            /// @brief Buffer 0x301 + Device length * sizeof(char16_t) bytes long containing path data.
-            char16_t *m_path = nullptr;
+            /// @brief These work on the buffer directly.
+            friend class PathBuilder;
+            friend class PathView;
 
-            /// @brief Pointer to where the end of the device in the path is located.
-            const char16_t *m_deviceEnd = nullptr;
+            /// @brief Buffer used for paths short enough to fit in it.
+            char16_t m_inlinePath[Path::inlineSize] = {0};
+
+            /// @brief Points to m_inlinePath or a heap buffer MAX_PATH + device length characters long for longer paths.
+            char16_t *m_path = m_inlinePath;
+
+            /// @brief Position of the ':' ending the device. Path::notFound if there isn't one.
+            uint16_t m_deviceEnd = Path::notFound;
 
             /// @brief Size of path buffer.
-            uint16_t m_pathSize = 0;
+            uint16_t m_pathSize = Path::inlineSize;
 
             /// @brief Current length of the path.
             uint16_t m_pathLength = 0;
 
-            /// @brief Allocates memory to hold path.
-            /// @param pathSize Size of buffer for path.
+            /// @brief ID of the device last resolved for this path. Atomic so a const Path can be shared between threads.
+            mutable std::atomic<uint32_t> m_deviceCache = 0;
+
+            /// @brief Assigns pathData to the path, trimming the slashes after the device.
+            /// @param pathData UTF-16 string to assign.
+            /// @param pathLength Length of pathData.
+            void assignPath(const char16_t *pathData, size_t pathLength);
+
+            /// @brief Copies a path that was already checked.
+            /// @param pathData UTF-16 string to assign.
+            /// @param pathLength Length of pathData.
+            /// @param deviceEnd Position of the ':' ending the device.
+            void assignCheckedPath(const char16_t *pathData, size_t pathLength, uint16_t deviceEnd);
+
+            /// @brief Appends pathData to the path. Adds / if needed and trims slashes from pathData.
+            /// @param pathData UTF-16 string to append.
+            /// @param pathLength Length of pathData.
+            void appendPath(const char16_t *pathData, size_t pathLength);
+
+            /// @brief Appends pathData to the path as is.
+            /// @param pathData UTF-16 string to append.
+            /// @param pathLength Length of pathData.
+            void concatenatePath(const char16_t *pathData, size_t pathLength);
+
+            /// @brief Makes sure the path buffer can hold pathSize characters, keeping what's already in it.
+            /// @param pathSize Number of characters needed.
             /// @return True on success. False on failure.
-            /// @note The path is a raw pointer to allocated memory so copies can be made.
-            bool allocatePath(uint16_t pathSize);
+            bool reservePath(size_t pathSize);
 
-            /// @brief Frees memory used for path buffer if it isn't nullptr.
+            /// @brief Frees the heap buffer if there is one and goes back to the inline buffer.
             void freePath(void);
     };
 
@@ -0,0 +1,128 @@
+#pragma once
+#include "path.hpp"
+#include <3ds.h>
+#include <cstdint>
+#include <string_view>
+
+namespace fslib
+{
+    /// @brief These are called when a path literal is rejected. They aren't constexpr, so the build stops with the reason in the
+    /// error.
+    namespace pathLiteralError
+    {
+        inline void missingDevice(void) {}
+        inline void missingRootSlash(void) {}
+        inline void forbiddenCharacter(void) {}
+        inline void doubleOrTrailingSlash(void) {}
+        inline void tooLong(void) {}
+    } // namespace pathLiteralError
+
+    /**
+     * @brief UTF-16 path checked and split at compile time. These are created with the _fsp literal. Ex: u"sdmc:/JKSM/config.json"_fsp
+     *
+     * @note Literals need to already be in the form Path would produce: a device, a single / after it, no doubled or trailing
+     * slashes, and no forbidden characters. Anything else fails to compile instead of being fixed up at runtime. Turning one into
+     * a Path is a copy with no parsing. Turning one into a PathView doesn't copy at all.
+     */
+    class PathLiteral
+    {
+        public:
+            /// @brief Checks and splits path. Only usable at compile time.
+            /// @param path UTF-16 string literal.
+            /// @param pathLength Length of the literal.
+            consteval PathLiteral(const char16_t *path, size_t pathLength) : m_path(path), m_pathLength(pathLength)
+            {
+                size_t deviceEnd = 0;
+                while (deviceEnd < pathLength && path[deviceEnd] != u':' && path[deviceEnd] != u'/')
+                {
+                    ++deviceEnd;
+                }
+
+                if (deviceEnd == 0 || deviceEnd == pathLength || path[deviceEnd] != u':')
+                {
+                    pathLiteralError::missingDevice();
+                }
+
+                if (deviceEnd + 1 == pathLength || path[deviceEnd + 1] != u'/')
+                {
+                    pathLiteralError::missingRootSlash();
+                }
+
+                if (pathLength - (deviceEnd + 1) >= fslib::MAX_PATH)
+                {
+                    pathLiteralError::tooLong();
+                }
+
+                for (size_t i = deviceEnd + 1; i < pathLength; i++)
+                {
+                    char16_t character = path[i];
+                    if (character == u'<' || character == u'>' || character == u':' || character == u'\\' || character == u'"' ||
+                        character == u'|' || character == u'?' || character == u'*')
+                    {
+                        pathLiteralError::forbiddenCharacter();
+                    }
+
+                    // The root is the only place a slash can end the path.
+                    bool isRoot = i == deviceEnd + 1;
+                    bool isLast = i + 1 == pathLength;
+                    if (character == u'/' && ((isLast && !isRoot) || (!isLast && path[i + 1] == u'/')))
+                    {
+                        pathLiteralError::doubleOrTrailingSlash();
+                    }
+                }
+                m_deviceEnd = deviceEnd;
+            }
+
+            /// @brief Returns the entire path as a C const char16_t* String
+            /// @return Pointer to path string.
+            constexpr const char16_t *cString(void) const
+            {
+                return m_path;
+            }
+
+            /// @brief Returns the device as a UTF-16 u16string_view.
+            /// @return Device string.
+            constexpr std::u16string_view getDevice(void) const
+            {
+                return std::u16string_view(m_path, m_deviceEnd);
+            }
+
+            /// @brief Returns an FS_Path for use with 3DS FS functions.
+            /// @return FS_Path
+            FS_Path getPath(void) const
+            {
+                size_t pathLength = m_pathLength - (m_deviceEnd + 1);
+                return {PATH_UTF16, (pathLength * sizeof(char16_t)) + sizeof(char16_t), &m_path[m_deviceEnd + 1]};
+            }
+
+            /// @brief Returns length of the entire path string.
+            /// @return Length of path string.
+            constexpr size_t getLength(void) const
+            {
+                return m_pathLength;
+            }
+
+        private:
+            /// @brief Literal the path points to. String literals live for the whole program.
+            const char16_t *m_path = nullptr;
+
+            /// @brief Position of the ':' ending the device.
+            uint16_t m_deviceEnd = 0;
+
+            /// @brief Length of the path.
+            uint16_t m_pathLength = 0;
+    };
+
+    /// @brief Literals are in their own namespace so they can be pulled in with using namespace fslib::literals.
+    inline namespace literals
+    {
+        /// @brief Creates a PathLiteral checked at compile time. Ex: u"sdmc:/JKSM/config.json"_fsp
+        /// @param path UTF-16 string literal.
+        /// @param pathLength Length of the literal.
+        /// @return PathLiteral.
+        consteval fslib::PathLiteral operator""_fsp(const char16_t *path, size_t pathLength)
+        {
+            return fslib::PathLiteral(path, pathLength);
+        }
+    } // namespace literals
+} // namespace fslib
@@ -0,0 +1,67 @@
+#pragma once
+#include <3ds.h>
+#include <cstdint>
+#include <string_view>
+
+namespace fslib
+{
+    // These need to be forward declared to avoid a circular include.
+    class Path;
+    class PathBuilder;
+    class PathLiteral;
+
+    /**
+     * @brief Non-owning view of a Path or PathBuilder's buffer.
+     *
+     * @note Creating one never copies or allocates. The view is only valid as long as what it was created from is alive and
+     * unchanged.
+     */
+    class PathView
+    {
+        public:
+            /// @brief Default constructor. The view is empty.
+            PathView(void) = default;
+
+            /// @brief Creates a view of path.
+            /// @param path Path to view.
+            PathView(const fslib::Path &path);
+
+            /// @brief Creates a view of the path currently held by builder.
+            /// @param builder PathBuilder to view.
+            PathView(const fslib::PathBuilder &builder);
+
+            /// @brief Creates a view of a path checked at compile time.
+            /// @param literal PathLiteral to view.
+            PathView(const fslib::PathLiteral &literal);
+
+            /// @brief Performs the same checks as Path::isValid on the path viewed.
+            /// @return True if path is valid. False if it is not.
+            bool isValid(void) const;
+
+            /// @brief Returns the entire path as a C const char16_t* String
+            /// @return Pointer to path string.
+            const char16_t *cString(void) const;
+
+            /// @brief Returns the device as a UTF-16 u16string_view.
+            /// @return Device string.
+            std::u16string_view getDevice(void) const;
+
+            /// @brief Returns an FS_Path for use with 3DS FS functions.
+            /// @return FS_Path
+            FS_Path getPath(void) const;
+
+            /// @brief Returns length of the entire path string.
+            /// @return Length of path string.
+            size_t getLength(void) const;
+
+        private:
+            /// @brief Start of the path being viewed.
+            const char16_t *m_path = u"";
+
+            /// @brief Position of the ':' ending the device.
+            uint16_t m_deviceEnd = 0xFFFF;
+
+            /// @brief Length of the path.
+            uint16_t m_pathLength = 0;
+    };
+} // namespace fslib
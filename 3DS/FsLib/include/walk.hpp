@@ -0,0 +1,72 @@
+#pragma once
+#include "path.hpp"
+#include <cstdint>
+#include <functional>
+
+namespace fslib
+{
+    /// @brief Visitor return value to keep walking.
+    static constexpr uint8_t WALK_CONTINUE = 0;
+
+    /// @brief Visitor return value to skip the directory being visited. Only meaningful from a pre-order visit of a directory.
+    static constexpr uint8_t WALK_SKIP = 1;
+
+    /// @brief Visitor return value to stop the walk entirely.
+    static constexpr uint8_t WALK_STOP = 2;
+
+    /// @brief Entry passed to walk visitors.
+    struct WalkEntry
+    {
+            /// @brief Full path of the entry including the device. This is only valid during the visit.
+            const char16_t *path = nullptr;
+
+            /// @brief Name of the entry. This points into Path.
+            const char16_t *name = nullptr;
+
+            /// @brief Size of the entry. 0 for directories.
+            int64_t size = 0;
+
+            /// @brief Whether or not the entry is a directory.
+            bool isDirectory = false;
+
+            /// @brief Depth of the entry. Entries directly inside the root are at depth 0.
+            int depth = 0;
+    };
+
+    /// @brief Visitor called for entries during a walk. Returns WALK_CONTINUE, WALK_SKIP, or WALK_STOP.
+    using WalkVisitor = std::function<uint8_t(const fslib::WalkEntry &)>;
+
+    /// @brief Options for walk.
+    struct WalkOptions
+    {
+            /// @brief Called for every entry. Directories are visited before anything inside them. Returning WALK_SKIP for a directory
+            /// keeps the walk from going into it.
+            fslib::WalkVisitor preVisit;
+
+            /// @brief Called for directories after everything inside them has been visited. Not called for skipped directories or when
+            /// walking with more than one worker.
+            fslib::WalkVisitor postVisit;
+
+            /// @brief Deepest level the walk goes into. Directories at this depth are visited, but not entered. -1 is no limit.
+            int maxDepth = -1;
+
+            /// @brief Number of threads to walk with. 1 walks on the calling thread. More than one hands directories out to worker threads
+            /// as they're found. The visitors need to be safe to call from multiple threads at once in that case.
+            int workerCount = 1;
+
+            /// @brief Whether or not each directory's entries are visited in sorted order. Off by default since it costs time.
+            bool sortEntries = false;
+    };
+
+    /**
+     * @brief Walks the directory tree starting at root, calling the visitors in Options for each entry.
+     *
+     * @param root Directory to start at. The root itself isn't visited.
+     * @param options Visitors and options for the walk.
+     * @return True if the walk finished or a visitor stopped it. False if a directory couldn't be read.
+     * @note The walk uses an explicit stack and one path buffer instead of recursion, so deep trees don't use deep stacks or a new Path
+     * per entry. Each directory's listing is read in full and its handle closed before going deeper, so only one directory handle per
+     * worker is open at a time.
+     */
+    bool walk(const fslib::Path &root, const fslib::WalkOptions &options);
+} // namespace fslib
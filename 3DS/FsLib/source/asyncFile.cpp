@@ -0,0 +1,106 @@
+#include "asyncFile.hpp"
+#include "fslib.hpp"
+
+fslib::AsyncFile::AsyncFile(void)
+    : m_strand(fslib::async::createStrand())
+{
+}
+
+fslib::AsyncFile::~AsyncFile()
+{
+    // m_file closes itself once this returns.
+    AsyncFile::wait();
+}
+
+std::future<fslib::async::Completion<bool>> fslib::AsyncFile::open(const fslib::Path &filePath,
+                                                                   uint32_t openFlags,
+                                                                   uint64_t fileSize,
+                                                                   fslib::async::CompletionFunction<bool> onComplete)
+{
+    return fslib::async::request<bool>(
+        m_strand,
+        [this, filePath, openFlags, fileSize]() {
+            m_file.open(filePath, openFlags, fileSize);
+            return m_file.isOpen();
+        },
+        [](bool value) { return !value; },
+        std::move(onComplete));
+}
+
+std::future<fslib::async::Completion<ssize_t>> fslib::AsyncFile::read(void *buffer,
+                                                                      size_t bufferSize,
+                                                                      fslib::async::CompletionFunction<ssize_t> onComplete)
+{
+    return fslib::async::request<ssize_t>(
+        m_strand,
+        [this, buffer, bufferSize]() { return m_file.read(buffer, bufferSize); },
+        [](ssize_t value) { return value < 0; },
+        std::move(onComplete));
+}
+
+std::future<fslib::async::Completion<ssize_t>> fslib::AsyncFile::readAt(int64_t offset,
+                                                                        void *buffer,
+                                                                        size_t bufferSize,
+                                                                        fslib::async::CompletionFunction<ssize_t> onComplete)
+{
+    return fslib::async::request<ssize_t>(
+        m_strand,
+        [this, offset, buffer, bufferSize]() { return m_file.readAt(offset, buffer, bufferSize); },
+        [](ssize_t value) { return value < 0; },
+        std::move(onComplete));
+}
+
+std::future<fslib::async::Completion<ssize_t>> fslib::AsyncFile::write(const void *buffer,
+                                                                       size_t bufferSize,
+                                                                       fslib::async::CompletionFunction<ssize_t> onComplete)
+{
+    return fslib::async::request<ssize_t>(
+        m_strand,
+        [this, buffer, bufferSize]() { return m_file.write(buffer, bufferSize); },
+        [](ssize_t value) { return value < 0; },
+        std::move(onComplete));
+}
+
+std::future<fslib::async::Completion<ssize_t>> fslib::AsyncFile::writeAt(int64_t offset,
+                                                                         const void *buffer,
+                                                                         size_t bufferSize,
+                                                                         fslib::async::CompletionFunction<ssize_t> onComplete)
+{
+    return fslib::async::request<ssize_t>(
+        m_strand,
+        [this, offset, buffer, bufferSize]() { return m_file.writeAt(offset, buffer, bufferSize); },
+        [](ssize_t value) { return value < 0; },
+        std::move(onComplete));
+}
+
+std::future<fslib::async::Completion<bool>> fslib::AsyncFile::flush(fslib::async::CompletionFunction<bool> onComplete)
+{
+    return fslib::async::request<bool>(
+        m_strand,
+        [this]() { return m_file.flush(); },
+        [](bool value) { return !value; },
+        std::move(onComplete));
+}
+
+std::future<fslib::async::Completion<bool>> fslib::AsyncFile::close(fslib::async::CompletionFunction<bool> onComplete)
+{
+    return fslib::async::request<bool>(
+        m_strand,
+        [this]() {
+            m_file.close();
+            return true;
+        },
+        [](bool value) { return !value; },
+        std::move(onComplete));
+}
+
+void fslib::AsyncFile::wait(void)
+{
+    fslib::async::waitForStrand(m_strand);
+}
+
+bool fslib::AsyncFile::isOpen(void)
+{
+    AsyncFile::wait();
+    return m_file.isOpen();
+}
@@ -1,34 +1,107 @@
 #include "fslib.hpp"
-#include "string.hpp"
 #include <algorithm>
 #include <cstring>
+#include <memory>
 #include <string>
 
-extern std::string g_fslibErrorString;
+namespace
+{
+    // Entries read with the first FSDIR_Read call.
+    constexpr uint32_t INITIAL_BATCH_SIZE = 32;
+    // Largest batch to read at once. 256 entries is about 138KB.
+    constexpr uint32_t MAX_BATCH_SIZE = 256;
+    // Marks the start of a run of digits in a natural sort key. Using '0' means numbers still sort where digits normally would.
+    constexpr char16_t DIGIT_RUN_MARKER = u'0';
+
+    // One of these is built per entry when sorting. Most comparisons are settled by the prefix without touching the key arena.
+    struct SortRecord
+    {
+            uint64_t prefix;
+            uint32_t keyOffset;
+            uint32_t keyLength;
+            uint32_t index;
+    };
+} // namespace
 
-// This sorts the entries Directories->File, then pseudo-alphabetically.
-static bool compareEntries(const FS_DirectoryEntry &entryA, const FS_DirectoryEntry &entryB)
+// Simple case folding for the scripts likely to show up in file names. Anything not covered is returned as is.
+static char16_t foldCodeUnit(char16_t codeUnit)
 {
-    if (entryA.attributes != entryB.attributes)
+    if ((codeUnit >= u'A' && codeUnit <= u'Z') || (codeUnit >= 0xC0 && codeUnit <= 0xDE && codeUnit != 0xD7) ||
+        (codeUnit >= 0x391 && codeUnit <= 0x3AB && codeUnit != 0x3A2) || (codeUnit >= 0x410 && codeUnit <= 0x42F) ||
+        (codeUnit >= 0xFF21 && codeUnit <= 0xFF3A))
+    {
+        return codeUnit + 0x20;
+    }
+
+    if (codeUnit >= 0x400 && codeUnit <= 0x40F)
+    {
+        return codeUnit + 0x50;
+    }
+
+    // Latin Extended-A alternates upper and lower case, but the pairs shift by one in the middle and at the end.
+    if ((codeUnit >= 0x100 && codeUnit <= 0x137) || (codeUnit >= 0x14A && codeUnit <= 0x177))
+    {
+        return codeUnit | 1;
+    }
+
+    if ((codeUnit >= 0x139 && codeUnit <= 0x148) || (codeUnit >= 0x179 && codeUnit <= 0x17E))
     {
-        return entryA.attributes & FS_ATTRIBUTE_DIRECTORY;
+        return codeUnit + (codeUnit & 1);
     }
 
-    // Get the shortest length to avoid reading out-of-bounds.
-    size_t entryALength = std::char_traits<uint16_t>::length(entryA.name);
-    size_t entryBLength = std::char_traits<uint16_t>::length(entryB.name);
-    size_t shortestEntry = entryALength < entryBLength ? entryALength : entryBLength;
-    for (size_t i = 0; i < shortestEntry; i++)
+    if (codeUnit == 0x178)
     {
-        // Lower case the character so that doesn't impact sorting.
-        int charA = std::tolower(entryA.name[i]);
-        int charB = std::tolower(entryB.name[i]);
-        if (charA != charB)
+        return 0xFF;
+    }
+    return codeUnit;
+}
+
+static inline bool isDigit(char16_t codeUnit)
+{
+    return codeUnit >= u'0' && codeUnit <= u'9';
+}
+
+// Appends name's collation key to keyOut. Keys are case folded and compare correctly unit by unit. If natural is set, runs of digits
+// are written as a marker, the number of significant digits, and then the digits so 2 comes before 10.
+static void appendCollationKey(const char16_t *name, size_t nameLength, bool natural, std::vector<char16_t> &keyOut)
+{
+    size_t i = 0;
+    while (i < nameLength)
+    {
+        if (natural && isDigit(name[i]))
         {
-            return charA < charB;
+            size_t runEnd = i;
+            while (runEnd < nameLength && isDigit(name[runEnd]))
+            {
+                ++runEnd;
+            }
+
+            size_t firstDigit = i;
+            while (firstDigit < runEnd && name[firstDigit] == u'0')
+            {
+                ++firstDigit;
+            }
+
+            keyOut.push_back(DIGIT_RUN_MARKER);
+            keyOut.push_back(static_cast<char16_t>(runEnd - firstDigit));
+            keyOut.insert(keyOut.end(), name + firstDigit, name + runEnd);
+            i = runEnd;
+            continue;
         }
+        // Surrogates are outside every folded range so they pass through untouched.
+        keyOut.push_back(foldCodeUnit(name[i++]));
+    }
+}
+
+// Returns the first four units of key as a big endian integer, padded with zeros. Comparing these compares the start of the keys.
+static uint64_t getKeyPrefix(const char16_t *key, size_t keyLength)
+{
+    uint64_t prefix = 0;
+    for (size_t i = 0; i < sizeof(uint64_t) / sizeof(char16_t); i++)
+    {
+        prefix = (prefix << 16) | (i < keyLength ? key[i] : 0);
     }
-    return false;
+    return prefix;
 }
 
 fslib::Directory::Directory(const fslib::Path &directoryPath, bool sortEntries)
@@ -40,7 +113,12 @@ void fslib::Directory::open(const fslib::Path &directoryPath, bool sortEntries)
 {
     // Just in case directory is reused.
     m_wasOpened = false;
-    m_directoryList.clear();
+    m_directoryPath = directoryPath;
+    m_nameArena.clear();
+    m_nameOffsets.clear();
+    m_nameLengths.clear();
+    m_entrySizes.clear();
+    m_entryIsDirectory.clear();
 
     FS_Archive archive;
     if (!fslib::processDeviceAndPath(directoryPath, &archive))
@@ -52,24 +130,73 @@ void fslib::Directory::open(const fslib::Path &directoryPath, bool sortEntries)
     Result fsError = FSUSER_OpenDirectory(&m_directoryHandle, archive, directoryPath.getPath());
     if (R_FAILED(fsError))
     {
-        g_fslibErrorString = string::getFormattedString("Error opening directory: 0x%08X.", fsError);
+        fslib::error::setResult(fslib::Operation::OpenDirectory, fsError, directoryPath);
         return;
     }
 
-    // Switch has a function to fetch entry count. 3DS doesn't, so we have to loop and load one at a time.
-    uint32_t entriesRead = 0;
-    FS_DirectoryEntry currentEntry;
-    while (R_SUCCEEDED(FSDIR_Read(m_directoryHandle, &entriesRead, 1, &currentEntry)) && entriesRead == 1)
+    // Switch has a function to fetch entry count. 3DS doesn't, so entries are read in batches and only the name, size, and type are
+    // kept. The batch size doubles every time a batch comes back full so small directories stay cheap and big ones need few requests.
+    uint32_t batchSize = INITIAL_BATCH_SIZE;
+    std::unique_ptr<FS_DirectoryEntry[]> batch(new (std::nothrow) FS_DirectoryEntry[batchSize]);
+    while (batch)
     {
-        m_directoryList.push_back(currentEntry);
+        uint32_t entriesRead = 0;
+        fsError = FSDIR_Read(m_directoryHandle, &entriesRead, batchSize, batch.get());
+        if (R_FAILED(fsError))
+        {
+            break;
+        }
+
+        for (uint32_t i = 0; i < entriesRead; i++)
+        {
+            const FS_DirectoryEntry &entry = batch[i];
+            const char16_t *name = reinterpret_cast<const char16_t *>(entry.name);
+            size_t nameLength = std::char_traits<char16_t>::length(name);
+
+            m_nameOffsets.push_back(static_cast<uint32_t>(m_nameArena.size()));
+            m_nameLengths.push_back(static_cast<uint16_t>(nameLength));
+            m_entrySizes.push_back(entry.fileSize);
+            m_entryIsDirectory.push_back((entry.attributes & FS_ATTRIBUTE_DIRECTORY) != 0);
+            m_nameArena.insert(m_nameArena.end(), name, name + nameLength + 1);
+        }
+
+        if (entriesRead < batchSize)
+        {
+            break;
+        }
+
+        if (batchSize < MAX_BATCH_SIZE)
+        {
+            batchSize = std::min(batchSize * 2, MAX_BATCH_SIZE);
+            batch.reset(new (std::nothrow) FS_DirectoryEntry[batchSize]);
+        }
     }
     // The directory was read and there's no reason to keep it open.
     Directory::close();
 
+    // A partial listing would look like the whole directory, so it's thrown out.
+    if (R_FAILED(fsError) || !batch)
+    {
+        if (R_FAILED(fsError))
+        {
+            fslib::error::setResult(fslib::Operation::ReadDirectory, fsError, directoryPath);
+        }
+        else
+        {
+            fslib::error::setReason(fslib::Operation::OpenDirectory, "Couldn't allocate read buffer.", directoryPath);
+        }
+        m_nameArena.clear();
+        m_nameOffsets.clear();
+        m_nameLengths.clear();
+        m_entrySizes.clear();
+        m_entryIsDirectory.clear();
+        return;
+    }
+
     // Sort entries if requested.
     if (sortEntries)
     {
-        std::sort(m_directoryList.begin(), m_directoryList.end(), compareEntries);
+        Directory::sort(Directory::sortName);
     }
 
     // Should be good to go?
@@ -83,47 +210,168 @@ bool fslib::Directory::isOpen(void) const
 
 uint32_t fslib::Directory::getCount(void) const
 {
-    return m_directoryList.size();
+    return m_nameOffsets.size();
+}
+
+uint64_t fslib::Directory::getEntrySize(int index) const
+{
+    if (index < 0 || index >= static_cast<int>(m_entrySizes.size()))
+    {
+        return 0;
+    }
+    return m_entrySizes[index];
 }
 
 bool fslib::Directory::isDirectory(int index) const
 {
-    if (index < 0 || index >= static_cast<int>(m_directoryList.size()))
+    if (index < 0 || index >= static_cast<int>(m_nameOffsets.size()))
     {
         return false;
     }
-    return m_directoryList.at(index).attributes & FS_ATTRIBUTE_DIRECTORY;
+    return m_entryIsDirectory[index];
 }
 
 std::u16string_view fslib::Directory::getEntry(int index) const
 {
-    if (index < 0 || index >= static_cast<int>(m_directoryList.size()))
+    if (index < 0 || index >= static_cast<int>(m_nameOffsets.size()))
     {
         return std::u16string_view(u"nullptr");
     }
-    return std::u16string_view(reinterpret_cast<const char16_t *>(m_directoryList.at(index).name));
+    return std::u16string_view(&m_nameArena[m_nameOffsets[index]], m_nameLengths[index]);
 }
 
 const char16_t *fslib::Directory::operator[](int index) const
 {
-    if (index < 0 || index >= static_cast<int>(m_directoryList.size()))
+    if (index < 0 || index >= static_cast<int>(m_nameOffsets.size()))
     {
         return nullptr;
     }
-    return reinterpret_cast<const char16_t *>(m_directoryList.at(index).name);
+    return &m_nameArena[m_nameOffsets[index]];
 }
 
-bool fslib::Directory::close(void)
+bool fslib::Directory::sort(uint8_t sortOrder, bool directoriesFirst, bool descending)
 {
-    if (!m_wasOpened)
+    size_t entryCount = m_nameOffsets.size();
+    if (entryCount == 0)
     {
-        return false;
+        return true;
+    }
+
+    // Every order gets the folded name key so ties can fall back to it. Name orders use the start of the key as the prefix, the others
+    // use the value being sorted by.
+    bool natural = sortOrder == Directory::sortNatural;
+    bool prefixFromKey = sortOrder != Directory::sortSize && sortOrder != Directory::sortTimestamp;
+    std::vector<char16_t> keyArena;
+    keyArena.reserve(m_nameArena.size() + (natural ? entryCount * 2 : 0));
+    std::vector<SortRecord> records(entryCount);
+    for (size_t i = 0; i < entryCount; i++)
+    {
+        SortRecord &record = records[i];
+        record.keyOffset = keyArena.size();
+        appendCollationKey(&m_nameArena[m_nameOffsets[i]], m_nameLengths[i], natural, keyArena);
+        record.keyLength = keyArena.size() - record.keyOffset;
+        record.index = i;
+    }
+
+    if (sortOrder == Directory::sortTimestamp)
+    {
+        FS_Archive archive;
+        if (!fslib::processDeviceAndPath(m_directoryPath, &archive))
+        {
+            return false;
+        }
+
+        // Entries whose timestamp can't be read sort as if it were 0.
+        fslib::PathBuilder entryPath(m_directoryPath);
+        for (size_t i = 0; i < entryCount; i++)
+        {
+            uint64_t timestamp = 0;
+            Result fsError = -1;
+            if (entryPath.push(&m_nameArena[m_nameOffsets[i]]))
+            {
+                FS_Path fsPath = entryPath.getPath().getPath();
+                fsError = FSUSER_ControlArchive(archive,
+                                                ARCHIVE_ACTION_GET_TIMESTAMP,
+                                                const_cast<void *>(fsPath.data),
+                                                fsPath.size,
+                                                &timestamp,
+                                                sizeof(uint64_t));
+                entryPath.pop();
+            }
+            records[i].prefix = R_SUCCEEDED(fsError) ? timestamp : 0;
+        }
+    }
+    else
+    {
+        for (SortRecord &record : records)
+        {
+            record.prefix = prefixFromKey ? getKeyPrefix(&keyArena[record.keyOffset], record.keyLength) : m_entrySizes[record.index];
+        }
     }
 
+    size_t keyStart = prefixFromKey ? sizeof(uint64_t) / sizeof(char16_t) : 0;
+    std::sort(records.begin(), records.end(), [&](const SortRecord &recordA, const SortRecord &recordB) {
+        bool directoryA = m_entryIsDirectory[recordA.index];
+        bool directoryB = m_entryIsDirectory[recordB.index];
+        if (directoriesFirst && directoryA != directoryB)
+        {
+            return directoryA;
+        }
+
+        if (recordA.prefix != recordB.prefix)
+        {
+            return descending ? recordA.prefix > recordB.prefix : recordA.prefix < recordB.prefix;
+        }
+
+        // Compare whatever the prefix didn't cover, then the raw names so entries differing only by case still have a set order.
+        int result = 0;
+        size_t shortestKey = std::min(recordA.keyLength, recordB.keyLength);
+        if (shortestKey > keyStart)
+        {
+            result = std::char_traits<char16_t>::compare(&keyArena[recordA.keyOffset + keyStart],
+                                                         &keyArena[recordB.keyOffset + keyStart],
+                                                         shortestKey - keyStart);
+        }
+
+        if (result == 0 && recordA.keyLength != recordB.keyLength)
+        {
+            result = recordA.keyLength < recordB.keyLength ? -1 : 1;
+        }
+
+        if (result == 0)
+        {
+            std::u16string_view nameA(&m_nameArena[m_nameOffsets[recordA.index]], m_nameLengths[recordA.index]);
+            std::u16string_view nameB(&m_nameArena[m_nameOffsets[recordB.index]], m_nameLengths[recordB.index]);
+            result = nameA.compare(nameB);
+        }
+        return descending ? result > 0 : result < 0;
+    });
+
+    std::vector<uint32_t> nameOffsets(entryCount);
+    std::vector<uint16_t> nameLengths(entryCount);
+    std::vector<uint64_t> entrySizes(entryCount);
+    std::vector<uint8_t> entryIsDirectory(entryCount);
+    for (size_t i = 0; i < entryCount; i++)
+    {
+        uint32_t index = records[i].index;
+        nameOffsets[i] = m_nameOffsets[index];
+        nameLengths[i] = m_nameLengths[index];
+        entrySizes[i] = m_entrySizes[index];
+        entryIsDirectory[i] = m_entryIsDirectory[index];
+    }
+    m_nameOffsets = std::move(nameOffsets);
+    m_nameLengths = std::move(nameLengths);
+    m_entrySizes = std::move(entrySizes);
+    m_entryIsDirectory = std::move(entryIsDirectory);
+    return true;
+}
+
+bool fslib::Directory::close(void)
+{
     Result fsError = FSDIR_Close(m_directoryHandle);
     if (R_FAILED(fsError))
     {
-        g_fslibErrorString = string::getFormattedString("Error closing directory: 0x%08X.", fsError);
+        fslib::error::setResult(fslib::Operation::CloseDirectory, fsError);
         return false;
     }
     return true;
@@ -1,8 +1,67 @@
 #include "fslib.hpp"
-#include "string.hpp"
 #include <3ds.h>
+#include <algorithm>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <unordered_map>
 
-extern std::string g_fslibErrorString;
+namespace
+{
+    // Most directories createDirectoriesRecursively remembers as existing per device.
+    constexpr size_t KNOWN_DIRECTORY_LIMIT = 32;
+
+    // Directories known to exist paired with their device. The most recently used are at the back.
+    std::mutex s_knownDirectoryLock;
+    std::unordered_map<std::u16string, std::deque<std::u16string>> s_knownDirectories;
+} // namespace
+
+// Returns an FS_Path for the first pathLength characters of path. The character at pathLength must be NUL.
+static inline FS_Path getSubPath(const char16_t *path, size_t pathLength)
+{
+    return {PATH_UTF16, (pathLength + 1) * sizeof(char16_t), path};
+}
+
+// Returns whether or not path is known to exist on deviceName. Hits are moved to the back so they're kept longer.
+static bool isKnownDirectory(std::u16string_view deviceName, std::u16string_view path)
+{
+    std::lock_guard<std::mutex> knownDirectoryLock(s_knownDirectoryLock);
+    auto findDevice = s_knownDirectories.find(std::u16string(deviceName));
+    if (findDevice == s_knownDirectories.end())
+    {
+        return false;
+    }
+
+    std::deque<std::u16string> &knownDirectories = findDevice->second;
+    auto findPath = std::find(knownDirectories.begin(), knownDirectories.end(), path);
+    if (findPath == knownDirectories.end())
+    {
+        return false;
+    }
+
+    std::u16string knownPath = std::move(*findPath);
+    knownDirectories.erase(findPath);
+    knownDirectories.push_back(std::move(knownPath));
+    return true;
+}
+
+// Remembers path exists on deviceName, forgetting the least recently used if there are too many.
+static void rememberDirectory(std::u16string_view deviceName, std::u16string_view path)
+{
+    std::lock_guard<std::mutex> knownDirectoryLock(s_knownDirectoryLock);
+    std::deque<std::u16string> &knownDirectories = s_knownDirectories[std::u16string(deviceName)];
+    knownDirectories.emplace_back(path);
+    if (knownDirectories.size() > KNOWN_DIRECTORY_LIMIT)
+    {
+        knownDirectories.pop_front();
+    }
+}
+
+// Returns an FS_Path for a path taken from a walk's path buffer with the device already skipped.
+static inline FS_Path getEntryFsPath(const char16_t *path)
+{
+    return {PATH_UTF16, (std::char_traits<char16_t>::length(path) + 1) * sizeof(char16_t), path};
+}
 
 bool fslib::directoryExists(const fslib::Path &directoryPath)
 {
@@ -12,10 +71,12 @@ bool fslib::directoryExists(const fslib::Path &directoryPath)
         return false;
     }
 
+    // getEntryInfo tries the path as a file first. Opening it as a directory is all this needs.
     Handle directoryHandle;
     Result fsError = FSUSER_OpenDirectory(&directoryHandle, archive, directoryPath.getPath());
     if (R_FAILED(fsError))
     {
+        fslib::error::setResult(fslib::Operation::OpenDirectory, fsError, directoryPath);
         return false;
     }
     FSDIR_Close(directoryHandle);
@@ -33,7 +94,7 @@ bool fslib::createDirectory(const fslib::Path &directoryPath)
     Result fsError = FSUSER_CreateDirectory(archive, directoryPath.getPath(), 0);
     if (R_FAILED(fsError))
     {
-        g_fslibErrorString = string::getFormattedString("Error creating directory: 0x%08X.", fsError);
+        fslib::error::setResult(fslib::Operation::CreateDirectory, fsError, directoryPath);
         return false;
     }
     return true;
@@ -41,25 +102,71 @@ bool fslib::createDirectory(const fslib::Path &directoryPath)
 
 bool fslib::createDirectoriesRecursively(const fslib::Path &directoryPath)
 {
-    size_t slashPosition = directoryPath.findFirstOf(u'/') + 1;
-    do
+    FS_Archive archive;
+    if (!fslib::processDeviceAndPath(directoryPath, &archive))
+    {
+        return false;
+    }
+
+    // Work on a copy of the path without the device or trailing slashes. Cutting it at a slash gives each parent directory.
+    std::u16string_view deviceName = directoryPath.getDevice();
+    std::u16string pathBuffer = reinterpret_cast<const char16_t *>(directoryPath.getPath().data);
+    while (pathBuffer.length() > 1 && pathBuffer.back() == u'/')
+    {
+        pathBuffer.pop_back();
+    }
+
+    // Walk backwards until a directory that's known to exist or actually exists is found. The root always exists.
+    size_t existingEnd = pathBuffer.length();
+    while (existingEnd > 1)
+    {
+        std::u16string_view currentPath(pathBuffer.c_str(), existingEnd);
+        if (isKnownDirectory(deviceName, currentPath))
+        {
+            break;
+        }
+
+        pathBuffer[existingEnd] = u'\0';
+        Handle directoryHandle;
+        Result fsError = FSUSER_OpenDirectory(&directoryHandle, archive, getSubPath(pathBuffer.c_str(), existingEnd));
+        pathBuffer[existingEnd] = existingEnd < pathBuffer.length() ? u'/' : u'\0';
+        if (R_SUCCEEDED(fsError))
+        {
+            FSDIR_Close(directoryHandle);
+            rememberDirectory(deviceName, currentPath);
+            break;
+        }
+
+        size_t slashPosition = currentPath.find_last_of(u'/');
+        existingEnd = slashPosition == std::u16string_view::npos ? 0 : slashPosition;
+    }
+
+    // Create only what's missing after that.
+    while (existingEnd < pathBuffer.length())
     {
-        // Find the next slash
-        slashPosition = directoryPath.findFirstOf(u'/', slashPosition);
-        // Get the sub path to create
-        fslib::Path currentDirectory = directoryPath.subPath(slashPosition);
+        size_t nextSlash = pathBuffer.find(u'/', existingEnd + 1);
+        size_t currentEnd = nextSlash == std::u16string::npos ? pathBuffer.length() : nextSlash;
 
-        // If it doesn't exist, try to create it.
-        if (!fslib::directoryExists(currentDirectory) && !fslib::createDirectory(currentDirectory))
+        pathBuffer[currentEnd] = u'\0';
+        Result fsError = FSUSER_CreateDirectory(archive, getSubPath(pathBuffer.c_str(), currentEnd), 0);
+        pathBuffer[currentEnd] = currentEnd < pathBuffer.length() ? u'/' : u'\0';
+        if (R_FAILED(fsError))
         {
-            // createDirectory should set the error string.
+            fslib::error::setResult(fslib::Operation::CreateDirectory, fsError, directoryPath);
             return false;
         }
-        ++slashPosition;
-    } while (slashPosition < directoryPath.getLength());
+        rememberDirectory(deviceName, std::u16string_view(pathBuffer.c_str(), currentEnd));
+        existingEnd = currentEnd;
+    }
     return true;
 }
 
+void fslib::forgetKnownDirectories(std::u16string_view deviceName)
+{
+    std::lock_guard<std::mutex> knownDirectoryLock(s_knownDirectoryLock);
+    s_knownDirectories.erase(std::u16string(deviceName));
+}
+
 bool fslib::renameDirectory(const fslib::Path &oldPath, const fslib::Path &newPath)
 {
     // This is going to be a bit different because we're working with two paths. Archives can be compared since they're just uint64_t's underneath.
@@ -70,10 +177,12 @@ bool fslib::renameDirectory(const fslib::Path &oldPath, const fslib::Path &newPa
     }
 
     // I don't understand why this call takes two different archives. It's not like you can rename a file from a different physical location and make it move that way.
+    fslib::forgetKnownDirectories(oldPath.getDevice());
+
     Result fsError = FSUSER_RenameDirectory(archiveA, oldPath.getPath(), archiveB, newPath.getPath());
     if (R_FAILED(fsError))
     {
-        g_fslibErrorString = string::getFormattedString("Error renaming directory: 0x%08X.", fsError);
+        fslib::error::setResult(fslib::Operation::RenameDirectory, fsError, oldPath);
         return false;
     }
     return true;
@@ -87,55 +196,97 @@ bool fslib::deleteDirectory(const fslib::Path &directoryPath)
         return false;
     }
 
+    // Anything under this directory might be remembered as existing.
+    fslib::forgetKnownDirectories(directoryPath.getDevice());
+
     Result fsError = FSUSER_DeleteDirectory(archive, directoryPath.getPath());
     if (R_FAILED(fsError))
     {
-        g_fslibErrorString = string::getFormattedString("Error deleting directory: 0x%08X.", fsError);
+        fslib::error::setResult(fslib::Operation::DeleteDirectory, fsError, directoryPath);
         return false;
     }
     return true;
 }
 
-bool fslib::deleteDirectoryRecursively(const fslib::Path &directoryPath)
+bool fslib::deleteDirectoryRecursively(const fslib::Path &directoryPath, const fslib::DeleteProgressFunction &progress)
 {
-    // Get directory listing
-    fslib::Directory targetDirectory(directoryPath);
-    if (!targetDirectory.isOpen())
+    FS_Archive archive;
+    if (!fslib::processDeviceAndPath(directoryPath, &archive))
     {
-        // Error should be set.
         return false;
     }
 
-    for (uint32_t i = 0; i < targetDirectory.getCount(); i++)
+    /*
+        Make sure we're not trying to delete a device root. I think this is what's wrong with Nintendo's implementation and why it fails
+        when called on the root. Anything else gets handed to FS to delete in one request.
+    */
+    fslib::forgetKnownDirectories(directoryPath.getDevice());
+
+    FS_Path rootPath = directoryPath.getPath();
+    bool isRoot = std::char_traits<char16_t>::length(reinterpret_cast<const char16_t *>(rootPath.data)) <= 1;
+    if (!isRoot && R_SUCCEEDED(FSUSER_DeleteDirectoryRecursively(archive, rootPath)))
     {
-        fslib::Path newTarget = directoryPath / targetDirectory[i];
+        return true;
+    }
 
-        // Debug shit: remove
-        char asciiBuffer[fslib::MAX_PATH] = {0};
-        utf16_to_utf8(reinterpret_cast<uint8_t *>(asciiBuffer), reinterpret_cast<const uint16_t *>(newTarget.cString()), fslib::MAX_PATH);
-        printf("newTarget: %s\n", asciiBuffer);
+    // Fall back to walking the tree and deleting everything one at a time. The walk's path buffer is passed straight to FS after skipping
+    // the device so there's no Path built per entry.
+    size_t deviceLength = reinterpret_cast<const char16_t *>(rootPath.data) - directoryPath.cString();
+    int64_t entriesDeleted = 0;
+    bool deleteFailed = false;
 
-        if (targetDirectory.isDirectory(i) && !fslib::deleteDirectoryRecursively(newTarget))
+    fslib::WalkOptions walkOptions;
+    walkOptions.preVisit = [&](const fslib::WalkEntry &entry) {
+        if (entry.isDirectory)
         {
-            return false;
+            return fslib::WALK_CONTINUE;
         }
-        else if (!targetDirectory.isDirectory(i) && !fslib::deleteFile(newTarget))
+
+        Result fsError = FSUSER_DeleteFile(archive, getEntryFsPath(entry.path + deviceLength));
+        if (R_FAILED(fsError))
         {
-            return false;
+            fslib::error::setResult(fslib::Operation::DeleteFile, fsError, std::u16string_view(entry.path));
+            deleteFailed = true;
+            return fslib::WALK_STOP;
+        }
+
+        if (progress)
+        {
+            progress(++entriesDeleted);
+        }
+        return fslib::WALK_CONTINUE;
+    };
+    // Directories are empty by the time they're visited again.
+    walkOptions.postVisit = [&](const fslib::WalkEntry &entry) {
+        Result fsError = FSUSER_DeleteDirectory(archive, getEntryFsPath(entry.path + deviceLength));
+        if (R_FAILED(fsError))
+        {
+            fslib::error::setResult(fslib::Operation::DeleteDirectory, fsError, std::u16string_view(entry.path));
+            deleteFailed = true;
+            return fslib::WALK_STOP;
+        }
+
+        if (progress)
+        {
+            progress(++entriesDeleted);
         }
+        return fslib::WALK_CONTINUE;
+    };
+
+    if (!fslib::walk(directoryPath, walkOptions) || deleteFailed)
+    {
+        // Error should be set.
+        return false;
     }
-    /*
-        Make sure we're not trying to delete a device root before returning failure. I think this is what's wrong with Nintendo's implementation
-        and why it fails when called on the root.
-    */
-    char asciiBuffer[fslib::MAX_PATH] = {0};
-    utf16_to_utf8(reinterpret_cast<uint8_t *>(asciiBuffer), reinterpret_cast<const uint16_t *>(directoryPath.cString()), fslib::MAX_PATH);
-    printf("directoryPath: %s\n", asciiBuffer);
 
-    const char16_t *pathBegin = std::char_traits<char16_t>::find(directoryPath.cString(), directoryPath.getLength(), u'/');
-    if (std::char_traits<char16_t>::length(pathBegin) > 1 && !fslib::deleteDirectory(directoryPath))
+    if (!isRoot && !fslib::deleteDirectory(directoryPath))
     {
         return false;
     }
+
+    if (progress)
+    {
+        progress(++entriesDeleted);
+    }
     return true;
 }
@@ -0,0 +1,159 @@
+#include "directoryIterator.hpp"
+#include "error.hpp"
+#include "fslib.hpp"
+#include <string>
+
+fslib::DirectoryIterator::DirectoryIterator(const fslib::Path &directoryPath, uint32_t batchSize)
+{
+    DirectoryIterator::open(directoryPath, batchSize);
+}
+
+fslib::DirectoryIterator::~DirectoryIterator()
+{
+    DirectoryIterator::close();
+}
+
+void fslib::DirectoryIterator::open(const fslib::Path &directoryPath, uint32_t batchSize)
+{
+    // So iterators can be reused.
+    DirectoryIterator::close();
+    m_batchCount = 0;
+    m_batchIndex = -1;
+    // This is cleared once the directory is actually open.
+    m_failed = true;
+
+    FS_Archive archive;
+    if (!fslib::processDeviceAndPath(directoryPath, &archive))
+    {
+        // Function will set error string.
+        return;
+    }
+
+    if (batchSize == 0)
+    {
+        batchSize = DirectoryIterator::defaultBatchSize;
+    }
+
+    // Only reallocate the batch buffer if the size actually changed.
+    if (!m_batch || m_batchSize != batchSize)
+    {
+        m_batch.reset(new (std::nothrow) FS_DirectoryEntry[batchSize]);
+        if (!m_batch)
+        {
+            m_batchSize = 0;
+            fslib::error::setReason(fslib::Operation::OpenDirectory, "Couldn't allocate batch buffer.", directoryPath);
+            return;
+        }
+        m_batchSize = batchSize;
+    }
+
+    Result fsError = FSUSER_OpenDirectory(&m_directoryHandle, archive, directoryPath.getPath());
+    if (R_FAILED(fsError))
+    {
+        fslib::error::setResult(fslib::Operation::OpenDirectory, fsError, directoryPath);
+        return;
+    }
+    m_isOpen = true;
+    m_failed = false;
+}
+
+void fslib::DirectoryIterator::close(void)
+{
+    if (!m_isOpen)
+    {
+        return;
+    }
+
+    Result fsError = FSDIR_Close(m_directoryHandle);
+    if (R_FAILED(fsError))
+    {
+        fslib::error::setResult(fslib::Operation::CloseDirectory, fsError);
+    }
+    m_isOpen = false;
+}
+
+bool fslib::DirectoryIterator::isOpen(void) const
+{
+    return m_isOpen;
+}
+
+bool fslib::DirectoryIterator::failed(void) const
+{
+    return m_failed;
+}
+
+bool fslib::DirectoryIterator::next(void)
+{
+    if (m_batchIndex + 1 < m_batchCount)
+    {
+        ++m_batchIndex;
+        return true;
+    }
+
+    if (!DirectoryIterator::readBatch())
+    {
+        // Nothing left. There's no reason to keep the handle around.
+        DirectoryIterator::close();
+        m_batchCount = 0;
+        m_batchIndex = -1;
+        return false;
+    }
+    m_batchIndex = 0;
+    return true;
+}
+
+const FS_DirectoryEntry *fslib::DirectoryIterator::getEntry(void) const
+{
+    if (m_batchIndex < 0 || m_batchIndex >= m_batchCount)
+    {
+        return nullptr;
+    }
+    return &m_batch[m_batchIndex];
+}
+
+const char16_t *fslib::DirectoryIterator::getName(void) const
+{
+    const FS_DirectoryEntry *entry = DirectoryIterator::getEntry();
+    return entry ? reinterpret_cast<const char16_t *>(entry->name) : nullptr;
+}
+
+uint64_t fslib::DirectoryIterator::getSize(void) const
+{
+    const FS_DirectoryEntry *entry = DirectoryIterator::getEntry();
+    return entry ? entry->fileSize : 0;
+}
+
+bool fslib::DirectoryIterator::isDirectory(void) const
+{
+    const FS_DirectoryEntry *entry = DirectoryIterator::getEntry();
+    return entry && (entry->attributes & FS_ATTRIBUTE_DIRECTORY);
+}
+
+fslib::DirectoryIterator::Iterator fslib::DirectoryIterator::begin(void)
+{
+    return Iterator(DirectoryIterator::next() ? this : nullptr);
+}
+
+fslib::DirectoryIterator::Iterator fslib::DirectoryIterator::end(void)
+{
+    return Iterator(nullptr);
+}
+
+bool fslib::DirectoryIterator::readBatch(void)
+{
+    if (!m_isOpen)
+    {
+        return false;
+    }
+
+    uint32_t entriesRead = 0;
+    Result fsError = FSDIR_Read(m_directoryHandle, &entriesRead, m_batchSize, m_batch.get());
+    if (R_FAILED(fsError))
+    {
+        fslib::error::setResult(fslib::Operation::ReadDirectory, fsError);
+        m_failed = true;
+        return false;
+    }
+    m_batchCount = static_cast<int>(entriesRead);
+    return entriesRead > 0;
+}
@@ -1,13 +1,37 @@
 #include "fslib.hpp"
-#include "string.hpp"
+#include <algorithm>
+#include <atomic>
 #include <cstdarg>
+#include <cstring>
 
 namespace
 {
     constexpr size_t VA_BUFFER_SIZE = 0x1000;
+    // Vectored reads and writes at or below this size go through one staging buffer and a single request.
+    constexpr size_t VECTOR_STAGING_LIMIT = 0x10000;
 }
 
-extern std::string g_fslibErrorString;
+// Returns a pointer to the first '\n' or '\r' in buffer. memchr is used since it's much faster than checking byte by byte.
+static const char *findLineBreak(const char *buffer, size_t bufferSize)
+{
+    const char *newLine = static_cast<const char *>(std::memchr(buffer, '\n', bufferSize));
+    // No reason to look for a carriage return past the new line.
+    size_t searchLength = newLine ? newLine - buffer : bufferSize;
+    const char *carriageReturn = static_cast<const char *>(std::memchr(buffer, '\r', searchLength));
+    return carriageReturn ? carriageReturn : newLine;
+}
+
+// Returns the combined size of all the buffers in vectors.
+template <typename VectorType>
+static size_t getVectorSize(std::span<const VectorType> vectors)
+{
+    size_t totalSize = 0;
+    for (const VectorType &vector : vectors)
+    {
+        totalSize += vector.bufferSize;
+    }
+    return totalSize;
+}
 
 fslib::File::File(const fslib::Path &filePath, uint32_t openFlags, uint64_t fileSize)
 {
@@ -21,8 +45,9 @@ fslib::File::~File()
 
 void fslib::File::open(const fslib::Path &filePath, uint32_t openFlags, uint64_t fileSize)
 {
-    // Just in case file is reused.
-    m_isOpen = false;
+    // Just in case file is reused. Closing first makes sure anything still buffered for the last file is written.
+    File::close();
+    m_readBufferLength = 0;
 
     FS_Archive archive;
     if (!fslib::processDeviceAndPath(filePath, &archive))
@@ -46,18 +71,19 @@ void fslib::File::open(const fslib::Path &filePath, uint32_t openFlags, uint64_t
     Result fsError = FSUSER_OpenFile(&m_fileHandle, archive, filePath.getPath(), m_openFlags, 0);
     if (R_FAILED(fsError))
     {
-        g_fslibErrorString = string::getFormattedString("Error opening file: 0x%08X.", fsError);
+        fslib::error::setResult(fslib::Operation::OpenFile, fsError, filePath);
         return;
     }
 
     fsError = FSFILE_GetSize(m_fileHandle, reinterpret_cast<uint64_t *>(&m_fileSize));
     if (R_FAILED(fsError))
     {
-        g_fslibErrorString = string::getFormattedString("Error getting file size: 0x%08X.", fsError);
+        fslib::error::setResult(fslib::Operation::GetFileSize, fsError, filePath);
         return;
     }
     // I added FS_OPEN_APPEND to FsLib. This isn't normally part of ctrulib/3DS.
     m_offset = m_openFlags & FS_OPEN_APPEND ? m_fileSize : 0;
+    m_allocatedSize = m_fileSize;
     m_isOpen = true;
 }
 
@@ -65,7 +91,11 @@ void fslib::File::close(void)
 {
     if (m_isOpen)
     {
+        // Anything still buffered needs to make it to the file and any extra space allocated needs to go before the handle is gone.
+        File::flushWriteBuffer();
+        File::trimToSize();
         FSFILE_Close(m_fileHandle);
+        m_isOpen = false;
     }
 }
 
@@ -91,6 +121,9 @@ bool fslib::File::endOfFile(void) const
 
 void fslib::File::seek(int64_t offset, uint8_t origin)
 {
+    // Buffered writes are only ever contiguous, so they need to go out before the offset moves.
+    File::flushWriteBuffer();
+
     switch (origin)
     {
         case File::beginning:
@@ -116,27 +149,84 @@ void fslib::File::seek(int64_t offset, uint8_t origin)
 
 ssize_t fslib::File::read(void *buffer, size_t bufferSize)
 {
-    if (!File::isOpenForReading())
+    // Make sure anything waiting to be written is actually in the file before reading from it.
+    if (!File::isOpenForReading() || !File::flushWriteBuffer())
     {
         return -1;
     }
 
+    // The file can be bigger on the device than it really is if it was grown ahead of time. Never read past the real end.
+    if (m_offset >= m_fileSize)
+    {
+        return 0;
+    }
+    else if (m_offset + static_cast<int64_t>(bufferSize) > m_fileSize)
+    {
+        bufferSize = m_fileSize - m_offset;
+    }
+
+    // Small reads are served from the read buffer if it's enabled. Larger ones go straight to the file.
+    if (m_readBuffer && bufferSize < m_readBufferSize)
+    {
+        size_t bytesCopied = File::readFromBuffer(buffer, bufferSize);
+        if (bytesCopied < bufferSize && File::fillReadBuffer())
+        {
+            bytesCopied += File::readFromBuffer(static_cast<unsigned char *>(buffer) + bytesCopied, bufferSize - bytesCopied);
+        }
+        File::hashData(buffer, bytesCopied);
+        return bytesCopied;
+    }
+
     uint32_t bytesRead = 0;
     Result fsError = FSFILE_Read(m_fileHandle, &bytesRead, static_cast<uint64_t>(m_offset), buffer, static_cast<uint32_t>(bufferSize));
     if (R_FAILED(fsError))
     {
-        g_fslibErrorString = string::getFormattedString("Error reading data from file: 0x%08X.", fsError);
+        fslib::error::setResult(fslib::Operation::ReadFile, fsError);
         // This needs to be corrected. Sometimes read errors will set the bytes read to -1?
         bytesRead = m_offset + bufferSize > m_fileSize ? m_fileSize - m_offset : bufferSize;
     }
+    File::hashData(buffer, bytesRead);
     m_offset += bytesRead;
     return bytesRead;
 }
 
 bool fslib::File::readLine(char *buffer, size_t bufferSize)
 {
-    if (!File::isOpenForReading())
+    if (!File::isOpenForReading() || !File::flushWriteBuffer())
+    {
+        return false;
+    }
+
+    // With a read buffer, whole chunks of the line can be scanned and copied at once.
+    if (m_readBuffer)
     {
+        size_t lineOffset = 0;
+        while (lineOffset < bufferSize)
+        {
+            if (!File::offsetIsBuffered() && !File::fillReadBuffer())
+            {
+                return false;
+            }
+
+            const char *bufferedData = reinterpret_cast<const char *>(&m_readBuffer[m_offset - m_readBufferOffset]);
+            size_t bytesAvailable = m_readBufferLength - (m_offset - m_readBufferOffset);
+            size_t searchLength = std::min(bytesAvailable, bufferSize - lineOffset);
+
+            const char *lineBreak = findLineBreak(bufferedData, searchLength);
+            size_t copyLength = lineBreak ? lineBreak - bufferedData : searchLength;
+            std::memcpy(&buffer[lineOffset], bufferedData, copyLength);
+            // The line break is consumed too, so it needs to be hashed along with the line.
+            File::hashData(bufferedData, lineBreak ? copyLength + 1 : copyLength);
+            lineOffset += copyLength;
+            m_offset += copyLength;
+
+            if (lineBreak)
+            {
+                // Skip the line break so the next call starts on the next line.
+                ++m_offset;
+                return true;
+            }
+        }
         return false;
     }
 
@@ -161,12 +251,35 @@ bool fslib::File::readLine(std::string &line)
     // Clear line first.
     line.clear();
 
-    if (!File::isOpenForReading())
+    if (!File::isOpenForReading() || !File::flushWriteBuffer())
     {
         // lol i just erased the line for nothing.
         return false;
     }
 
+    if (m_readBuffer)
+    {
+        while (File::offsetIsBuffered() || File::fillReadBuffer())
+        {
+            const char *bufferedData = reinterpret_cast<const char *>(&m_readBuffer[m_offset - m_readBufferOffset]);
+            size_t bytesAvailable = m_readBufferLength - (m_offset - m_readBufferOffset);
+
+            const char *lineBreak = findLineBreak(bufferedData, bytesAvailable);
+            size_t copyLength = lineBreak ? lineBreak - bufferedData : bytesAvailable;
+            line.append(bufferedData, copyLength);
+            // The line break is consumed too, so it needs to be hashed along with the line.
+            File::hashData(bufferedData, lineBreak ? copyLength + 1 : copyLength);
+            m_offset += copyLength;
+
+            if (lineBreak)
+            {
+                ++m_offset;
+                return true;
+            }
+        }
+        return false;
+    }
+
     signed char nextByte = 0x00;
     while ((nextByte = File::getByte()) != -1)
     {
@@ -181,26 +294,181 @@ bool fslib::File::readLine(std::string &line)
 
 signed char fslib::File::getByte(void)
 {
-    if (!File::isOpenForReading() || m_offset >= m_fileSize)
+    if (!File::isOpenForReading() || m_offset >= m_fileSize || !File::flushWriteBuffer())
     {
         return -1;
     }
 
+    if (m_readBuffer)
+    {
+        if (!File::offsetIsBuffered() && !File::fillReadBuffer())
+        {
+            return -1;
+        }
+        unsigned char byte = m_readBuffer[m_offset++ - m_readBufferOffset];
+        File::hashData(&byte, 1);
+        return static_cast<signed char>(byte);
+    }
+
     // This is all needed to read stuff. I'm not calling another function here just to read 1 byte.
     char byteRead = 0x00;
     uint32_t bytesRead = 0;
     Result fsError = FSFILE_Read(m_fileHandle, &bytesRead, m_offset++, &byteRead, 1);
     if (R_FAILED(fsError))
     {
-        g_fslibErrorString = string::getFormattedString("Error reading byte from file: 0x%08X.", fsError);
+        fslib::error::setResult(fslib::Operation::ReadFile, fsError);
         return -1;
     }
+    File::hashData(&byteRead, 1);
     return byteRead;
 }
 
+ssize_t fslib::File::readv(std::span<const fslib::ReadVector> vectors)
+{
+    if (!m_isOpen || !File::isOpenForReading() || !File::flushWriteBuffer())
+    {
+        return -1;
+    }
+
+    if (m_offset >= m_fileSize)
+    {
+        return 0;
+    }
+
+    int64_t totalSize = std::min(static_cast<int64_t>(getVectorSize(vectors)), m_fileSize - m_offset);
+    if (totalSize == 0)
+    {
+        return 0;
+    }
+
+    // Lots of small buffers are cheaper to read in one go and split up after.
+    std::unique_ptr<unsigned char[]> stagingBuffer;
+    if (vectors.size() > 1 && totalSize <= static_cast<int64_t>(VECTOR_STAGING_LIMIT))
+    {
+        stagingBuffer.reset(new (std::nothrow) unsigned char[totalSize]);
+    }
+
+    if (stagingBuffer)
+    {
+        uint32_t bytesRead = 0;
+        Result fsError = FSFILE_Read(m_fileHandle, &bytesRead, m_offset, stagingBuffer.get(), static_cast<uint32_t>(totalSize));
+        if (R_FAILED(fsError))
+        {
+            fslib::error::setResult(fslib::Operation::ReadFile, fsError);
+            return -1;
+        }
+
+        // Split it up.
+        size_t stagingOffset = 0;
+        for (const fslib::ReadVector &vector : vectors)
+        {
+            if (stagingOffset >= bytesRead)
+            {
+                break;
+            }
+
+            size_t copySize = std::min(vector.bufferSize, bytesRead - stagingOffset);
+            std::memcpy(vector.buffer, &stagingBuffer[stagingOffset], copySize);
+            stagingOffset += copySize;
+        }
+        File::hashData(stagingBuffer.get(), bytesRead);
+        m_offset += bytesRead;
+        return bytesRead;
+    }
+
+    int64_t totalBytesRead = 0;
+    for (const fslib::ReadVector &vector : vectors)
+    {
+        uint32_t readSize = std::min(static_cast<int64_t>(vector.bufferSize), totalSize - totalBytesRead);
+        if (readSize == 0)
+        {
+            break;
+        }
+
+        uint32_t bytesRead = 0;
+        Result fsError = FSFILE_Read(m_fileHandle, &bytesRead, m_offset, vector.buffer, readSize);
+        if (R_FAILED(fsError))
+        {
+            fslib::error::setResult(fslib::Operation::ReadFile, fsError);
+            return -1;
+        }
+        File::hashData(vector.buffer, bytesRead);
+        m_offset += bytesRead;
+        totalBytesRead += bytesRead;
+
+        if (bytesRead < readSize)
+        {
+            break;
+        }
+    }
+    return totalBytesRead;
+}
+
+ssize_t fslib::File::readAt(int64_t offset, void *buffer, size_t bufferSize)
+{
+    if (!m_isOpen || !File::isOpenForReading())
+    {
+        return -1;
+    }
+
+    // writeAt can change the size from another thread.
+    int64_t fileSize = std::atomic_ref<int64_t>(m_fileSize).load(std::memory_order_acquire);
+    if (offset < 0 || offset >= fileSize)
+    {
+        return 0;
+    }
+    else if (offset + static_cast<int64_t>(bufferSize) > fileSize)
+    {
+        bufferSize = fileSize - offset;
+    }
+
+    uint32_t bytesRead = 0;
+    Result fsError = FSFILE_Read(m_fileHandle, &bytesRead, static_cast<uint64_t>(offset), buffer, static_cast<uint32_t>(bufferSize));
+    if (R_FAILED(fsError))
+    {
+        fslib::error::setResult(fslib::Operation::ReadFile, fsError);
+        return -1;
+    }
+    return bytesRead;
+}
+
 ssize_t fslib::File::write(const void *buffer, size_t bufferSize)
 {
-    if (!File::isOpenForWriting() || !File::resizeIfNeeded(bufferSize))
+    if (!File::isOpenForWriting())
+    {
+        return -1;
+    }
+
+    // Whatever is in the read buffer might be stale after this.
+    m_readBufferLength = 0;
+
+    // Small writes are merged in the write buffer if it's enabled. Every seek and read flushes it, so the data in it always ends at
+    // the current offset.
+    if (m_writeBuffer && bufferSize < m_writeBufferSize)
+    {
+        if (m_writeBufferLength + bufferSize > m_writeBufferSize && !File::flushWriteBuffer())
+        {
+            return -1;
+        }
+
+        if (m_writeBufferLength == 0)
+        {
+            m_writeBufferOffset = m_offset;
+        }
+
+        std::memcpy(&m_writeBuffer[m_writeBufferLength], buffer, bufferSize);
+        m_writeBufferLength += bufferSize;
+        m_offset += bufferSize;
+        // The file isn't resized until the buffer is flushed, but it should look like it was.
+        if (m_offset > m_fileSize)
+        {
+            m_fileSize = m_offset;
+        }
+        return bufferSize;
+    }
+
+    // Anything already buffered needs to go first to keep everything in order.
+    if (!File::flushWriteBuffer() || !File::resizeIfNeeded(m_offset, bufferSize))
     {
         return -1;
     }
@@ -209,13 +477,127 @@ ssize_t fslib::File::write(const void *buffer, size_t bufferSize)
     Result fsError = FSFILE_Write(m_fileHandle, &bytesWritten, m_offset, buffer, bufferSize, 0);
     if (R_FAILED(fsError))
     {
-        g_fslibErrorString = string::getFormattedString("Error writing to file: 0x%08X.", fsError);
+        fslib::error::setResult(fslib::Operation::WriteFile, fsError);
         return -1;
     }
     m_offset += bytesWritten;
     return bytesWritten;
 }
 
+ssize_t fslib::File::writev(std::span<const fslib::WriteVector> vectors)
+{
+    // The file only needs to be resized once for everything.
+    size_t totalSize = getVectorSize(vectors);
+    if (!m_isOpen || !File::isOpenForWriting() || !File::flushWriteBuffer() || !File::resizeIfNeeded(m_offset, totalSize))
+    {
+        return -1;
+    }
+
+    // Whatever is in the read buffer might be stale after this.
+    m_readBufferLength = 0;
+
+    // Lots of small buffers are cheaper to merge and write in one go.
+    std::unique_ptr<unsigned char[]> stagingBuffer;
+    if (vectors.size() > 1 && totalSize <= VECTOR_STAGING_LIMIT)
+    {
+        stagingBuffer.reset(new (std::nothrow) unsigned char[totalSize]);
+    }
+
+    if (stagingBuffer)
+    {
+        size_t stagingOffset = 0;
+        for (const fslib::WriteVector &vector : vectors)
+        {
+            std::memcpy(&stagingBuffer[stagingOffset], vector.buffer, vector.bufferSize);
+            stagingOffset += vector.bufferSize;
+        }
+
+        uint32_t bytesWritten = 0;
+        Result fsError = FSFILE_Write(m_fileHandle, &bytesWritten, m_offset, stagingBuffer.get(), static_cast<uint32_t>(totalSize), 0);
+        if (R_FAILED(fsError))
+        {
+            fslib::error::setResult(fslib::Operation::WriteFile, fsError);
+            return -1;
+        }
+        m_offset += bytesWritten;
+        return bytesWritten;
+    }
+
+    int64_t totalBytesWritten = 0;
+    for (const fslib::WriteVector &vector : vectors)
+    {
+        uint32_t bytesWritten = 0;
+        Result fsError = FSFILE_Write(m_fileHandle, &bytesWritten, m_offset, vector.buffer, static_cast<uint32_t>(vector.bufferSize), 0);
+        if (R_FAILED(fsError))
+        {
+            fslib::error::setResult(fslib::Operation::WriteFile, fsError);
+            return -1;
+        }
+        m_offset += bytesWritten;
+        totalBytesWritten += bytesWritten;
+    }
+    return totalBytesWritten;
+}
+
+ssize_t fslib::File::writeAt(int64_t offset, const void *buffer, size_t bufferSize)
+{
+    if (!m_isOpen || !File::isOpenForWriting())
+    {
+        return -1;
+    }
+
+    if (offset < 0)
+    {
+        fslib::error::setReason(fslib::Operation::WriteFile, "Invalid offset passed to writeAt.");
+        return -1;
+    }
+
+    std::atomic_ref<int64_t> allocatedSize(m_allocatedSize);
+    std::atomic_ref<int64_t> fileSize(m_fileSize);
+    int64_t requiredSize = offset + static_cast<int64_t>(bufferSize);
+    // The lock is only taken when the file actually needs to grow. The size is checked again in case another thread already grew it.
+    if (requiredSize > allocatedSize.load(std::memory_order_acquire))
+    {
+        std::lock_guard<std::mutex> resizeLock(m_resizeLock);
+        int64_t currentSize = allocatedSize.load(std::memory_order_acquire);
+        if (requiredSize > currentSize)
+        {
+            int64_t newFileSize = File::getGrowthSize(requiredSize);
+            Result fsError = FSFILE_SetSize(m_fileHandle, newFileSize);
+            if (R_FAILED(fsError) && newFileSize > requiredSize)
+            {
+                newFileSize = requiredSize;
+                fsError = FSFILE_SetSize(m_fileHandle, newFileSize);
+            }
+
+            if (R_FAILED(fsError))
+            {
+                fslib::error::setResult(fslib::Operation::ResizeFile, fsError);
+                return -1;
+            }
+            allocatedSize.store(newFileSize, std::memory_order_release);
+        }
+    }
+
+    uint32_t bytesWritten = 0;
+    Result fsError = FSFILE_Write(m_fileHandle, &bytesWritten, static_cast<uint64_t>(offset), buffer, static_cast<uint32_t>(bufferSize), 0);
+    if (R_FAILED(fsError))
+    {
+        fslib::error::setResult(fslib::Operation::WriteFile, fsError);
+        return -1;
+    }
+
+    // Only raise the size. Another thread might have written further already.
+    int64_t currentFileSize = fileSize.load(std::memory_order_acquire);
+    while (requiredSize > currentFileSize && !fileSize.compare_exchange_weak(currentFileSize, requiredSize, std::memory_order_acq_rel))
+    {
+        // compare_exchange_weak reloads currentFileSize when it fails.
+    }
+    // Anything in the read buffer might be stale now.
+    std::atomic_ref<size_t>(m_readBufferLength).store(0, std::memory_order_release);
+    return bytesWritten;
+}
+
 bool fslib::File::writef(const char *format, ...)
 {
     char vaBuffer[VA_BUFFER_SIZE] = {0};
@@ -243,7 +625,13 @@ fslib::File &fslib::File::operator<<(const std::string &string)
 
 bool fslib::File::putByte(char byte)
 {
-    if (!File::isOpenForWriting() || !File::resizeIfNeeded(1))
+    // This is exactly what the write buffer is for.
+    if (m_writeBuffer)
+    {
+        return File::write(&byte, 1) == 1;
+    }
+
+    if (!File::isOpenForWriting() || !File::resizeIfNeeded(m_offset, 1))
     {
         return false;
     }
@@ -252,15 +640,16 @@ bool fslib::File::putByte(char byte)
     Result fsError = FSFILE_Write(m_fileHandle, &bytesWritten, m_offset++, &byte, 1, 0);
     if (R_FAILED(fsError))
     {
-        g_fslibErrorString = string::getFormattedString("Error writing byte to file: 0x%08X.", fsError);
+        fslib::error::setResult(fslib::Operation::WriteFile, fsError);
         return false;
     }
+    m_readBufferLength = 0;
     return true;
 }
 
 bool fslib::File::flush(void)
 {
-    if (!File::isOpenForWriting())
+    if (!File::isOpenForWriting() || !File::flushWriteBuffer() || !File::trimToSize())
     {
         return false;
     }
@@ -268,12 +657,35 @@ bool fslib::File::flush(void)
     Result fsError = FSFILE_Flush(m_fileHandle);
     if (R_FAILED(fsError))
     {
-        g_fslibErrorString = string::getFormattedString("Error flushing file: 0x%08X.", fsError);
+        fslib::error::setResult(fslib::Operation::FlushFile, fsError);
         return false;
     }
     return true;
 }
 
+bool fslib::File::setReadBufferSize(size_t bufferSize)
+{
+    // Whatever was buffered is gone either way.
+    m_readBufferLength = 0;
+
+    if (bufferSize == 0)
+    {
+        m_readBuffer.reset();
+        m_readBufferSize = 0;
+        return true;
+    }
+
+    m_readBuffer.reset(new (std::nothrow) unsigned char[bufferSize]);
+    if (!m_readBuffer)
+    {
+        m_readBufferSize = 0;
+        fslib::error::setReason(fslib::Operation::SetBufferSize, "Couldn't allocate read buffer.");
+        return false;
+    }
+    m_readBufferSize = bufferSize;
+    return true;
+}
+
 void fslib::File::ensureOffsetIsValid(void)
 {
     if (m_offset < 0)
@@ -286,24 +698,188 @@ void fslib::File::ensureOffsetIsValid(void)
     }
 }
 
-bool fslib::File::resizeIfNeeded(size_t bufferSize)
+bool fslib::File::setWriteBufferSize(size_t bufferSize)
 {
-    size_t spaceRemaining = m_fileSize - m_offset;
+    // Pending data has to be written before the buffer can be replaced.
+    if (!File::flushWriteBuffer())
+    {
+        return false;
+    }
+
+    if (bufferSize == 0)
+    {
+        m_writeBuffer.reset();
+        m_writeBufferSize = 0;
+        return true;
+    }
+
+    m_writeBuffer.reset(new (std::nothrow) unsigned char[bufferSize]);
+    if (!m_writeBuffer)
+    {
+        m_writeBufferSize = 0;
+        fslib::error::setReason(fslib::Operation::SetBufferSize, "Couldn't allocate write buffer.");
+        return false;
+    }
+    m_writeBufferSize = bufferSize;
+    return true;
+}
 
-    // Everything is fine.
-    if (spaceRemaining >= m_fileSize)
+bool fslib::File::flushWriteBuffer(void)
+{
+    if (m_writeBufferLength == 0)
     {
         return true;
     }
 
-    uint64_t newFileSize = m_offset + bufferSize;
-    Result fsError = FSFILE_SetSize(m_fileHandle, newFileSize);
+    // The buffer is emptied no matter what so a failure doesn't get retried forever.
+    size_t writeLength = m_writeBufferLength;
+    m_writeBufferLength = 0;
+
+    if (!File::resizeIfNeeded(m_writeBufferOffset, writeLength))
+    {
+        return false;
+    }
+
+    uint32_t bytesWritten = 0;
+    Result fsError = FSFILE_Write(m_fileHandle, &bytesWritten, m_writeBufferOffset, m_writeBuffer.get(), writeLength, 0);
+    if (R_FAILED(fsError) || bytesWritten != writeLength)
+    {
+        fslib::error::setResult(fslib::Operation::WriteFile, fsError);
+        return false;
+    }
+    return true;
+}
+
+void fslib::File::setHasher(fslib::Hasher *hasher)
+{
+    m_hasher = hasher;
+}
+
+void fslib::File::setGrowthPolicy(uint8_t growthMode, int64_t extentSize, int64_t maxGrowth)
+{
+    m_growthMode = growthMode;
+    // An extent size of 0 would never grow anything.
+    m_extentSize = extentSize > 0 ? extentSize : 1;
+    m_maxGrowth = maxGrowth;
+}
+
+bool fslib::File::resizeIfNeeded(int64_t offset, size_t bufferSize)
+{
+    int64_t requiredSize = offset + static_cast<int64_t>(bufferSize);
+
+    // Only resize when it won't fit. This also keeps Extra Data, which can't be resized, working as long as it was created big enough.
+    if (requiredSize > m_allocatedSize)
+    {
+        int64_t newFileSize = File::getGrowthSize(requiredSize);
+        Result fsError = FSFILE_SetSize(m_fileHandle, newFileSize);
+        // Growing past what's needed can fail when what's needed wouldn't. Save archives with little space left are an example.
+        if (R_FAILED(fsError) && newFileSize > requiredSize)
+        {
+            newFileSize = requiredSize;
+            fsError = FSFILE_SetSize(m_fileHandle, newFileSize);
+        }
+
+        if (R_FAILED(fsError))
+        {
+            fslib::error::setResult(fslib::Operation::ResizeFile, fsError);
+            return false;
+        }
+        m_allocatedSize = newFileSize;
+    }
+
+    // The file can be bigger than this on the device, but only what's been written counts as its size.
+    if (requiredSize > m_fileSize)
+    {
+        m_fileSize = requiredSize;
+    }
+    return true;
+}
+
+int64_t fslib::File::getGrowthSize(int64_t requiredSize) const
+{
+    int64_t growth = 0;
+    switch (m_growthMode)
+    {
+        case File::growDouble:
+        {
+            growth = m_allocatedSize;
+        }
+        break;
+
+        case File::growFixed:
+        {
+            // Round what's missing up to the next extent.
+            int64_t shortfall = requiredSize - m_allocatedSize;
+            growth = ((shortfall + m_extentSize - 1) / m_extentSize) * m_extentSize;
+        }
+        break;
+
+        default:
+        {
+            return requiredSize;
+        }
+        break;
+    }
+
+    if (m_maxGrowth > 0 && growth > m_maxGrowth)
+    {
+        growth = m_maxGrowth;
+    }
+    // No matter what, the write needs to fit.
+    return std::max(m_allocatedSize + growth, requiredSize);
+}
+
+bool fslib::File::trimToSize(void)
+{
+    if (m_allocatedSize <= m_fileSize)
+    {
+        return true;
+    }
+
+    Result fsError = FSFILE_SetSize(m_fileHandle, m_fileSize);
     if (R_FAILED(fsError))
     {
-        g_fslibErrorString = string::getFormattedString("Error resizing file to it buffer: 0x%08X.", fsError);
+        fslib::error::setResult(fslib::Operation::ResizeFile, fsError);
         return false;
     }
-    // Make sure to update file size.
-    m_fileSize = newFileSize;
+    m_allocatedSize = m_fileSize;
     return true;
 }
+
+bool fslib::File::fillReadBuffer(void)
+{
+    // Reset first so a failed read doesn't leave old data looking valid.
+    m_readBufferLength = 0;
+
+    // Don't buffer anything past the real end of the file.
+    if (m_offset >= m_fileSize)
+    {
+        return false;
+    }
+    uint32_t readSize = static_cast<uint32_t>(std::min(static_cast<int64_t>(m_readBufferSize), m_fileSize - m_offset));
+
+    uint32_t bytesRead = 0;
+    Result fsError = FSFILE_Read(m_fileHandle, &bytesRead, m_offset, m_readBuffer.get(), readSize);
+    if (R_FAILED(fsError) || bytesRead > readSize)
+    {
+        fslib::error::setResult(fslib::Operation::ReadFile, fsError);
+        return false;
+    }
+    m_readBufferOffset = m_offset;
+    m_readBufferLength = bytesRead;
+    return bytesRead > 0;
+}
+
+size_t fslib::File::readFromBuffer(void *buffer, size_t bufferSize)
+{
+    if (!File::offsetIsBuffered())
+    {
+        return 0;
+    }
+
+    size_t bufferOffset = m_offset - m_readBufferOffset;
+    size_t bytesToCopy = std::min(m_readBufferLength - bufferOffset, bufferSize);
+    std::memcpy(buffer, &m_readBuffer[bufferOffset], bytesToCopy);
+    m_offset += bytesToCopy;
+    return bytesToCopy;
+}
@@ -1,7 +1,4 @@
 #include "fslib.hpp"
-#include "string.hpp"
-
-extern std::string g_fslibErrorString;
 
 bool fslib::createFile(const fslib::Path &filePath, uint64_t fileSize)
 {
@@ -14,7 +11,7 @@ bool fslib::createFile(const fslib::Path &filePath, uint64_t fileSize)
     Result fsError = FSUSER_CreateFile(archive, filePath.getPath(), 0, fileSize);
     if (R_FAILED(fsError))
     {
-        g_fslibErrorString = string::getFormattedString("Error creating file: 0x%08X.", fsError);
+        fslib::error::setResult(fslib::Operation::CreateFile, fsError, filePath);
         return false;
     }
     return true;
@@ -28,10 +25,12 @@ bool fslib::fileExists(const fslib::Path &filePath)
         return false;
     }
 
+    // getEntryInfo would try this path as a directory too. One open is all this needs.
     Handle fileHandle;
     Result fsError = FSUSER_OpenFile(&fileHandle, archive, filePath.getPath(), FS_OPEN_READ, 0);
     if (R_FAILED(fsError))
     {
+        fslib::error::setResult(fslib::Operation::OpenFile, fsError, filePath);
         return false;
     }
     FSFILE_Close(fileHandle);
@@ -40,28 +39,83 @@ bool fslib::fileExists(const fslib::Path &filePath)
 
 bool fslib::getFileSize(const fslib::Path &filePath, uint64_t &fileSizeOut)
 {
-    FS_Archive archive;
-    if (!fslib::processDeviceAndPath(filePath, &archive))
+    fslib::EntryInfo entryInfo;
+    if (!fslib::getEntryInfo(filePath, entryInfo, ENTRY_INFO_SIZE))
     {
         return false;
     }
 
-    Handle fileHandle;
-    Result fsError = FSUSER_OpenFile(&fileHandle, archive, filePath.getPath(), FS_OPEN_READ, 0);
-    if (R_FAILED(fsError))
+    if (entryInfo.isDirectory)
     {
-        g_fslibErrorString = string::getFormattedString("Error opening file: 0x%08X.", fsError);
+        fslib::error::setReason(fslib::Operation::GetFileSize, "Path is a directory.", filePath);
         return false;
     }
+    fileSizeOut = entryInfo.size;
+    return true;
+}
 
-    fsError = FSFILE_GetSize(fileHandle, &fileSizeOut);
-    if (R_FAILED(fsError))
+bool fslib::getEntryInfo(const fslib::Path &entryPath, fslib::EntryInfo &infoOut, uint8_t infoFlags)
+{
+    FS_Archive archive;
+    if (!fslib::processDeviceAndPath(entryPath, &archive))
     {
-        FSFILE_Close(fileHandle);
-        g_fslibErrorString = string::getFormattedString("Error getting file's size: 0x%08X.", fsError);
         return false;
     }
-    FSFILE_Close(fileHandle);
+
+    infoOut = {};
+
+    Handle entryHandle;
+    Result openError = FSUSER_OpenFile(&entryHandle, archive, entryPath.getPath(), FS_OPEN_READ, 0);
+    Result fsError = openError;
+    if (R_SUCCEEDED(fsError))
+    {
+        if (infoFlags & ENTRY_INFO_SIZE)
+        {
+            fsError = FSFILE_GetSize(entryHandle, &infoOut.size);
+        }
+        FSFILE_Close(entryHandle);
+
+        if (R_FAILED(fsError))
+        {
+            fslib::error::setResult(fslib::Operation::GetFileSize, fsError, entryPath);
+            return false;
+        }
+    }
+    else
+    {
+        fsError = FSUSER_OpenDirectory(&entryHandle, archive, entryPath.getPath());
+        if (R_FAILED(fsError) && (infoFlags & ENTRY_INFO_SIZE))
+        {
+            // It isn't a directory either, so the file's error is the one that explains why its size couldn't be read.
+            fslib::error::setResult(fslib::Operation::OpenFile, openError, entryPath);
+            return false;
+        }
+        else if (R_FAILED(fsError))
+        {
+            fslib::error::setResult(fslib::Operation::GetEntryInfo, fsError, entryPath);
+            return false;
+        }
+        FSDIR_Close(entryHandle);
+        infoOut.isDirectory = true;
+    }
+
+    if (infoFlags & ENTRY_INFO_TIMESTAMPS)
+    {
+        // Not every archive supports this, so failing isn't an error.
+        FS_Path path = entryPath.getPath();
+        uint64_t timestamp = 0;
+        fsError = FSUSER_ControlArchive(archive,
+                                        ARCHIVE_ACTION_GET_TIMESTAMP,
+                                        const_cast<void *>(path.data),
+                                        path.size,
+                                        &timestamp,
+                                        sizeof(uint64_t));
+        if (R_SUCCEEDED(fsError))
+        {
+            infoOut.hasTimestamps = true;
+            infoOut.modified = timestamp;
+        }
+    }
     return true;
 }
 
@@ -77,7 +131,7 @@ bool fslib::renameFile(const fslib::Path &oldPath, const fslib::Path &newPath)
     Result fsError = FSUSER_RenameFile(archiveA, oldPath.getPath(), archiveB, newPath.getPath());
     if (R_FAILED(fsError))
     {
-        g_fslibErrorString = string::getFormattedString("Error renaming file: 0x%08X.", fsError);
+        fslib::error::setResult(fslib::Operation::RenameFile, fsError, oldPath);
         return false;
     }
     return true;
@@ -94,7 +148,7 @@ bool fslib::deleteFile(const fslib::Path &filePath)
     Result fsError = FSUSER_DeleteFile(archive, filePath.getPath());
     if (R_FAILED(fsError))
     {
-        g_fslibErrorString = string::getFormattedString("Error deleting file: 0x%08X.", fsError);
+        fslib::error::setResult(fslib::Operation::DeleteFile, fsError, filePath);
         return false;
     }
     return true;
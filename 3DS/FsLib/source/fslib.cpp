@@ -1,23 +1,169 @@
 #include "fslib.hpp"
-#include "string.hpp"
 #include <3ds.h>
-#include <unordered_map>
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <mutex>
 
 namespace
 {
-    // 3DS can use UTF-16 paths so that's what we're using.
-    std::unordered_map<std::u16string_view, FS_Archive> s_deviceMap;
+    // Most archives that can be mapped at once.
+    constexpr size_t DEVICE_SLOT_COUNT = 32;
+    // Device names are stored as zero padded words so lookups can read them without taking the lock.
+    constexpr size_t DEVICE_NAME_WORDS = 8;
+    constexpr size_t DEVICE_NAME_LENGTH = DEVICE_NAME_WORDS * sizeof(uint32_t) / sizeof(char16_t);
+    // Device IDs are the slot in the low byte and how many times the slot has been mapped in the rest.
+    constexpr uint32_t DEVICE_ID_SLOT_BITS = 8;
+    constexpr uint32_t DEVICE_ID_SLOT_MASK = (1 << DEVICE_ID_SLOT_BITS) - 1;
+    constexpr uint32_t DEVICE_ID_MAX_MOUNT_COUNT = 0xFFFFFFFF >> DEVICE_ID_SLOT_BITS;
+
+    using DeviceName = std::array<uint32_t, DEVICE_NAME_WORDS>;
+
+    // The device ID works as the slot's sequence lock. It's 0 while the slot is free, so the name can only change while lookups are
+    // skipping the slot. Lookups that race a close and remap see a different ID when they check again and ignore what they read.
+    // This only protects the lookup itself. Nothing stops a close from happening while the archive a lookup returned is in use.
+    struct DeviceSlot
+    {
+            std::atomic<uint32_t> deviceID = fslib::INVALID_DEVICE_ID;
+            std::array<std::atomic<uint32_t>, DEVICE_NAME_WORDS> name;
+            FS_Archive archive = 0;
+            // Only touched with the lock held.
+            uint32_t mountCount = 0;
+    };
+
+    std::array<DeviceSlot, DEVICE_SLOT_COUNT> s_deviceSlots;
+    // Taken by anything that maps or closes a device. Lookups never take it.
+    std::mutex s_deviceLock;
     // This only works because the string is so short.
     constexpr std::u16string_view SDMC_DEVICE_NAME = u"sdmc";
 } // namespace
 
-// Globally shared error string.
-std::string g_fslibErrorString = "No errors encountered.";
+// Copies deviceName into a zero padded DeviceName. Returns false if it's empty or too long to store.
+static bool encodeDeviceName(std::u16string_view deviceName, DeviceName &nameOut)
+{
+    if (deviceName.empty() || deviceName.length() > DEVICE_NAME_LENGTH)
+    {
+        return false;
+    }
+    nameOut.fill(0);
+    std::memcpy(nameOut.data(), deviceName.data(), deviceName.length() * sizeof(char16_t));
+    return true;
+}
 
-// Checks if device is already in map.
-static inline bool deviceNameIsInUse(std::u16string_view deviceName)
+// Returns the slot deviceID is mapped to. nullptr if the ID is stale or invalid.
+static DeviceSlot *findSlot(uint32_t deviceID)
 {
-    return s_deviceMap.find(deviceName) != s_deviceMap.end();
+    size_t slotIndex = deviceID & DEVICE_ID_SLOT_MASK;
+    if (deviceID == fslib::INVALID_DEVICE_ID || slotIndex >= DEVICE_SLOT_COUNT)
+    {
+        return nullptr;
+    }
+
+    DeviceSlot &slot = s_deviceSlots[slotIndex];
+    return slot.deviceID.load(std::memory_order_acquire) == deviceID ? &slot : nullptr;
+}
+
+// Searches the slots for deviceName without locking.
+static uint32_t findDeviceID(std::u16string_view deviceName)
+{
+    DeviceName name;
+    if (!encodeDeviceName(deviceName, name))
+    {
+        return fslib::INVALID_DEVICE_ID;
+    }
+
+    for (DeviceSlot &slot : s_deviceSlots)
+    {
+        uint32_t deviceID = slot.deviceID.load(std::memory_order_acquire);
+        if (deviceID == fslib::INVALID_DEVICE_ID)
+        {
+            continue;
+        }
+
+        bool nameMatches = true;
+        for (size_t i = 0; i < DEVICE_NAME_WORDS; i++)
+        {
+            nameMatches = slot.name[i].load(std::memory_order_relaxed) == name[i] && nameMatches;
+        }
+
+        // The name only counts if the slot wasn't closed or remapped while it was being read.
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (nameMatches && slot.deviceID.load(std::memory_order_relaxed) == deviceID)
+        {
+            return deviceID;
+        }
+    }
+    return fslib::INVALID_DEVICE_ID;
+}
+
+// Returns the name stored in slot. Only called with the lock held.
+static std::u16string getSlotName(const DeviceSlot &slot)
+{
+    char16_t name[DEVICE_NAME_LENGTH];
+    for (size_t i = 0; i < DEVICE_NAME_WORDS; i++)
+    {
+        uint32_t nameWord = slot.name[i].load(std::memory_order_relaxed);
+        std::memcpy(&name[i * sizeof(uint32_t) / sizeof(char16_t)], &nameWord, sizeof(uint32_t));
+    }
+
+    size_t nameLength = 0;
+    while (nameLength < DEVICE_NAME_LENGTH && name[nameLength] != 0)
+    {
+        ++nameLength;
+    }
+    return std::u16string(name, nameLength);
+}
+
+// Places archive in a free slot under deviceName. Only called with the lock held.
+static uint32_t addDevice(std::u16string_view deviceName, FS_Archive archive)
+{
+    DeviceName name;
+    if (!encodeDeviceName(deviceName, name))
+    {
+        fslib::error::setReason(fslib::Operation::MapDevice, "Device names need to be between 1 and 16 characters.", deviceName);
+        return fslib::INVALID_DEVICE_ID;
+    }
+
+    for (size_t i = 0; i < DEVICE_SLOT_COUNT; i++)
+    {
+        DeviceSlot &slot = s_deviceSlots[i];
+        if (slot.deviceID.load(std::memory_order_relaxed) != fslib::INVALID_DEVICE_ID)
+        {
+            continue;
+        }
+
+        // Everything written here has to be visible before the ID is.
+        std::atomic_thread_fence(std::memory_order_release);
+        slot.archive = archive;
+        for (size_t j = 0; j < DEVICE_NAME_WORDS; j++)
+        {
+            slot.name[j].store(name[j], std::memory_order_relaxed);
+        }
+
+        // The mount count starts over at 1 so an ID is never 0.
+        slot.mountCount = slot.mountCount % DEVICE_ID_MAX_MOUNT_COUNT + 1;
+        uint32_t deviceID = (slot.mountCount << DEVICE_ID_SLOT_BITS) | i;
+        slot.deviceID.store(deviceID, std::memory_order_release);
+        return deviceID;
+    }
+    fslib::error::setReason(fslib::Operation::MapDevice, "No device slots are free.", deviceName);
+    return fslib::INVALID_DEVICE_ID;
+}
+
+// Closes the archive in slot and frees it. Only called with the lock held.
+static bool closeSlot(DeviceSlot &slot)
+{
+    Result fsError = FSUSER_CloseArchive(slot.archive);
+    if (R_FAILED(fsError))
+    {
+        fslib::error::setResult(fslib::Operation::CloseDevice, fsError);
+        return false;
+    }
+
+    // Paths still caching the old ID will look the device up again.
+    slot.deviceID.store(fslib::INVALID_DEVICE_ID, std::memory_order_release);
+    fslib::forgetKnownDirectories(getSlotName(slot));
+    return true;
 }
 
 bool fslib::initialize(void)
@@ -26,86 +172,126 @@ bool fslib::initialize(void)
     Result fsError = fsInit();
     if (R_FAILED(fsError))
     {
-        g_fslibErrorString = string::getFormattedString("Error initializing FS service: 0x%08X.", fsError);
+        fslib::error::setResult(fslib::Operation::Initialize, fsError);
         return false;
     }
     // Open sdmc
-    fsError = FSUSER_OpenArchive(&s_deviceMap[SDMC_DEVICE_NAME], ARCHIVE_SDMC, {PATH_EMPTY, 0x00, NULL});
+    FS_Archive sdmc;
+    fsError = FSUSER_OpenArchive(&sdmc, ARCHIVE_SDMC, {PATH_EMPTY, 0x00, NULL});
     if (R_FAILED(fsError))
     {
-        g_fslibErrorString = string::getFormattedString("Error opening SDMC archive: 0x%08X.", fsError);
+        fslib::error::setResult(fslib::Operation::OpenArchive, fsError, SDMC_DEVICE_NAME);
+        return true;
     }
-    return true;
+
+    std::lock_guard<std::mutex> deviceLock(s_deviceLock);
+    return addDevice(SDMC_DEVICE_NAME, sdmc) != fslib::INVALID_DEVICE_ID;
 }
 
 void fslib::exit(void)
 {
-    for (auto &[deviceName, archive] : s_deviceMap)
+    // Requests still running could be using the archives about to be closed.
+    fslib::async::exit();
+
     {
-        FSUSER_CloseArchive(archive);
+        std::lock_guard<std::mutex> deviceLock(s_deviceLock);
+        for (DeviceSlot &slot : s_deviceSlots)
+        {
+            if (slot.deviceID.load(std::memory_order_relaxed) != fslib::INVALID_DEVICE_ID)
+            {
+                FSUSER_CloseArchive(slot.archive);
+                slot.deviceID.store(fslib::INVALID_DEVICE_ID, std::memory_order_release);
+            }
+        }
     }
     fsExit();
 }
 
-const char *fslib::getErrorString(void)
-{
-    return g_fslibErrorString.c_str();
-}
-
 bool fslib::mapArchiveToDevice(std::u16string_view deviceName, FS_Archive archive)
 {
     // Guard against overwriting sdmc
     if (deviceName == u"sdmc")
     {
-        g_fslibErrorString = "Error mapping device: sdmc is reserved device name.";
+        fslib::error::setReason(fslib::Operation::MapDevice, "sdmc is a reserved device name.", deviceName);
         return false;
     }
 
     // Close it so we don't leave an archive dangling.
-    if (deviceNameIsInUse(deviceName))
+    std::lock_guard<std::mutex> deviceLock(s_deviceLock);
+    DeviceSlot *slot = findSlot(findDeviceID(deviceName));
+    if (slot && !closeSlot(*slot))
     {
-        fslib::closeDevice(deviceName);
+        return false;
     }
     // This is just a uint64_t, so I'm not going to bother memcpying like on Switch.
-    s_deviceMap[deviceName] = archive;
+    return addDevice(deviceName, archive) != fslib::INVALID_DEVICE_ID;
+}
 
-    return true;
+uint32_t fslib::getDeviceID(std::u16string_view deviceName)
+{
+    return findDeviceID(deviceName);
 }
 
 bool fslib::getArchiveByDeviceName(std::u16string_view deviceName, FS_Archive *archiveOut)
 {
-    if (!deviceNameIsInUse(deviceName))
+    return fslib::getArchiveByDeviceID(findDeviceID(deviceName), archiveOut);
+}
+
+bool fslib::getArchiveByDeviceID(uint32_t deviceID, FS_Archive *archiveOut)
+{
+    DeviceSlot *slot = findSlot(deviceID);
+    if (!slot)
     {
         return false;
     }
-    *archiveOut = s_deviceMap[deviceName];
+    *archiveOut = slot->archive;
 
     return true;
 }
 
 bool fslib::processDeviceAndPath(const fslib::Path &path, FS_Archive *archiveOut)
 {
-    if (!path.isValid() || !deviceNameIsInUse(path.getDevice()))
+    if (!path.isValid())
     {
-        g_fslibErrorString = "Error fetching device: Invalid path supplied or device not found.";
+        fslib::error::setReason(fslib::Operation::FindDevice, "Invalid path supplied.", path);
         return false;
     }
-    *archiveOut = s_deviceMap[path.getDevice()];
+
+    // Paths that still have a valid device ID cached skip searching the slots entirely.
+    DeviceSlot *slot = findSlot(path.getDeviceCache());
+    if (!slot)
+    {
+        uint32_t deviceID = findDeviceID(path.getDevice());
+        slot = findSlot(deviceID);
+        if (!slot)
+        {
+            fslib::error::setReason(fslib::Operation::FindDevice, "Device not found.", path);
+            return false;
+        }
+        path.setDeviceCache(deviceID);
+    }
+    *archiveOut = slot->archive;
 
     return true;
 }
 
 bool fslib::controlDevice(std::u16string_view deviceName)
 {
-    if (!deviceNameIsInUse(deviceName))
+    return fslib::controlDevice(findDeviceID(deviceName));
+}
+
+bool fslib::controlDevice(uint32_t deviceID)
+{
+    DeviceSlot *slot = findSlot(deviceID);
+    if (!slot)
     {
         return false;
     }
 
-    Result fsError = FSUSER_ControlArchive(s_deviceMap[deviceName], ARCHIVE_ACTION_COMMIT_SAVE_DATA, NULL, 0, NULL, 0);
+    Result fsError = FSUSER_ControlArchive(slot->archive, ARCHIVE_ACTION_COMMIT_SAVE_DATA, NULL, 0, NULL, 0);
     if (R_FAILED(fsError))
     {
-        g_fslibErrorString = string::getFormattedString("Error committing save data to device: 0x%08X.", fsError);
+        fslib::error::setResult(fslib::Operation::CommitDevice, fsError);
         return false;
     }
 
@@ -114,19 +300,16 @@ bool fslib::controlDevice(std::u16string_view deviceName)
 
 bool fslib::closeDevice(std::u16string_view deviceName)
 {
-    if (!deviceNameIsInUse(deviceName))
-    {
-        return false;
-    }
+    return fslib::closeDevice(findDeviceID(deviceName));
+}
 
-    Result fsError = FSUSER_CloseArchive(s_deviceMap[deviceName]);
-    if (R_FAILED(fsError))
+bool fslib::closeDevice(uint32_t deviceID)
+{
+    std::lock_guard<std::mutex> deviceLock(s_deviceLock);
+    DeviceSlot *slot = findSlot(deviceID);
+    if (!slot)
     {
-        g_fslibErrorString = string::getFormattedString("Error closeing archive: 0x%08X.", fsError);
         return false;
     }
-    // Erase the device from map so deviceNameIsInUse works correctly.
-    s_deviceMap.erase(deviceName);
-
-    return true;
+    return closeSlot(*slot);
 }
@@ -0,0 +1,211 @@
+#include "hash.hpp"
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+namespace
+{
+    // Reversed polynomial used by zlib and pretty much everything else.
+    constexpr uint32_t CRC32_POLYNOMIAL = 0xEDB88320;
+
+    // Tables for slice-by-8 CRC32. The first is the normal byte table, every other one is the one before it advanced another byte.
+    constexpr std::array<std::array<uint32_t, 256>, 8> CRC32_TABLES = []() {
+        std::array<std::array<uint32_t, 256>, 8> tables{};
+        for (uint32_t i = 0; i < 256; i++)
+        {
+            uint32_t crc = i;
+            for (int j = 0; j < 8; j++)
+            {
+                crc = (crc & 1) ? (crc >> 1) ^ CRC32_POLYNOMIAL : crc >> 1;
+            }
+            tables[0][i] = crc;
+        }
+
+        for (size_t table = 1; table < 8; table++)
+        {
+            for (uint32_t i = 0; i < 256; i++)
+            {
+                uint32_t previous = tables[table - 1][i];
+                tables[table][i] = (previous >> 8) ^ tables[0][previous & 0xFF];
+            }
+        }
+        return tables;
+    }();
+
+    constexpr uint32_t SHA256_INITIAL_STATE[8] =
+        {0x6A09E667, 0xBB67AE85, 0x3C6EF372, 0xA54FF53A, 0x510E527F, 0x9B05688C, 0x1F83D9AB, 0x5BE0CD19};
+
+    constexpr uint32_t SHA256_ROUND_CONSTANTS[64] = {
+        0x428A2F98, 0x71374491, 0xB5C0FBCF, 0xE9B5DBA5, 0x3956C25B, 0x59F111F1, 0x923F82A4, 0xAB1C5ED5, 0xD807AA98, 0x12835B01, 0x243185BE,
+        0x550C7DC3, 0x72BE5D74, 0x80DEB1FE, 0x9BDC06A7, 0xC19BF174, 0xE49B69C1, 0xEFBE4786, 0x0FC19DC6, 0x240CA1CC, 0x2DE92C6F, 0x4A7484AA,
+        0x5CB0A9DC, 0x76F988DA, 0x983E5152, 0xA831C66D, 0xB00327C8, 0xBF597FC7, 0xC6E00BF3, 0xD5A79147, 0x06CA6351, 0x14292967, 0x27B70A85,
+        0x2E1B2138, 0x4D2C6DFC, 0x53380D13, 0x650A7354, 0x766A0ABB, 0x81C2C92E, 0x92722C85, 0xA2BFE8A1, 0xA81A664B, 0xC24B8B70, 0xC76C51A3,
+        0xD192E819, 0xD6990624, 0xF40E3585, 0x106AA070, 0x19A4C116, 0x1E376C08, 0x2748774C, 0x34B0BCB5, 0x391C0CB3, 0x4ED8AA4A, 0x5B9CCA4F,
+        0x682E6FF3, 0x748F82EE, 0x78A5636F, 0x84C87814, 0x8CC70208, 0x90BEFFFA, 0xA4506CEB, 0xBEF9A3F7, 0xC67178F2};
+} // namespace
+
+static inline uint32_t rotateRight(uint32_t value, int count)
+{
+    return (value >> count) | (value << (32 - count));
+}
+
+fslib::Hasher::Hasher(uint8_t hashTypes) : m_hashTypes(hashTypes)
+{
+    Hasher::reset();
+}
+
+void fslib::Hasher::reset(void)
+{
+    m_crc32 = 0;
+    m_length = 0;
+    m_sha256BlockLength = 0;
+    std::memcpy(m_sha256State, SHA256_INITIAL_STATE, sizeof(SHA256_INITIAL_STATE));
+}
+
+void fslib::Hasher::update(const void *data, size_t dataSize)
+{
+    const uint8_t *bytes = static_cast<const uint8_t *>(data);
+
+    if (m_hashTypes & Hasher::crc32)
+    {
+        uint32_t crc = ~m_crc32;
+        size_t i = 0;
+        // Eight bytes at a time. The 3DS is little endian, so the low byte of each word comes first.
+        for (; i + 8 <= dataSize; i += 8)
+        {
+            uint32_t low = 0, high = 0;
+            std::memcpy(&low, &bytes[i], 4);
+            std::memcpy(&high, &bytes[i + 4], 4);
+            low ^= crc;
+            crc = CRC32_TABLES[7][low & 0xFF] ^ CRC32_TABLES[6][(low >> 8) & 0xFF] ^ CRC32_TABLES[5][(low >> 16) & 0xFF] ^
+                  CRC32_TABLES[4][low >> 24] ^ CRC32_TABLES[3][high & 0xFF] ^ CRC32_TABLES[2][(high >> 8) & 0xFF] ^
+                  CRC32_TABLES[1][(high >> 16) & 0xFF] ^ CRC32_TABLES[0][high >> 24];
+        }
+
+        for (; i < dataSize; i++)
+        {
+            crc = (crc >> 8) ^ CRC32_TABLES[0][(crc ^ bytes[i]) & 0xFF];
+        }
+        m_crc32 = ~crc;
+    }
+
+    if (m_hashTypes & Hasher::sha256)
+    {
+        size_t i = 0;
+        // Finish off whatever block was left over from last time first.
+        if (m_sha256BlockLength > 0)
+        {
+            size_t copySize = std::min(dataSize, sizeof(m_sha256Block) - m_sha256BlockLength);
+            std::memcpy(&m_sha256Block[m_sha256BlockLength], bytes, copySize);
+            m_sha256BlockLength += copySize;
+            i = copySize;
+
+            if (m_sha256BlockLength == sizeof(m_sha256Block))
+            {
+                Hasher::sha256ProcessBlock(m_sha256State, m_sha256Block);
+                m_sha256BlockLength = 0;
+            }
+        }
+
+        // Full blocks are processed straight from Data.
+        for (; i + sizeof(m_sha256Block) <= dataSize; i += sizeof(m_sha256Block))
+        {
+            Hasher::sha256ProcessBlock(m_sha256State, &bytes[i]);
+        }
+
+        if (i < dataSize)
+        {
+            std::memcpy(m_sha256Block, &bytes[i], dataSize - i);
+            m_sha256BlockLength = dataSize - i;
+        }
+    }
+    m_length += dataSize;
+}
+
+uint32_t fslib::Hasher::getCrc32(void) const
+{
+    return m_crc32;
+}
+
+void fslib::Hasher::getSha256(uint8_t *hashOut) const
+{
+    // Padding is done on copies so the hasher can keep going afterwards.
+    uint32_t state[8];
+    std::memcpy(state, m_sha256State, sizeof(state));
+
+    uint8_t block[64] = {0};
+    std::memcpy(block, m_sha256Block, m_sha256BlockLength);
+    block[m_sha256BlockLength] = 0x80;
+    // If the length doesn't fit after the padding byte, it goes in another block.
+    if (m_sha256BlockLength >= 56)
+    {
+        Hasher::sha256ProcessBlock(state, block);
+        std::memset(block, 0x00, sizeof(block));
+    }
+
+    uint64_t bitLength = m_length * 8;
+    for (int i = 0; i < 8; i++)
+    {
+        block[63 - i] = static_cast<uint8_t>(bitLength >> (i * 8));
+    }
+    Hasher::sha256ProcessBlock(state, block);
+
+    for (int i = 0; i < 8; i++)
+    {
+        hashOut[i * 4] = static_cast<uint8_t>(state[i] >> 24);
+        hashOut[i * 4 + 1] = static_cast<uint8_t>(state[i] >> 16);
+        hashOut[i * 4 + 2] = static_cast<uint8_t>(state[i] >> 8);
+        hashOut[i * 4 + 3] = static_cast<uint8_t>(state[i]);
+    }
+}
+
+uint64_t fslib::Hasher::getLength(void) const
+{
+    return m_length;
+}
+
+void fslib::Hasher::sha256ProcessBlock(uint32_t *state, const uint8_t *block)
+{
+    uint32_t schedule[64];
+    for (int i = 0; i < 16; i++)
+    {
+        schedule[i] = (static_cast<uint32_t>(block[i * 4]) << 24) | (static_cast<uint32_t>(block[i * 4 + 1]) << 16) |
+                      (static_cast<uint32_t>(block[i * 4 + 2]) << 8) | static_cast<uint32_t>(block[i * 4 + 3]);
+    }
+
+    for (int i = 16; i < 64; i++)
+    {
+        uint32_t sigma0 = rotateRight(schedule[i - 15], 7) ^ rotateRight(schedule[i - 15], 18) ^ (schedule[i - 15] >> 3);
+        uint32_t sigma1 = rotateRight(schedule[i - 2], 17) ^ rotateRight(schedule[i - 2], 19) ^ (schedule[i - 2] >> 10);
+        schedule[i] = schedule[i - 16] + sigma0 + schedule[i - 7] + sigma1;
+    }
+
+    uint32_t a = state[0], b = state[1], c = state[2], d = state[3], e = state[4], f = state[5], g = state[6], h = state[7];
+    for (int i = 0; i < 64; i++)
+    {
+        uint32_t sum1 = rotateRight(e, 6) ^ rotateRight(e, 11) ^ rotateRight(e, 25);
+        uint32_t choice = (e & f) ^ (~e & g);
+        uint32_t temp1 = h + sum1 + choice + SHA256_ROUND_CONSTANTS[i] + schedule[i];
+        uint32_t sum0 = rotateRight(a, 2) ^ rotateRight(a, 13) ^ rotateRight(a, 22);
+        uint32_t majority = (a & b) ^ (a & c) ^ (b & c);
+        uint32_t temp2 = sum0 + majority;
+
+        h = g;
+        g = f;
+        f = e;
+        e = d + temp1;
+        d = c;
+        c = b;
+        b = a;
+        a = temp1 + temp2;
+    }
+
+    state[0] += a;
+    state[1] += b;
+    state[2] += c;
+    state[3] += d;
+    state[4] += e;
+    state[5] += f;
+    state[6] += g;
+    state[7] += h;
+}
@@ -1,4 +1,5 @@
 #include "path.hpp"
+#include "pathLiteral.hpp"
 #include "string.hpp"
 #include <algorithm>
 #include <array>
@@ -25,20 +26,18 @@ const char16_t *strpbrk16(const char16_t *string)
     return nullptr;
 }
 
-// This is an all in one version of what Switch does. Passing nullptr as PathBegin skips trimming the beginning.
-void getTrimmedPath(const char16_t *path, const char16_t **pathBegin, size_t &pathLengthOut)
+// This is an all in one version of what Switch does. Trims the beginning and trailing slashes from path.
+void getTrimmedPath(const char16_t *path, size_t pathLength, const char16_t **pathBegin, size_t &pathLengthOut)
 {
     // This will trim extra beginning slashes.
-    if (pathBegin)
+    const char16_t *pathEnd = path + pathLength;
+    while (path < pathEnd && *path == u'/')
     {
-        while (*path == '/')
-        {
-            ++path;
-        }
-        *pathBegin = path;
+        ++path;
     }
+    *pathBegin = path;
 
-    for (pathLengthOut = std::char_traits<char16_t>::length(path); pathLengthOut > 0; pathLengthOut--)
+    for (pathLengthOut = pathEnd - path; pathLengthOut > 0; pathLengthOut--)
     {
         if (path[pathLengthOut - 1] != u'/')
         {
@@ -52,9 +51,14 @@ fslib::Path::Path(const fslib::Path &path)
     *this = path;
 }
 
+fslib::Path::Path(fslib::Path &&path) noexcept
+{
+    *this = std::move(path);
+}
+
 fslib::Path::Path(const char16_t *pathData)
 {
-    *this = pathData;
+    Path::assignPath(pathData, std::char_traits<char16_t>::length(pathData));
 }
 
 fslib::Path::Path(const uint16_t *pathData)
@@ -64,12 +68,17 @@ fslib::Path::Path(const uint16_t *pathData)
 
 fslib::Path::Path(const std::u16string &pathData)
 {
-    *this = pathData;
+    Path::assignPath(pathData.c_str(), pathData.length());
 }
 
 fslib::Path::Path(const std::u16string_view pathData)
 {
-    *this = pathData;
+    Path::assignPath(pathData.data(), pathData.length());
+}
+
+fslib::Path::Path(const fslib::PathLiteral &literal)
+{
+    Path::assignCheckedPath(literal.cString(), literal.getLength(), literal.getDevice().length());
 }
 
 fslib::Path::~Path()
@@ -79,7 +88,7 @@ fslib::Path::~Path()
 
 bool fslib::Path::isValid(void) const
 {
-    return m_path && m_deviceEnd && std::char_traits<char16_t>::length(m_deviceEnd + 1) > 0 && strpbrk16(m_deviceEnd + 1) == nullptr;
+    return m_deviceEnd != Path::notFound && m_pathLength > m_deviceEnd + 1 && strpbrk16(&m_path[m_deviceEnd + 1]) == nullptr;
 }
 
 fslib::Path fslib::Path::subPath(size_t pathLength) const
@@ -90,11 +99,13 @@ fslib::Path fslib::Path::subPath(size_t pathLength) const
     }
 
     fslib::Path newPath;
-    if (newPath.allocatePath(m_pathSize))
+    if (newPath.reservePath(pathLength + 1))
     {
         std::memcpy(newPath.m_path, m_path, pathLength * sizeof(char16_t));
-        newPath.m_deviceEnd = std::char_traits<char16_t>::find(newPath.m_path, m_pathLength, u':');
-        newPath.m_pathLength = m_pathLength;
+        newPath.m_path[pathLength] = u'\0';
+        newPath.m_pathLength = pathLength;
+        newPath.m_deviceEnd = m_deviceEnd < pathLength ? m_deviceEnd : Path::notFound;
+        newPath.m_deviceCache.store(m_deviceEnd < pathLength ? Path::getDeviceCache() : 0, std::memory_order_relaxed);
     }
     return newPath;
 }
@@ -159,7 +170,11 @@ const char16_t *fslib::Path::cString(void) const
 
 std::u16string_view fslib::Path::getDevice(void) const
 {
-    return std::u16string_view(m_path, m_deviceEnd - m_path);
+    if (m_deviceEnd == Path::notFound)
+    {
+        return std::u16string_view();
+    }
+    return std::u16string_view(m_path, m_deviceEnd);
 }
 
 std::u16string_view fslib::Path::getFileName(void) const
@@ -184,12 +199,13 @@ std::u16string_view fslib::Path::getExtension(void) const
         return std::u16string_view(u"nullptr");
     }
     // I'm assuming the last dot will start the extension.
-    return std::u16string_view(&m_path[extensionBegin] + 1, m_pathLength);
+    return std::u16string_view(&m_path[extensionBegin + 1], m_pathLength - (extensionBegin + 1));
 }
 
 FS_Path fslib::Path::getPath(void) const
 {
-    return {PATH_UTF16, (std::char_traits<char16_t>::length(m_deviceEnd + 1) * sizeof(char16_t)) + sizeof(char16_t), m_deviceEnd + 1};
+    size_t pathBegin = m_deviceEnd == Path::notFound ? 0 : m_deviceEnd + 1;
+    return {PATH_UTF16, ((m_pathLength - pathBegin) * sizeof(char16_t)) + sizeof(char16_t), &m_path[pathBegin]};
 }
 
 size_t fslib::Path::getLength(void) const
@@ -197,52 +213,69 @@ size_t fslib::Path::getLength(void) const
     return m_pathLength;
 }
 
+uint32_t fslib::Path::getDeviceCache(void) const
+{
+    return m_deviceCache.load(std::memory_order_relaxed);
+}
+
+void fslib::Path::setDeviceCache(uint32_t deviceCache) const
+{
+    m_deviceCache.store(deviceCache, std::memory_order_relaxed);
+}
+
 fslib::Path &fslib::Path::operator=(const fslib::Path &path)
 {
-    if (!Path::allocatePath(path.m_pathSize))
+    if (this == &path || !Path::reservePath(path.m_pathLength + 1))
     {
         // To do: Better error handling than this.
         return *this;
     }
 
-    // Copy path data from incoming path.
-    std::memcpy(m_path, path.m_path, path.m_pathSize * sizeof(char16_t));
-    m_pathSize = path.m_pathSize;
+    // Copy path data from incoming path. Only the used part of the buffer matters.
+    std::memcpy(m_path, path.m_path, (path.m_pathLength + 1) * sizeof(char16_t));
     m_pathLength = path.m_pathLength;
-    m_deviceEnd = std::char_traits<char16_t>::find(m_path, m_pathLength, u':');
+    m_deviceEnd = path.m_deviceEnd;
+    // Same device, so the same slot.
+    m_deviceCache.store(path.getDeviceCache(), std::memory_order_relaxed);
 
     return *this;
 }
 
-fslib::Path &fslib::Path::operator=(const char16_t *pathData)
+fslib::Path &fslib::Path::operator=(fslib::Path &&path) noexcept
 {
-    // Calculate how much memory to allocate for path.
-    size_t pathLength = std::char_traits<char16_t>::length(pathData);
-    m_deviceEnd = std::char_traits<char16_t>::find(pathData, pathLength, u':');
-    if (!m_deviceEnd)
+    if (this == &path)
     {
-        // To do: things
         return *this;
     }
 
-    m_pathSize = fslib::MAX_PATH + ((m_deviceEnd - pathData) + 1);
-    if (!Path::allocatePath(m_pathSize))
+    Path::freePath();
+    if (path.m_path == path.m_inlinePath)
     {
-        return *this;
+        // Inline buffers can't be taken, only copied.
+        std::memcpy(m_inlinePath, path.m_inlinePath, (path.m_pathLength + 1) * sizeof(char16_t));
     }
+    else
+    {
+        m_path = path.m_path;
+        m_pathSize = path.m_pathSize;
+        path.m_path = path.m_inlinePath;
+        path.m_pathSize = Path::inlineSize;
+    }
+    m_pathLength = path.m_pathLength;
+    m_deviceEnd = path.m_deviceEnd;
+    m_deviceCache.store(path.getDeviceCache(), std::memory_order_relaxed);
 
-    // Need to get trimmed, proper path. Training wheels, I guess.
-    const char16_t *pathBegin = nullptr;
-    getTrimmedPath(m_deviceEnd + 1, &pathBegin, pathLength);
+    path.m_path[0] = u'\0';
+    path.m_pathLength = 0;
+    path.m_deviceEnd = Path::notFound;
+    path.m_deviceCache.store(0, std::memory_order_relaxed);
 
-    // Copy device over.
-    std::memcpy(m_path, pathData, ((m_deviceEnd - pathData) + 2) * sizeof(char16_t));
-    // Copy trimmed path over starting after the device string.
-    std::memcpy(&m_path[std::char_traits<char16_t>::length(m_path)], pathBegin, pathLength * sizeof(char16_t));
-    // Make sure these are correct and point to this instance's members.
-    m_pathLength = std::char_traits<char16_t>::length(m_path);
-    m_deviceEnd = std::char_traits<char16_t>::find(m_path, m_pathLength, ':');
+    return *this;
+}
 
+fslib::Path &fslib::Path::operator=(const char16_t *pathData)
+{
+    Path::assignPath(pathData, std::char_traits<char16_t>::length(pathData));
     return *this;
 }
 
@@ -253,39 +286,25 @@ fslib::Path &fslib::Path::operator=(const uint16_t *pathData)
 
 fslib::Path &fslib::Path::operator=(const std::u16string &pathData)
 {
-    return *this = pathData.c_str();
+    Path::assignPath(pathData.c_str(), pathData.length());
+    return *this;
 }
 
 fslib::Path &fslib::Path::operator=(std::u16string_view pathData)
 {
-    // To do: Properly support string_view.
-    return *this = pathData.data();
+    Path::assignPath(pathData.data(), pathData.length());
+    return *this;
 }
 
-fslib::Path &fslib::Path::operator/=(const char16_t *pathData)
+fslib::Path &fslib::Path::operator=(const fslib::PathLiteral &literal)
 {
-    size_t pathLength = 0;
-    const char16_t *pathBegin = nullptr;
-    getTrimmedPath(pathData, &pathBegin, pathLength);
-
-    // Check to make sure buffer has enough space.
-    if ((m_pathLength + pathLength) + 1 >= m_pathSize)
-    {
-        // To do: The thing.
-        return *this;
-    }
-
-    // This is to avoid doubling up slashes after the device.
-    if (m_path[m_pathLength - 1] != u'/')
-    {
-        m_path[m_pathLength++] = u'/';
-    }
-
-    // Copy trimmed path to the end of our current path.
-    std::memcpy(&m_path[m_pathLength], pathBegin, pathLength * sizeof(char16_t));
-
-    m_pathLength += pathLength;
+    Path::assignCheckedPath(literal.cString(), literal.getLength(), literal.getDevice().length());
+    return *this;
+}
 
+fslib::Path &fslib::Path::operator/=(const char16_t *pathData)
+{
+    Path::appendPath(pathData, std::char_traits<char16_t>::length(pathData));
     return *this;
 }
 
@@ -296,27 +315,19 @@ fslib::Path &fslib::Path::operator/=(const uint16_t *pathData)
 
 fslib::Path &fslib::Path::operator/=(const std::u16string &pathData)
 {
-    return *this /= pathData.c_str();
+    Path::appendPath(pathData.c_str(), pathData.length());
+    return *this;
 }
 
 fslib::Path &fslib::Path::operator/=(std::u16string_view pathData)
 {
-    return *this /= pathData.data();
+    Path::appendPath(pathData.data(), pathData.length());
+    return *this;
 }
 
 fslib::Path &fslib::Path::operator+=(const char16_t *pathData)
 {
-    size_t pathLength = std::char_traits<char16_t>::length(pathData);
-    if (m_pathLength + pathLength >= m_pathSize)
-    {
-        return *this;
-    }
-
-    // Don't check anything. Just copy.
-    std::memcpy(&m_path[m_pathLength], pathData, pathLength * sizeof(char16_t));
-
-    m_pathLength += pathLength;
-
+    Path::concatenatePath(pathData, std::char_traits<char16_t>::length(pathData));
     return *this;
 }
 
@@ -327,31 +338,159 @@ fslib::Path &fslib::Path::operator+=(const uint16_t *pathData)
 
 fslib::Path &fslib::Path::operator+=(const std::u16string &pathData)
 {
-    return *this += pathData.c_str();
+    Path::concatenatePath(pathData.c_str(), pathData.length());
+    return *this;
 }
 
 fslib::Path &fslib::Path::operator+=(std::u16string_view pathData)
 {
-    return *this += pathData.data();
+    Path::concatenatePath(pathData.data(), pathData.length());
+    return *this;
 }
 
-bool fslib::Path::allocatePath(uint16_t pathSize)
+void fslib::Path::assignPath(const char16_t *pathData, size_t pathLength)
 {
-    Path::freePath();
-    m_path = new (std::nothrow) char16_t[pathSize];
-    if (!m_path)
+    // Assigning part of this path to itself would overwrite the source while copying.
+    if (pathData >= m_path && pathData < m_path + m_pathSize)
+    {
+        std::u16string pathCopy(pathData, pathLength);
+        Path::assignPath(pathCopy.c_str(), pathCopy.length());
+        return;
+    }
+
+    m_pathLength = 0;
+    m_path[0] = u'\0';
+    m_deviceCache.store(0, std::memory_order_relaxed);
+    const char16_t *deviceEnd = std::char_traits<char16_t>::find(pathData, pathLength, u':');
+    if (!deviceEnd)
+    {
+        // To do: things
+        m_deviceEnd = Path::notFound;
+        return;
+    }
+
+    // Need to get trimmed, proper path. Training wheels, I guess.
+    size_t deviceLength = deviceEnd - pathData;
+    size_t trimmedLength = 0;
+    const char16_t *pathBegin = nullptr;
+    getTrimmedPath(deviceEnd + 1, pathLength - (deviceLength + 1), &pathBegin, trimmedLength);
+
+    // device:/ + path + NULL.
+    size_t newLength = deviceLength + 2 + trimmedLength;
+    m_deviceEnd = deviceLength;
+    if (trimmedLength >= fslib::MAX_PATH || !Path::reservePath(newLength + 1))
+    {
+        m_deviceEnd = Path::notFound;
+        return;
+    }
+
+    std::memcpy(m_path, pathData, deviceLength * sizeof(char16_t));
+    m_path[deviceLength] = u':';
+    m_path[deviceLength + 1] = u'/';
+    std::memcpy(&m_path[deviceLength + 2], pathBegin, trimmedLength * sizeof(char16_t));
+    m_path[newLength] = u'\0';
+    m_pathLength = newLength;
+}
+
+void fslib::Path::assignCheckedPath(const char16_t *pathData, size_t pathLength, uint16_t deviceEnd)
+{
+    m_pathLength = 0;
+    m_path[0] = u'\0';
+    m_deviceCache.store(0, std::memory_order_relaxed);
+    m_deviceEnd = deviceEnd;
+    if (!Path::reservePath(pathLength + 1))
+    {
+        m_deviceEnd = Path::notFound;
+        return;
+    }
+
+    std::memcpy(m_path, pathData, pathLength * sizeof(char16_t));
+    m_path[pathLength] = u'\0';
+    m_pathLength = pathLength;
+}
+
+void fslib::Path::appendPath(const char16_t *pathData, size_t pathLength)
+{
+    if (pathData >= m_path && pathData < m_path + m_pathSize)
+    {
+        std::u16string pathCopy(pathData, pathLength);
+        Path::appendPath(pathCopy.c_str(), pathCopy.length());
+        return;
+    }
+
+    size_t trimmedLength = 0;
+    const char16_t *pathBegin = nullptr;
+    getTrimmedPath(pathData, pathLength, &pathBegin, trimmedLength);
+
+    // This is to avoid doubling up slashes after the device.
+    bool needsSlash = m_pathLength > 0 && m_path[m_pathLength - 1] != u'/';
+    size_t newLength = m_pathLength + (needsSlash ? 1 : 0) + trimmedLength;
+    if (m_deviceEnd == Path::notFound || newLength - (m_deviceEnd + 1) >= fslib::MAX_PATH || !Path::reservePath(newLength + 1))
+    {
+        // To do: The thing.
+        return;
+    }
+
+    if (needsSlash)
+    {
+        m_path[m_pathLength++] = u'/';
+    }
+    std::memcpy(&m_path[m_pathLength], pathBegin, trimmedLength * sizeof(char16_t));
+    m_pathLength = newLength;
+    m_path[m_pathLength] = u'\0';
+}
+
+void fslib::Path::concatenatePath(const char16_t *pathData, size_t pathLength)
+{
+    if (pathData >= m_path && pathData < m_path + m_pathSize)
+    {
+        std::u16string pathCopy(pathData, pathLength);
+        Path::concatenatePath(pathCopy.c_str(), pathCopy.length());
+        return;
+    }
+
+    size_t newLength = m_pathLength + pathLength;
+    if (m_deviceEnd == Path::notFound || newLength - (m_deviceEnd + 1) >= fslib::MAX_PATH || !Path::reservePath(newLength + 1))
+    {
+        return;
+    }
+
+    // Don't check anything. Just copy.
+    std::memcpy(&m_path[m_pathLength], pathData, pathLength * sizeof(char16_t));
+    m_pathLength = newLength;
+    m_path[m_pathLength] = u'\0';
+}
+
+bool fslib::Path::reservePath(size_t pathSize)
+{
+    if (pathSize <= m_pathSize)
+    {
+        return true;
+    }
+
+    // Allocate the most the path can ever need so this only happens once per path.
+    size_t deviceLength = m_deviceEnd == Path::notFound ? 0 : m_deviceEnd + 1;
+    size_t heapSize = std::max(pathSize, deviceLength + fslib::MAX_PATH + 1);
+    char16_t *heapPath = new (std::nothrow) char16_t[heapSize];
+    if (!heapPath)
     {
         return false;
     }
-    std::memset(m_path, 0x00, pathSize * sizeof(char16_t));
+
+    std::memcpy(heapPath, m_path, (m_pathLength + 1) * sizeof(char16_t));
+    Path::freePath();
+    m_path = heapPath;
+    m_pathSize = heapSize;
     return true;
 }
 
 void fslib::Path::freePath(void)
 {
-    if (m_path)
+    if (m_path != m_inlinePath)
     {
         delete[] m_path;
+        m_path = m_inlinePath;
+        m_pathSize = Path::inlineSize;
     }
 }
 
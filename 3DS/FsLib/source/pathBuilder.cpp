@@ -0,0 +1,59 @@
+#include "pathBuilder.hpp"
+
+namespace
+{
+    // Most trees aren't deeper than this. Reserving it up front keeps the first walk down from allocating.
+    constexpr size_t INITIAL_DEPTH = 32;
+} // namespace
+
+fslib::PathBuilder::PathBuilder(const fslib::Path &root)
+{
+    PathBuilder::reset(root);
+}
+
+void fslib::PathBuilder::reset(const fslib::Path &root)
+{
+    m_path = root;
+    m_componentStarts.clear();
+    m_componentStarts.reserve(INITIAL_DEPTH);
+}
+
+bool fslib::PathBuilder::push(std::u16string_view component)
+{
+    uint16_t componentStart = m_path.m_pathLength;
+    m_path.appendPath(component.data(), component.length());
+    if (m_path.m_pathLength == componentStart && !component.empty())
+    {
+        // appendPath leaves the path alone when it can't fit.
+        return false;
+    }
+    m_componentStarts.push_back(componentStart);
+    return true;
+}
+
+void fslib::PathBuilder::pop(void)
+{
+    if (m_componentStarts.empty())
+    {
+        return;
+    }
+
+    m_path.m_pathLength = m_componentStarts.back();
+    m_path.m_path[m_path.m_pathLength] = u'\0';
+    m_componentStarts.pop_back();
+}
+
+size_t fslib::PathBuilder::getDepth(void) const
+{
+    return m_componentStarts.size();
+}
+
+const fslib::Path &fslib::PathBuilder::getPath(void) const
+{
+    return m_path;
+}
+
+fslib::PathBuilder::operator const fslib::Path &(void) const
+{
+    return m_path;
+}
@@ -0,0 +1,61 @@
+#include "pathView.hpp"
+#include "path.hpp"
+#include "pathBuilder.hpp"
+#include "pathLiteral.hpp"
+#include <algorithm>
+#include <array>
+
+namespace
+{
+    // Array of characters that are forbidden in paths.
+    constexpr std::array<char16_t, 8> FORBIDDEN_CHARS = {u'<', u'>', u':', u'\\', u'"', u'|', u'?', u'*'};
+} // namespace
+
+fslib::PathView::PathView(const fslib::Path &path)
+    : m_path(path.m_path), m_deviceEnd(path.m_deviceEnd), m_pathLength(path.m_pathLength)
+{
+}
+
+fslib::PathView::PathView(const fslib::PathBuilder &builder) : PathView(builder.getPath())
+{
+}
+
+fslib::PathView::PathView(const fslib::PathLiteral &literal)
+    : m_path(literal.cString()), m_deviceEnd(literal.getDevice().length()), m_pathLength(literal.getLength())
+{
+}
+
+bool fslib::PathView::isValid(void) const
+{
+    if (m_deviceEnd == fslib::Path::notFound || m_pathLength <= m_deviceEnd + 1)
+    {
+        return false;
+    }
+    const char16_t *pathEnd = m_path + m_pathLength;
+    return std::find_first_of(&m_path[m_deviceEnd + 1], pathEnd, FORBIDDEN_CHARS.begin(), FORBIDDEN_CHARS.end()) == pathEnd;
+}
+
+const char16_t *fslib::PathView::cString(void) const
+{
+    return m_path;
+}
+
+std::u16string_view fslib::PathView::getDevice(void) const
+{
+    if (m_deviceEnd == fslib::Path::notFound)
+    {
+        return std::u16string_view();
+    }
+    return std::u16string_view(m_path, m_deviceEnd);
+}
+
+FS_Path fslib::PathView::getPath(void) const
+{
+    size_t pathBegin = m_deviceEnd == fslib::Path::notFound ? 0 : m_deviceEnd + 1;
+    return {PATH_UTF16, ((m_pathLength - pathBegin) * sizeof(char16_t)) + sizeof(char16_t), &m_path[pathBegin]};
+}
+
+size_t fslib::PathView::getLength(void) const
+{
+    return m_pathLength;
+}
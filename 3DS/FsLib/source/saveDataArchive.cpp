@@ -1,7 +1,4 @@
 #include "fslib.hpp"
-#include "string.hpp"
-
-extern std::string g_fslibErrorString;
 
 bool fslib::openSaveData(std::u16string_view deviceName)
 {
@@ -9,7 +6,7 @@ bool fslib::openSaveData(std::u16string_view deviceName)
     Result fsError = FSUSER_OpenArchive(&archive, ARCHIVE_SAVEDATA, {PATH_EMPTY, 0x00, NULL});
     if (R_FAILED(fsError))
     {
-        g_fslibErrorString = string::getFormattedString("Error open save data archive: 0x%08X.", fsError);
+        fslib::error::setResult(fslib::Operation::OpenArchive, fsError, deviceName);
         return false;
     }
 
@@ -31,7 +28,7 @@ bool fslib::openExtData(std::u16string_view deviceName, uint32_t extDataID)
     Result fsError = FSUSER_OpenArchive(&archive, ARCHIVE_EXTDATA, path);
     if (R_FAILED(fsError))
     {
-        g_fslibErrorString = string::getFormattedString("Error opening extdata archive: 0x%08X.", fsError);
+        fslib::error::setResult(fslib::Operation::OpenArchive, fsError, deviceName);
         return false;
     }
 
@@ -53,7 +50,7 @@ bool fslib::openSharedExtData(std::u16string_view deviceName, uint32_t sharedExt
     Result fsError = FSUSER_OpenArchive(&archive, ARCHIVE_SHARED_EXTDATA, path);
     if (R_FAILED(fsError))
     {
-        g_fslibErrorString = string::getFormattedString("Error opening shared extdata: 0x%08X.", fsError);
+        fslib::error::setResult(fslib::Operation::OpenArchive, fsError, deviceName);
         return false;
     }
 
@@ -76,7 +73,7 @@ bool fslib::openBossExtData(std::u16string_view deviceName, uint32_t extDataID)
     Result fsError = FSUSER_OpenArchive(&archive, ARCHIVE_BOSS_EXTDATA, path);
     if (R_FAILED(fsError))
     {
-        g_fslibErrorString = string::getFormattedString("Error opening BOSS extdata: 0x%08X.", fsError);
+        fslib::error::setResult(fslib::Operation::OpenArchive, fsError, deviceName);
         return false;
     }
 
@@ -98,7 +95,7 @@ bool fslib::openSystemSaveData(std::u16string_view deviceName, uint32_t uniqueID
     Result fsError = FSUSER_OpenArchive(&archive, ARCHIVE_SYSTEM_SAVEDATA, path);
     if (R_FAILED(fsError))
     {
-        g_fslibErrorString = string::getFormattedString("Error opening system save data: 0x%08X.", fsError);
+        fslib::error::setResult(fslib::Operation::OpenArchive, fsError, deviceName);
         return false;
     }
 
@@ -120,7 +117,7 @@ bool fslib::openSystemModuleSaveData(std::u16string_view deviceName, uint32_t un
     Result fsError = FSUSER_OpenArchive(&archive, ARCHIVE_SYSTEM_SAVEDATA, path);
     if (R_FAILED(fsError))
     {
-        g_fslibErrorString = string::getFormattedString("Error opening system module save data: 0x%08X.", uniqueID);
+        fslib::error::setResult(fslib::Operation::OpenArchive, fsError, deviceName);
         return false;
     }
 
@@ -140,7 +137,7 @@ bool fslib::openGameCardSaveData(std::u16string_view deviceName)
     Result fsError = FSUSER_OpenArchive(&archive, ARCHIVE_GAMECARD_SAVEDATA, {PATH_EMPTY, 0x00, NULL});
     if (R_FAILED(fsError))
     {
-        g_fslibErrorString = string::getFormattedString("Error open game card save data: 0x%08X.", fsError);
+        fslib::error::setResult(fslib::Operation::OpenArchive, fsError, deviceName);
         return false;
     }
 
@@ -161,7 +158,7 @@ bool fslib::openUserSaveData(std::u16string_view deviceName, FS_MediaType mediaT
     Result fsError = FSUSER_OpenArchive(&archive, ARCHIVE_USER_SAVEDATA, path);
     if (R_FAILED(fsError))
     {
-        g_fslibErrorString = string::getFormattedString("Error opening user save data: 0x%08X.", fsError);
+        fslib::error::setResult(fslib::Operation::OpenArchive, fsError, deviceName);
         return false;
     }
 
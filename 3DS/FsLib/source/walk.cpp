@@ -0,0 +1,254 @@
+#include "walk.hpp"
+#include "directory.hpp"
+#include "error.hpp"
+#include "fslib.hpp"
+#include "pathBuilder.hpp"
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    // One of these is kept per directory currently being walked on the single threaded path.
+    struct WalkFrame
+    {
+            std::unique_ptr<fslib::Directory> directory;
+            int64_t index = 0;
+            size_t nameOffset = 0;
+            int depth = 0;
+    };
+
+    // Directories waiting to be walked by the worker threads, paired with the depth of the entries inside them.
+    struct WalkQueue
+    {
+            std::mutex queueLock;
+            std::condition_variable queueCondition;
+            std::deque<std::pair<std::u16string, int>> directories;
+            int activeWorkers = 0;
+            bool stop = false;
+            bool failed = false;
+            // Errors are recorded per thread, so the first worker to fail leaves its error here for the calling thread.
+            fslib::error::Record error;
+    };
+} // namespace
+
+// Appends name to the directory path already in pathBuffer at pathLength. Returns the offset of name in the buffer.
+static size_t appendName(std::u16string &pathBuffer, size_t pathLength, std::u16string_view name)
+{
+    pathBuffer.resize(pathLength);
+    if (pathLength > 0 && pathBuffer.back() != u'/')
+    {
+        pathBuffer.push_back(u'/');
+    }
+    size_t nameOffset = pathBuffer.size();
+    pathBuffer.append(name);
+    return nameOffset;
+}
+
+// Reads the listing of the directory at path.
+static std::unique_ptr<fslib::Directory> readListing(const fslib::Path &path, bool sortEntries)
+{
+    std::unique_ptr<fslib::Directory> directory(new (std::nothrow) fslib::Directory(path, sortEntries));
+    if (!directory)
+    {
+        fslib::error::setReason(fslib::Operation::Walk, "Couldn't allocate directory.", path);
+        return nullptr;
+    }
+    // Directory already recorded why it couldn't be opened.
+    if (!directory->isOpen())
+    {
+        return nullptr;
+    }
+    return directory;
+}
+
+static inline bool shouldEnter(const fslib::WalkOptions &options, int depth)
+{
+    return options.maxDepth < 0 || depth < options.maxDepth;
+}
+
+static bool walkSingleThreaded(const fslib::Path &root, const fslib::WalkOptions &options)
+{
+    // Entry paths are built in place, so the only allocations are the listings themselves.
+    fslib::PathBuilder pathBuilder(root);
+    const fslib::Path &path = pathBuilder.getPath();
+    std::vector<WalkFrame> frames;
+
+    WalkFrame rootFrame;
+    rootFrame.directory = readListing(path, options.sortEntries);
+    if (!rootFrame.directory)
+    {
+        return false;
+    }
+    frames.push_back(std::move(rootFrame));
+
+    while (!frames.empty())
+    {
+        WalkFrame &frame = frames.back();
+        if (frame.index >= frame.directory->getCount())
+        {
+            // Everything inside has been visited. The builder still holds this directory's path for the post-order visit.
+            size_t nameOffset = frame.nameOffset;
+            int depth = frame.depth;
+            frames.pop_back();
+            if (frames.empty())
+            {
+                break;
+            }
+
+            if (options.postVisit)
+            {
+                fslib::WalkEntry entry = {path.cString(), path.cString() + nameOffset, 0, true, depth - 1};
+                if (options.postVisit(entry) == fslib::WALK_STOP)
+                {
+                    return true;
+                }
+            }
+            pathBuilder.pop();
+            continue;
+        }
+
+        int64_t index = frame.index++;
+        int depth = frame.depth;
+        bool isDirectory = frame.directory->isDirectory(index);
+        std::u16string_view name = frame.directory->getEntry(index);
+        if (!pathBuilder.push(name))
+        {
+            fslib::error::setReason(fslib::Operation::Walk, "Path is too long.", path);
+            return false;
+        }
+        size_t nameOffset = path.getLength() - name.length();
+
+        fslib::WalkEntry entry = {path.cString(),
+                                  path.cString() + nameOffset,
+                                  isDirectory ? 0 : frame.directory->getEntrySize(index),
+                                  isDirectory,
+                                  depth};
+        uint8_t action = options.preVisit ? options.preVisit(entry) : fslib::WALK_CONTINUE;
+        if (action == fslib::WALK_STOP)
+        {
+            return true;
+        }
+
+        if (!isDirectory || action == fslib::WALK_SKIP || !shouldEnter(options, depth))
+        {
+            pathBuilder.pop();
+            continue;
+        }
+
+        // frame is invalid after this.
+        WalkFrame childFrame;
+        childFrame.directory = readListing(path, options.sortEntries);
+        if (!childFrame.directory)
+        {
+            return false;
+        }
+        childFrame.nameOffset = nameOffset;
+        childFrame.depth = depth + 1;
+        frames.push_back(std::move(childFrame));
+    }
+    return true;
+}
+
+static void walkWorkerFunction(WalkQueue &queue, const fslib::WalkOptions &options)
+{
+    std::u16string pathBuffer;
+    while (true)
+    {
+        std::pair<std::u16string, int> job;
+        {
+            std::unique_lock<std::mutex> queueLock(queue.queueLock);
+            queue.queueCondition.wait(queueLock,
+                                      [&queue]() { return queue.stop || !queue.directories.empty() || queue.activeWorkers == 0; });
+            if (queue.stop || queue.directories.empty())
+            {
+                return;
+            }
+            job = std::move(queue.directories.front());
+            queue.directories.pop_front();
+            ++queue.activeWorkers;
+        }
+
+        bool stop = false;
+        std::unique_ptr<fslib::Directory> directory = readListing(job.first, options.sortEntries);
+        if (!directory)
+        {
+            std::lock_guard<std::mutex> queueLock(queue.queueLock);
+            if (!queue.failed)
+            {
+                queue.error = fslib::error::capture();
+            }
+            queue.failed = true;
+            stop = true;
+        }
+
+        for (int64_t i = 0; !stop && directory && i < directory->getCount(); i++)
+        {
+            bool isDirectory = directory->isDirectory(i);
+            size_t nameOffset = appendName(pathBuffer.assign(job.first), job.first.size(), directory->getEntry(i));
+
+            fslib::WalkEntry entry = {pathBuffer.c_str(),
+                                      pathBuffer.c_str() + nameOffset,
+                                      isDirectory ? 0 : directory->getEntrySize(i),
+                                      isDirectory,
+                                      job.second};
+            uint8_t action = options.preVisit ? options.preVisit(entry) : fslib::WALK_CONTINUE;
+            if (action == fslib::WALK_STOP)
+            {
+                stop = true;
+                break;
+            }
+
+            if (isDirectory && action != fslib::WALK_SKIP && shouldEnter(options, job.second))
+            {
+                std::lock_guard<std::mutex> queueLock(queue.queueLock);
+                queue.directories.emplace_back(pathBuffer, job.second + 1);
+                queue.queueCondition.notify_one();
+            }
+        }
+
+        std::lock_guard<std::mutex> queueLock(queue.queueLock);
+        --queue.activeWorkers;
+        if (stop)
+        {
+            queue.stop = true;
+        }
+        // Wake everyone up if the walk is over so they can exit.
+        if (queue.stop || (queue.activeWorkers == 0 && queue.directories.empty()))
+        {
+            queue.queueCondition.notify_all();
+        }
+    }
+}
+
+bool fslib::walk(const fslib::Path &root, const fslib::WalkOptions &options)
+{
+    if (options.workerCount <= 1)
+    {
+        return walkSingleThreaded(root, options);
+    }
+
+    WalkQueue queue;
+    queue.directories.emplace_back(root.cString(), 0);
+
+    std::vector<std::thread> workers;
+    for (int i = 0; i < options.workerCount; i++)
+    {
+        workers.emplace_back(walkWorkerFunction, std::ref(queue), std::cref(options));
+    }
+
+    for (std::thread &worker : workers)
+    {
+        worker.join();
+    }
+
+    if (queue.failed)
+    {
+        fslib::error::restore(queue.error);
+    }
+    return !queue.failed;
+}
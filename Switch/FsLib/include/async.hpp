@@ -0,0 +1,191 @@
+#pragma once
+#include "directory.hpp"
+#include "error.hpp"
+#include "path.hpp"
+#include <cstddef>
+#include <functional>
+#include <future>
+#include <memory>
+#include <switch.h>
+
+namespace fslib
+{
+    /// @brief Contains the asynchronous counterparts of FsLib's blocking functions and the worker pool that runs them.
+    namespace async
+    {
+        /// @brief Options for the worker pool.
+        struct Options
+        {
+                /// @brief Number of worker threads. Requests on different handles and devices run on these in parallel.
+                size_t workerCount = 2;
+
+                /// @brief Maximum number of requests waiting to run. Submitting more than this blocks until a request finishes.
+                size_t queueSize = 64;
+        };
+
+        /// @brief What an asynchronous request hands back once it's done.
+        template <typename Type>
+        struct Completion
+        {
+                /// @brief What the blocking version of the request returned.
+                Type value{};
+
+                /// @brief Result recorded if the request failed. 0 if it succeeded or the error didn't come from FS.
+                Result result = 0;
+
+                /// @brief Operation recorded if the request failed. Operation::None if it succeeded.
+                fslib::Operation operation = fslib::Operation::None;
+        };
+
+        /// @brief Optional function called from the worker thread once a request is done. This is called before the future is ready.
+        template <typename Type>
+        using CompletionFunction = std::function<void(const fslib::async::Completion<Type> &)>;
+
+        /// @brief Requests on the same strand run one at a time in the order they were submitted. This is how AsyncFile keeps its
+        /// requests ordered.
+        class Strand;
+
+        /// @brief Work submitted to the pool.
+        using Task = std::move_only_function<void(void)>;
+
+        /**
+         * @brief Starts the worker pool.
+         *
+         * @param options Options for the pool.
+         * @return True on success. False if the pool is already running.
+         * @note This doesn't need to be called. The pool is started with the default options the first time a request is submitted.
+         */
+        bool initialize(const fslib::async::Options &options = {});
+
+        /// @brief Waits for every request already submitted to finish and stops the worker pool. fslib::exit calls this.
+        /// @note This does nothing when called from a completion function. The worker calling it would be waiting on itself.
+        void exit(void);
+
+        /**
+         * @brief Opens the file at filePath on a worker thread and reads it into buffer.
+         *
+         * @param filePath Path of the file to read.
+         * @param buffer Buffer to read into. This needs to stay valid until the request is done.
+         * @param bufferSize Size of the buffer.
+         * @param onComplete Optional. Called from the worker thread once the read is done.
+         * @return Future for the number of bytes read. -1 on failure.
+         */
+        std::future<fslib::async::Completion<ssize_t>> readFile(const fslib::Path &filePath,
+                                                                void *buffer,
+                                                                size_t bufferSize,
+                                                                fslib::async::CompletionFunction<ssize_t> onComplete = {});
+
+        /**
+         * @brief Creates or replaces the file at filePath on a worker thread and writes buffer to it.
+         *
+         * @param filePath Path of the file to write.
+         * @param buffer Data to write. This needs to stay valid until the request is done.
+         * @param bufferSize Size of the data.
+         * @param onComplete Optional. Called from the worker thread once the write is done.
+         * @return Future for the number of bytes written. -1 on failure.
+         */
+        std::future<fslib::async::Completion<ssize_t>> writeFile(const fslib::Path &filePath,
+                                                                 const void *buffer,
+                                                                 size_t bufferSize,
+                                                                 fslib::async::CompletionFunction<ssize_t> onComplete = {});
+
+        /**
+         * @brief Reads the listing of the directory at directoryPath on a worker thread.
+         *
+         * @param directoryPath Path of the directory.
+         * @param sortedListing Optional. Whether or not the listing is sorted.
+         * @param onComplete Optional. Called from the worker thread once the listing is read.
+         * @return Future for the listing. nullptr on failure.
+         */
+        std::future<fslib::async::Completion<std::shared_ptr<fslib::Directory>>> listDirectory(
+            const fslib::Path &directoryPath,
+            bool sortedListing = true,
+            fslib::async::CompletionFunction<std::shared_ptr<fslib::Directory>> onComplete = {});
+
+        /// @brief Deletes the file at filePath on a worker thread.
+        /// @param filePath Path of the file to delete.
+        /// @param onComplete Optional. Called from the worker thread once the file is deleted.
+        /// @return Future for whether or not the file was deleted.
+        std::future<fslib::async::Completion<bool>> deleteFile(const fslib::Path &filePath,
+                                                               fslib::async::CompletionFunction<bool> onComplete = {});
+
+        /// @brief Deletes the empty directory at directoryPath on a worker thread.
+        /// @param directoryPath Path of the directory to delete.
+        /// @param onComplete Optional. Called from the worker thread once the directory is deleted.
+        /// @return Future for whether or not the directory was deleted.
+        std::future<fslib::async::Completion<bool>> deleteDirectory(const fslib::Path &directoryPath,
+                                                                    fslib::async::CompletionFunction<bool> onComplete = {});
+
+        /// @brief Deletes the directory at directoryPath and everything in it on a worker thread.
+        /// @param directoryPath Path of the directory to delete.
+        /// @param onComplete Optional. Called from the worker thread once the directory is deleted.
+        /// @return Future for whether or not the directory was deleted.
+        std::future<fslib::async::Completion<bool>> deleteDirectoryRecursively(const fslib::Path &directoryPath,
+                                                                               fslib::async::CompletionFunction<bool> onComplete = {});
+
+        /// @brief Creates a strand. Used internally by AsyncFile.
+        /// @return New strand.
+        std::shared_ptr<fslib::async::Strand> createStrand(void);
+
+        /**
+         * @brief Submits task to the pool. Used internally.
+         *
+         * @param strand Strand to run task on. nullptr runs task on whichever worker is free first.
+         * @param task Task to run.
+         * @note This blocks while the queue is full unless it's called from a worker thread.
+         */
+        void submit(const std::shared_ptr<fslib::async::Strand> &strand, fslib::async::Task task);
+
+        /**
+         * @brief Waits until every task submitted to strand has finished. Used internally by AsyncFile.
+         *
+         * @param strand Strand to wait on.
+         * @note When called from one of strand's own tasks, the tasks queued behind it are run on the calling thread instead, since
+         * they could never start while it waits. Waiting on a different strand from a worker can still deadlock if every worker ends
+         * up waiting.
+         */
+        void waitForStrand(const std::shared_ptr<fslib::async::Strand> &strand);
+
+        /**
+         * @brief Submits function to the pool and returns a future for what it returns. Used internally.
+         *
+         * @param strand Strand to run function on. nullptr runs it on whichever worker is free first.
+         * @param function Blocking FsLib call to run.
+         * @param failed Returns whether or not the value function returned means it failed.
+         * @param onComplete Optional. Called from the worker thread once function returns.
+         * @return Future for the Completion. The error is only filled in if failed returns true.
+         */
+        template <typename Type, typename Function, typename FailedFunction>
+        std::future<fslib::async::Completion<Type>> request(const std::shared_ptr<fslib::async::Strand> &strand,
+                                                            Function function,
+                                                            FailedFunction failed,
+                                                            fslib::async::CompletionFunction<Type> onComplete)
+        {
+            std::promise<fslib::async::Completion<Type>> promise;
+            std::future<fslib::async::Completion<Type>> future = promise.get_future();
+            fslib::async::submit(strand,
+                                 [function = std::move(function),
+                                  failed = std::move(failed),
+                                  onComplete = std::move(onComplete),
+                                  promise = std::move(promise)]() mutable {
+                                     // Errors recorded by earlier requests on this worker aren't this request's.
+                                     fslib::error::clear();
+
+                                     fslib::async::Completion<Type> completion;
+                                     completion.value = function();
+                                     if (failed(completion.value))
+                                     {
+                                         completion.result = fslib::getLastResult();
+                                         completion.operation = fslib::getLastOperation();
+                                     }
+
+                                     if (onComplete)
+                                     {
+                                         onComplete(completion);
+                                     }
+                                     promise.set_value(std::move(completion));
+                                 });
+            return future;
+        }
+    } // namespace async
+} // namespace fslib
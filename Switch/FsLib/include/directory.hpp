@@ -1,7 +1,7 @@
 #pragma once
 #include "path.hpp"
-#include <memory>
 #include <switch.h>
+#include <vector>
 
 namespace fslib
 {
@@ -50,15 +50,49 @@ namespace fslib
             /// @return Entry's name. If out of bounds, nullptr.
             const char *operator[](int index) const;
 
+            /**
+             * @brief Sorts the listing.
+             *
+             * @param sortOrder Order to sort by. Can be one of the following:
+             *      1. Directory::sortName. Alphabetically, ignoring case.
+             *      2. Directory::sortNatural. Alphabetically ignoring case, but runs of digits are compared by value so 2 comes before 10.
+             *      3. Directory::sortSize. By entry size.
+             *      4. Directory::sortTimestamp. By last modified time. This needs one request per entry.
+             * @param directoriesFirst Optional. Whether or not directories are kept before files. This is the default.
+             * @param descending Optional. Whether or not to sort largest/last first.
+             * @return True on success. False on failure.
+             * @note Each entry's collation key is only built once per sort. Entries that tie are ordered by name.
+             */
+            bool sort(uint8_t sortOrder, bool directoriesFirst = true, bool descending = false);
+
+            /// @brief Sorts alphabetically, ignoring case.
+            static constexpr uint8_t sortName = 0;
+            /// @brief Sorts alphabetically ignoring case, with numbers compared by value.
+            static constexpr uint8_t sortNatural = 1;
+            /// @brief Sorts by entry size.
+            static constexpr uint8_t sortSize = 2;
+            /// @brief Sorts by last modified time.
+            static constexpr uint8_t sortTimestamp = 3;
+
         private:
             // Whether or not directory was successfully read.
             bool m_wasRead = false;
             // Directory handle/service.
             FsDir m_directoryHandle;
+            // Path of the directory. This is needed to fetch timestamps when sorting.
+            fslib::Path m_directoryPath;
             // Number of entries read from directory.
             int64_t m_entryCount = 0;
-            // Array of entries.
-            std::unique_ptr<FsDirectoryEntry[]> m_directoryList;
+            // Every entry's name packed back to back. Each name is NUL terminated so it can be returned directly.
+            std::vector<char> m_nameArena;
+            // Offset of each entry's name in the arena.
+            std::vector<uint32_t> m_nameOffsets;
+            // Length of each entry's name, not counting the NUL terminator.
+            std::vector<uint16_t> m_nameLengths;
+            // Size of each entry.
+            std::vector<int64_t> m_entrySizes;
+            // Whether or not each entry is a directory.
+            std::vector<uint8_t> m_entryIsDirectory;
 
             /// @brief Closes directory handle. Directory is never kept open. Not needed outside of class.
             void close(void);
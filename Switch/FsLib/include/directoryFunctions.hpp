@@ -1,8 +1,13 @@
 #pragma once
 #include "path.hpp"
+#include <functional>
+#include <string_view>
 
 namespace fslib
 {
+    /// @brief Function called with the number of entries deleted so far by deleteDirectoryRecursively's fallback.
+    using DeleteProgressFunction = std::function<void(int64_t)>;
+
     /// @brief Attempts to create directory with directoryPath.
     /// @param directoryPath Path to new directory.
     /// @return True on success. False on failure.
@@ -13,8 +18,9 @@ namespace fslib
      *
      * @param directoryPath Path of directories.
      * @return True on success. False on failure.
-     * @note This can be kind of slow. At the moment, I'm not sure if there's a bug or Switch has some kind of limit on folder depth, but
-     * after a certain point this will fail. Use only where <b>absolutely needed</b>.
+     * @note This works backwards from the end of the path until it finds a directory that exists, then only creates what's missing
+     * after it. A few directories known to exist are remembered per device so creating lots of directories next to each other doesn't
+     * check the same parents over and over.
      */
     bool createDirectoriesRecursively(const fslib::Path &directoryPath);
 
@@ -23,16 +29,31 @@ namespace fslib
     /// @return True on success. False on failure.
     bool deleteDirectory(const fslib::Path &directoryPath);
 
-    /// @brief Attempts to delete directory path recursively.
-    /// @param directoryPath Path to target directory.
-    /// @return True on success. False on failure.
-    bool deleteDirectoryRecursively(const fslib::Path &directoryPath);
+    /**
+     * @brief Attempts to delete directory path recursively.
+     *
+     * @param directoryPath Path to target directory. If this is the root of a device, everything in it is deleted instead.
+     * @param progress Optional. Called after each entry is deleted when the fallback is used.
+     * @return True on success. False on failure.
+     * @note FS is asked to delete the whole tree in one request first. If the file system rejects that, the tree is walked and each
+     * entry is deleted one at a time instead. Progress is only reported in that case.
+     */
+    bool deleteDirectoryRecursively(const fslib::Path &directoryPath, const fslib::DeleteProgressFunction &progress = {});
 
-    /// @brief Attempts to open directory for reading to see if it exists. Can also be used to test if something is a directory.
+    /// @brief Checks to see if the directory exists. Can also be used to test if something is a directory.
     /// @param directoryPath Path to the target directory.
     /// @return True on success. False on failure.
     bool directoryExists(const fslib::Path &directoryPath);
 
+    /**
+     * @brief Forgets the directories createDirectoriesRecursively remembers as existing on DeviceName.
+     *
+     * @param deviceName Name of the device.
+     * @note FsLib already does this when deleting or renaming directories and closing devices. This only needs to be called if
+     * directories are removed some other way.
+     */
+    void forgetKnownDirectories(std::string_view deviceName);
+
     /// @brief Attempts to rename OldPath to NewPath.
     /// @param oldPath Original path to target directory.
     /// @param newPath New path to target directory.
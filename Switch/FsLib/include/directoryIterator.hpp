@@ -0,0 +1,156 @@
+#pragma once
+#include "path.hpp"
+#include <memory>
+#include <switch.h>
+
+namespace fslib
+{
+    /**
+     * @brief Reads entries from a directory a batch at a time instead of all at once like fslib::Directory.
+     *
+     * @note Memory use only depends on the batch size, not how many entries the directory has. Entries are returned in whatever
+     * order FS gives them and the directory is kept open until the iterator is closed, reaches the end, or is destroyed.
+     */
+    class DirectoryIterator
+    {
+        public:
+            /// @brief Input iterator used for range based for loops.
+            class Iterator
+            {
+                public:
+                    /// @brief Creates an iterator for Parent. nullptr is the end.
+                    /// @param parent DirectoryIterator entries are read from.
+                    Iterator(fslib::DirectoryIterator *parent) : m_parent(parent) {}
+
+                    /// @brief Returns the current entry.
+                    /// @return Current entry.
+                    const FsDirectoryEntry &operator*(void) const
+                    {
+                        return *m_parent->getEntry();
+                    }
+
+                    /// @brief Moves to the next entry. Becomes the end once there are none left.
+                    /// @return Reference to iterator.
+                    Iterator &operator++(void)
+                    {
+                        if (!m_parent->next())
+                        {
+                            m_parent = nullptr;
+                        }
+                        return *this;
+                    }
+
+                    /// @brief Compares iterators.
+                    /// @param iterator Iterator to compare to.
+                    /// @return True if they aren't the same.
+                    bool operator!=(const Iterator &iterator) const
+                    {
+                        return m_parent != iterator.m_parent;
+                    }
+
+                private:
+                    /// @brief DirectoryIterator being iterated.
+                    fslib::DirectoryIterator *m_parent = nullptr;
+            };
+
+            /// @brief Default constructor.
+            DirectoryIterator(void) = default;
+
+            /**
+             * @brief Attempts to open the directory at DirectoryPath for iterating. IsOpen can be used to check if this was successful.
+             *
+             * @param directoryPath Path to directory.
+             * @param batchSize Optional. Number of entries read from the directory at once.
+             */
+            DirectoryIterator(const fslib::Path &directoryPath, int64_t batchSize = DirectoryIterator::defaultBatchSize);
+
+            /// @brief Closes the directory if it's still open.
+            ~DirectoryIterator();
+
+            /**
+             * @brief Attempts to open the directory at DirectoryPath for iterating.
+             *
+             * @param directoryPath Path to directory.
+             * @param batchSize Optional. Number of entries read from the directory at once.
+             */
+            void open(const fslib::Path &directoryPath, int64_t batchSize = DirectoryIterator::defaultBatchSize);
+
+            /// @brief Closes the directory. This can be called to stop early.
+            void close(void);
+
+            /// @brief Returns if the directory was successfully opened and is still open.
+            /// @return True if it is. False if it isn't.
+            bool isOpen(void) const;
+
+            /**
+             * @brief Returns whether or not opening or reading the directory failed.
+             *
+             * @return True if it did. False if it didn't.
+             * @note next and range based for loops stop the same way at the end of the directory and on an error. Checking this once
+             * they stop tells a listing cut short by an error apart from a complete one.
+             */
+            bool failed(void) const;
+
+            /**
+             * @brief Moves to the next entry in the directory, reading another batch if needed.
+             *
+             * @return True if there is an entry. False at the end of the directory or on error.
+             * @note The directory is closed once this returns false. failed and the error string are only set on an actual error.
+             */
+            bool next(void);
+
+            /// @brief Returns the current entry.
+            /// @return Current entry. nullptr if next hasn't returned true yet.
+            const FsDirectoryEntry *getEntry(void) const;
+
+            /// @brief Returns the name of the current entry.
+            /// @return Name of the entry. nullptr if there isn't one.
+            const char *getName(void) const;
+
+            /// @brief Returns the size of the current entry.
+            /// @return Size of the entry. 0 if there isn't one.
+            int64_t getSize(void) const;
+
+            /// @brief Returns whether or not the current entry is a directory.
+            /// @return True if it is. False if it isn't or there isn't one.
+            bool isDirectory(void) const;
+
+            /// @brief Moves to the first entry and returns an iterator to it.
+            /// @return Iterator to the first entry, or the end if there are none.
+            /// @note Like next, this consumes entries. A DirectoryIterator can only be looped over once per open.
+            Iterator begin(void);
+
+            /// @brief Returns the end iterator.
+            /// @return End iterator.
+            Iterator end(void);
+
+            /// @brief Default number of entries read at once. FsDirectoryEntry is 0x310 bytes, so this is about 49KB.
+            static constexpr int64_t defaultBatchSize = 64;
+
+        private:
+            /// @brief Directory handle.
+            FsDir m_directoryHandle;
+
+            /// @brief Whether or not the directory is open.
+            bool m_isOpen = false;
+
+            /// @brief Whether or not opening or reading the directory failed.
+            bool m_failed = false;
+
+            /// @brief Buffer entries are read into.
+            std::unique_ptr<FsDirectoryEntry[]> m_batch;
+
+            /// @brief Number of entries the batch buffer can hold.
+            int64_t m_batchSize = 0;
+
+            /// @brief Number of entries in the batch buffer from the last read.
+            int64_t m_batchCount = 0;
+
+            /// @brief Index of the current entry in the batch buffer. -1 before the first entry.
+            int64_t m_batchIndex = -1;
+
+            /// @brief Private: Reads the next batch of entries from the directory.
+            /// @return True if any entries were read. False at the end of the directory or on error. m_failed is set on error.
+            bool readBatch(void);
+    };
+} // namespace fslib
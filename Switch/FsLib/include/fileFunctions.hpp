@@ -1,9 +1,38 @@
 #pragma once
 #include "path.hpp"
 #include <cstdint>
+#include <switch.h>
 
 namespace fslib
 {
+    /// @brief Flag for getEntryInfo to fetch the size of files.
+    static constexpr uint8_t ENTRY_INFO_SIZE = BIT(0);
+
+    /// @brief Flag for getEntryInfo to fetch timestamps.
+    static constexpr uint8_t ENTRY_INFO_TIMESTAMPS = BIT(1);
+
+    /// @brief Information about a file or directory returned by getEntryInfo.
+    struct EntryInfo
+    {
+            /// @brief Whether or not the entry is a directory.
+            bool isDirectory = false;
+
+            /// @brief Size of the entry. Always 0 for directories or when the size wasn't requested.
+            int64_t size = 0;
+
+            /// @brief Whether or not the timestamps below were read. Not every file system supports them.
+            bool hasTimestamps = false;
+
+            /// @brief Creation time as a POSIX timestamp.
+            uint64_t created = 0;
+
+            /// @brief Last modification time as a POSIX timestamp.
+            uint64_t modified = 0;
+
+            /// @brief Last access time as a POSIX timestamp.
+            uint64_t accessed = 0;
+    };
+
     /// @brief Attempts to create file with FileSize.
     /// @param filePath Path to file to create.
     /// @param fileSize Optional. The size to use when creating the file.
@@ -25,6 +54,18 @@ namespace fslib
     /// @return File's size on success. -1 on error.
     int64_t getFileSize(const fslib::Path &filePath);
 
+    /**
+     * @brief Gets the type, size, and timestamps of the entry at EntryPath.
+     *
+     * @param entryPath Path of the entry.
+     * @param infoOut Set to the entry's information on success.
+     * @param infoFlags Optional. Which extra information to fetch. The type is always fetched.
+     * @return True on success. False if the entry doesn't exist or on error.
+     * @note Asking for less means fewer requests. The type alone is one request. A file's size is read with the same requests used to
+     * find out it's a file. Timestamps are one more request.
+     */
+    bool getEntryInfo(const fslib::Path &entryPath, fslib::EntryInfo &infoOut, uint8_t infoFlags = ENTRY_INFO_SIZE | ENTRY_INFO_TIMESTAMPS);
+
     /// @brief Attempts to rename OldPath to NewPath.
     /// @param oldPath Original path of target file.
     /// @param newPath New path of target file.
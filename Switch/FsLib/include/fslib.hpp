@@ -1,18 +1,30 @@
 #pragma once
+#include "async.hpp"
+#include "asyncFile.hpp"
 #include "bisFileSystem.hpp"
+#include "copyFunctions.hpp"
 #include "dev.hpp"
 #include "directory.hpp"
 #include "directoryFunctions.hpp"
+#include "directoryIterator.hpp"
+#include "error.hpp"
 #include "file.hpp"
 #include "fileFunctions.hpp"
 #include "path.hpp"
+#include "pathBuilder.hpp"
+#include "pathLiteral.hpp"
+#include "pathView.hpp"
 #include "saveFileSystem.hpp"
 #include "storage.hpp"
+#include "walk.hpp"
 #include <string_view>
 #include <switch.h>
 
 namespace fslib
 {
+    /// @brief Device ID that is never given to a device.
+    static constexpr uint32_t INVALID_DEVICE_ID = 0;
+
     /// @brief Initializes FsLib.
     /// @note Once FsLib::Dev is implemented for Switch this will get more interesting.
     /// @return True on success. False on failure.
@@ -21,8 +33,12 @@ namespace fslib
     /// @brief Exits FsLib closing any remaining open devices.
     void exit(void);
 
-    /// @brief Returns the internal error string for slightly more descriptive errors than a bool.
-    /// @return Internal error string.
+    /**
+     * @brief Returns a string describing the last error on the calling thread for slightly more descriptive errors than a bool.
+     *
+     * @return Error string. This stays valid until getErrorString is called again on the same thread.
+     * @note Errors are recorded per thread as the Result, operation, and path. The string is only built when this is called.
+     */
     const char *getErrorString(void);
 
     /**
@@ -32,11 +48,21 @@ namespace fslib
      * @param fileSystem FileSystem to map to DeviceName.
      * @return True on success. False on failure.
      * @note If a FileSystem is already mapped to DeviceName, it <b>will</b> be unmounted and replaced with FileSystem instead of just
-     * returning NULL like fs_dev. There is also <b>no</b> real limit to how many devices you can have open besides the Switch handle limit.
-     * fs_dev only allows 32 at a time.
+     * returning NULL like fs_dev. Up to 64 devices can be open at once. fs_dev only allows 32 at a time. Device names can be up to 32
+     * characters long. Replacing a device has the same restriction as closeFileSystem.
      */
     bool mapFileSystem(std::string_view deviceName, FsFileSystem *fileSystem);
 
+    /**
+     * @brief Returns the ID of the device mapped to deviceName.
+     *
+     * @param deviceName Name of the device.
+     * @return Device ID. INVALID_DEVICE_ID if nothing is mapped to deviceName.
+     * @note IDs stay valid until the device is closed or remapped and are never reused right away, so holding onto one is safe.
+     * Functions taking an ID fail instead of reaching whatever was mapped to the name afterwards.
+     */
+    uint32_t getDeviceID(std::string_view deviceName);
+
     /// @brief Attempts to find Device in map.
     /// @param deviceName Name of the Device to locate.
     /// @param fileSystemOut Set to pointer to FileSystem handle mapped to DeviceName.
@@ -44,11 +70,33 @@ namespace fslib
     /// @note This isn't really useful outside of internal FsLib functions, but I don't want to hide it like archive_dev does in ctrulib.
     bool getFileSystemByDeviceName(std::string_view deviceName, FsFileSystem **fileSystemOut);
 
+    /// @brief Attempts to find the FileSystem mapped to deviceID.
+    /// @param deviceID ID of the device.
+    /// @param fileSystemOut Set to pointer to FileSystem handle mapped to deviceID.
+    /// @return True if the device is still mapped, false if it isn't.
+    bool getFileSystemByDeviceID(uint32_t deviceID, FsFileSystem **fileSystemOut);
+
+    /**
+     * @brief Attempts to find the FileSystem for path's device.
+     *
+     * @param path Path to find the FileSystem of.
+     * @param fileSystemOut Set to pointer to FileSystem handle mapped to path's device.
+     * @return True if the device is found, false if it isn't.
+     * @note The ID of the device is cached in path. Later calls with the same path skip searching for the device until it's closed or
+     * remapped.
+     */
+    bool getFileSystemByPath(const fslib::Path &path, FsFileSystem **fileSystemOut);
+
     /// @brief Attempts to commit data to DeviceName.
     /// @param deviceName Name of device to commit data to.
     /// @return True on success. False on failure.
     bool commitDataToFileSystem(std::string_view deviceName);
 
+    /// @brief Attempts to commit data to the device with deviceID.
+    /// @param deviceID ID of device to commit data to.
+    /// @return True on success. False on failure.
+    bool commitDataToFileSystem(uint32_t deviceID);
+
     /**
      * @brief Attempts to get the free space available on Device passed.
      *
@@ -69,8 +117,18 @@ namespace fslib
      */
     bool getDeviceTotalSpace(const fslib::Path &deviceRoot, int64_t &sizeOut);
 
-    /// @brief Closes filesystem mapped to DeviceName
-    /// @param deviceName Name of device to close.
-    /// @return True on success. False on Failure or device not found.
+    /**
+     * @brief Closes filesystem mapped to DeviceName
+     *
+     * @param deviceName Name of device to close.
+     * @return True on success. False on Failure or device not found.
+     * @note Only finding a device is safe to race with closing or remapping it. The FileSystem a lookup returns isn't protected once
+     * it's handed out, so nothing can still be using the device on another thread when it's closed or remapped.
+     */
     bool closeFileSystem(std::string_view deviceName);
+
+    /// @brief Closes filesystem with deviceID.
+    /// @param deviceID ID of device to close.
+    /// @return True on success. False on Failure or device not found.
+    bool closeFileSystem(uint32_t deviceID);
 } // namespace fslib
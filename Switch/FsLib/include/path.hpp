@@ -1,9 +1,14 @@
 #pragma once
+#include <atomic>
+#include <cstdint>
 #include <filesystem>
 #include <string>
 
 namespace fslib
 {
+    // Forward declared to avoid a circular include.
+    class PathLiteral;
+
     /// @brief Class to make working with the Switch's FS and it's odd rules much easier.
     class Path
     {
@@ -15,6 +20,10 @@ namespace fslib
             /// @param path Path to assign.
             Path(const Path &path);
 
+            /// @brief Move constructor for Path. Takes path's buffer if it has one instead of copying it.
+            /// @param path Path to move from. path is left empty.
+            Path(Path &&path) noexcept;
+
             /// @brief Constructor for Path. Takes most standard C/C++ string types.
             /// @param pathData String to assign.
             Path(const char *pathData);
@@ -31,6 +40,10 @@ namespace fslib
             /// @param pathData String to assign.
             Path(const std::filesystem::path &pathData);
 
+            /// @brief Constructor for Path. Copies a path checked at compile time without parsing it again.
+            /// @param literal PathLiteral to assign.
+            Path(const fslib::PathLiteral &literal);
+
             /// @brief Frees memory used for path.
             ~Path();
 
@@ -39,7 +52,7 @@ namespace fslib
              *
              * @return True if it is. False if it's not.
              * @note Based on four conditions:
-                    1. The path was properly allocated and m_Path isn't nullptr.
+                    1. The path was assigned successfully and wasn't too long.
                     2. There was a device found in the path.
                     3. The path length following the device is not empty.
                     4. The path has no illegal characters in it.
@@ -89,11 +102,24 @@ namespace fslib
             /// @return Path length.
             size_t getLength(void) const;
 
+            /// @brief Returns the device ID cached by FsLib's internal functions.
+            /// @return Cached device. 0 if nothing has been cached.
+            uint32_t getDeviceCache(void) const;
+
+            /// @brief Caches the device ID for FsLib's internal functions.
+            /// @param deviceCache Value to cache.
+            void setDeviceCache(uint32_t deviceCache) const;
+
             /// @brief Assigns P to Path. Accepts most standard C/C++ string types.
             /// @param pathData Path to assign.
             /// @return Reference to path
             Path &operator=(const Path &path);
 
+            /// @brief Move assigns path to Path. Takes path's buffer if it has one instead of copying it.
+            /// @param path Path to move from. path is left empty.
+            /// @return Reference to path
+            Path &operator=(Path &&path) noexcept;
+
             /// @brief Assigns P to Path. Accepts most standard C/C++ string types.
             /// @param pathData String to assign.
             /// @return Reference to path
@@ -114,6 +140,11 @@ namespace fslib
             /// @return Reference to path
             Path &operator=(const std::filesystem::path &pathData);
 
+            /// @brief Assigns a path checked at compile time without parsing it again.
+            /// @param literal PathLiteral to assign.
+            /// @return Reference to path
+            Path &operator=(const fslib::PathLiteral &literal);
+
             /// @brief Appends P to Path. Adds / if needed. Performs minor checks on P before appending.
             /// @param pathData String to append.
             /// @return Reference to path.
@@ -162,20 +193,39 @@ namespace fslib
              */
             static constexpr uint16_t notFound = -1;
 
+            /// @brief Size of the buffer stored inside Path itself. Paths shorter than this don't allocate anything.
+            static constexpr size_t inlineSize = 0x80;
+
         private:
-            // Path buffer. Switch expects a buffer 0x301 in length. unique_ptr deletes copy operators and I didn't want to use vector.
-            char *m_path = nullptr;
-            // Where the ':' is in the path.
-            char *m_deviceEnd = nullptr;
+            // These work on the buffer directly.
+            friend class PathBuilder;
+            friend class PathView;
+
+            // Buffer used for paths short enough to fit.
+            char m_inlinePath[Path::inlineSize] = {0};
+            // Points to m_inlinePath or a heap buffer for longer paths. Switch allows up to FS_MAX_PATH after the device.
+            char *m_path = m_inlinePath;
+            // Where the ':' is in the path. Path::notFound if there isn't a device.
+            uint16_t m_deviceEnd = Path::notFound;
             // Neither of these are going to exceed 0xFFFF.
             // Actual length of path buffer.
-            uint16_t m_pathSize = 0;
+            uint16_t m_pathSize = Path::inlineSize;
             // Current length of path.
             uint16_t m_pathLength = 0;
-
-            // This allocates the memory to hold the path according to pathSize.
-            bool allocatePath(uint16_t pathSize);
-            // Frees the buffer holding the path data.
+            // ID of the device last resolved for this path. Atomic so a const Path can be shared between threads.
+            mutable std::atomic<uint32_t> m_deviceCache = 0;
+
+            // Parses pathData and assigns it to the path. Paths without a device default to sdmc.
+            void assignPath(const char *pathData, size_t pathLength);
+            // Copies an already checked path. deviceEnd is where the ':' is.
+            void assignCheckedPath(const char *pathData, size_t pathLength, uint16_t deviceEnd);
+            // Appends pathData with / added if needed and the slashes trimmed.
+            void appendPath(const char *pathData, size_t pathLength);
+            // Appends pathData as is.
+            void concatenatePath(const char *pathData, size_t pathLength);
+            // Makes sure the buffer can hold pathSize characters, keeping what's already in it.
+            bool reservePath(size_t pathSize);
+            // Frees the heap buffer if there is one and goes back to the inline buffer.
             void freePath(void);
     };
 
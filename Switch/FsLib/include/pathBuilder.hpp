@@ -0,0 +1,56 @@
+#pragma once
+#include "path.hpp"
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace fslib
+{
+    /**
+     * @brief Builds paths one component at a time in a single buffer.
+     *
+     * @note This is meant for traversal loops. push and pop only touch the component being added or removed, so building the
+     * path of every entry in a tree doesn't copy the parent path or allocate once the buffer has grown to the deepest path. The
+     * builder can be passed to anything that takes a const fslib::Path & without being copied.
+     */
+    class PathBuilder
+    {
+        public:
+            /// @brief Default constructor. The builder is empty until reset is called.
+            PathBuilder(void) = default;
+
+            /// @brief Creates a builder starting at root.
+            /// @param root Path to start at.
+            PathBuilder(const fslib::Path &root);
+
+            /// @brief Replaces the path with root and forgets every component pushed.
+            /// @param root Path to start at.
+            void reset(const fslib::Path &root);
+
+            /// @brief Appends component to the path. Adds / if needed and trims slashes from component.
+            /// @param component Component to append.
+            /// @return True on success. False if the path would be too long. Nothing is pushed in that case.
+            bool push(std::string_view component);
+
+            /// @brief Removes the last component pushed. Does nothing if there are none.
+            void pop(void);
+
+            /// @brief Returns the number of components currently pushed.
+            /// @return Number of components.
+            size_t getDepth(void) const;
+
+            /// @brief Returns the path currently built.
+            /// @return Reference to the path.
+            const fslib::Path &getPath(void) const;
+
+            /// @brief Allows the builder to be passed to fslib functions directly.
+            operator const fslib::Path &(void) const;
+
+        private:
+            /// @brief Path being built.
+            fslib::Path m_path;
+
+            /// @brief Length of the path before each component was pushed.
+            std::vector<uint16_t> m_componentStarts;
+    };
+} // namespace fslib
@@ -0,0 +1,124 @@
+#pragma once
+#include <cstdint>
+#include <string_view>
+#include <switch.h>
+
+namespace fslib
+{
+    /// @brief These are called when a path literal is rejected. They aren't constexpr, so the build stops with the reason in the
+    /// error.
+    namespace pathLiteralError
+    {
+        inline void missingDevice(void) {}
+        inline void missingRootSlash(void) {}
+        inline void forbiddenCharacter(void) {}
+        inline void doubleOrTrailingSlash(void) {}
+        inline void tooLong(void) {}
+    } // namespace pathLiteralError
+
+    /**
+     * @brief Path checked and split at compile time. These are created with the _fsp literal. Ex: "sdmc:/JKSV/config.json"_fsp
+     *
+     * @note Literals need to already be in the form Path would produce: a device, a single / after it, no doubled or trailing
+     * slashes, and no forbidden characters. Anything else fails to compile instead of being fixed up at runtime. Turning one into
+     * a Path is a copy with no parsing. Turning one into a PathView doesn't copy at all.
+     */
+    class PathLiteral
+    {
+        public:
+            /// @brief Checks and splits path. Only usable at compile time.
+            /// @param path String literal.
+            /// @param pathLength Length of the literal.
+            consteval PathLiteral(const char *path, size_t pathLength) : m_path(path), m_pathLength(pathLength)
+            {
+                size_t deviceEnd = 0;
+                while (deviceEnd < pathLength && path[deviceEnd] != ':' && path[deviceEnd] != '/')
+                {
+                    ++deviceEnd;
+                }
+
+                if (deviceEnd == 0 || deviceEnd == pathLength || path[deviceEnd] != ':')
+                {
+                    pathLiteralError::missingDevice();
+                }
+
+                if (deviceEnd + 1 == pathLength || path[deviceEnd + 1] != '/')
+                {
+                    pathLiteralError::missingRootSlash();
+                }
+
+                if (pathLength - (deviceEnd + 1) >= FS_MAX_PATH)
+                {
+                    pathLiteralError::tooLong();
+                }
+
+                for (size_t i = deviceEnd + 1; i < pathLength; i++)
+                {
+                    char character = path[i];
+                    if (character == '<' || character == '>' || character == ':' || character == '"' || character == '|' ||
+                        character == '?' || character == '*')
+                    {
+                        pathLiteralError::forbiddenCharacter();
+                    }
+
+                    // The root is the only place a slash can end the path.
+                    bool isRoot = i == deviceEnd + 1;
+                    bool isLast = i + 1 == pathLength;
+                    if (character == '/' && ((isLast && !isRoot) || (!isLast && path[i + 1] == '/')))
+                    {
+                        pathLiteralError::doubleOrTrailingSlash();
+                    }
+                }
+                m_deviceEnd = deviceEnd;
+            }
+
+            /// @brief Returns the entire path. Ex: sdmc:/Path/To/File.txt
+            /// @return Entire path.
+            constexpr const char *cString(void) const
+            {
+                return m_path;
+            }
+
+            /// @brief Returns the device at the beginning of the path. Ex: sdmc
+            /// @return Device string.
+            constexpr std::string_view getDeviceName(void) const
+            {
+                return std::string_view(m_path, m_deviceEnd);
+            }
+
+            /// @brief Returns the path after the device. Ex: /Path/To/File.txt
+            /// @return Filesystem path.
+            constexpr const char *getPath(void) const
+            {
+                return &m_path[m_deviceEnd + 1];
+            }
+
+            /// @brief Returns the length of the full path.
+            /// @return Path length.
+            constexpr size_t getLength(void) const
+            {
+                return m_pathLength;
+            }
+
+        private:
+            // Literal the path points to. String literals live for the whole program.
+            const char *m_path = nullptr;
+            // Where the ':' is in the path.
+            uint16_t m_deviceEnd = 0;
+            // Length of the path.
+            uint16_t m_pathLength = 0;
+    };
+
+    /// @brief Literals are in their own namespace so they can be pulled in with using namespace fslib::literals.
+    inline namespace literals
+    {
+        /// @brief Creates a PathLiteral checked at compile time. Ex: "sdmc:/JKSV/config.json"_fsp
+        /// @param path String literal.
+        /// @param pathLength Length of the literal.
+        /// @return PathLiteral.
+        consteval fslib::PathLiteral operator""_fsp(const char *path, size_t pathLength)
+        {
+            return fslib::PathLiteral(path, pathLength);
+        }
+    } // namespace literals
+} // namespace fslib
@@ -0,0 +1,64 @@
+#pragma once
+#include <cstdint>
+#include <string_view>
+
+namespace fslib
+{
+    // These need to be forward declared to avoid a circular include.
+    class Path;
+    class PathBuilder;
+    class PathLiteral;
+
+    /**
+     * @brief Non-owning view of a Path or PathBuilder's buffer.
+     *
+     * @note Creating one never copies or allocates. The view is only valid as long as what it was created from is alive and
+     * unchanged.
+     */
+    class PathView
+    {
+        public:
+            /// @brief Default constructor. The view is empty.
+            PathView(void) = default;
+
+            /// @brief Creates a view of path.
+            /// @param path Path to view.
+            PathView(const fslib::Path &path);
+
+            /// @brief Creates a view of the path currently held by builder.
+            /// @param builder PathBuilder to view.
+            PathView(const fslib::PathBuilder &builder);
+
+            /// @brief Creates a view of a path checked at compile time.
+            /// @param literal PathLiteral to view.
+            PathView(const fslib::PathLiteral &literal);
+
+            /// @brief Returns whether or not the path viewed is valid. Same rules as Path::isValid.
+            /// @return True if it is. False if it isn't.
+            bool isValid(void) const;
+
+            /// @brief Returns the entire path. Ex: sdmc:/Path/To/File.txt
+            /// @return Entire path.
+            const char *cString(void) const;
+
+            /// @brief Returns the device at the beginning of the path. Ex: sdmc
+            /// @return Device string.
+            std::string_view getDeviceName(void) const;
+
+            /// @brief Returns the path after the device. Ex: /Path/To/File.txt
+            /// @return Filesystem path.
+            const char *getPath(void) const;
+
+            /// @brief Returns the length of the full path.
+            /// @return Path length.
+            size_t getLength(void) const;
+
+        private:
+            // Start of the path being viewed.
+            const char *m_path = "";
+            // Where the ':' is in the path.
+            uint16_t m_deviceEnd = 0xFFFF;
+            // Length of the path.
+            uint16_t m_pathLength = 0;
+    };
+} // namespace fslib
@@ -1,6 +1,12 @@
 #pragma once
 #include "stream.hpp"
+#include <condition_variable>
+#include <list>
+#include <memory>
+#include <mutex>
 #include <switch.h>
+#include <thread>
+#include <unordered_map>
 
 namespace fslib
 {
@@ -42,12 +48,123 @@ namespace fslib
              */
             ssize_t read(void *buffer, size_t bufferSize);
 
+            /**
+             * @brief Reads from storage into each buffer in vectors in order, starting at the current offset.
+             * @param vectors Buffers to read into.
+             * @return Total number of bytes read. -1 on failure.
+             * @note If everything combined is small enough, it's read with one request and split up afterwards. Otherwise, each buffer
+             * is read directly.
+             */
+            ssize_t readv(std::span<const fslib::ReadVector> vectors);
+
             /// @brief Reads a single byte from storage.
             /// @return Byte read on success. -1 on failure.
             signed char readByte(void);
 
+            /**
+             * @brief Enables or disables the block cache.
+             * @param blockCount Number of blocks the cache holds. Passing 0 disables the cache and frees it.
+             * @param blockSize Optional. Size of each block.
+             * @param readAheadBlocks Optional. Number of blocks read ahead on a second thread when reads are sequential. 0 disables
+             * reading ahead.
+             * @return True on success. False on failure.
+             * @note When enabled, readByte and reads smaller than blockSize are served from cached blocks. The least recently used
+             * block is replaced when the cache is full. Larger reads and readv go straight to the storage.
+             */
+            bool setBlockCache(size_t blockCount, size_t blockSize = 0x4000, size_t readAheadBlocks = 4);
+
+            /// @brief Returns the number of reads served by a block already in the cache.
+            /// @return Number of cache hits.
+            uint64_t getCacheHits(void) const;
+
+            /// @brief Returns the number of reads that had to read a block from storage.
+            /// @return Number of cache misses.
+            uint64_t getCacheMisses(void) const;
+
         private:
+            /// @brief Block of storage held in the cache.
+            struct CacheBlock
+            {
+                    /// @brief Index of the block. -1 if the block isn't holding anything.
+                    int64_t blockIndex = -1;
+
+                    /// @brief Number of valid bytes in the block. This is only less than the block size at the end of the storage.
+                    size_t length = 0;
+
+                    /// @brief Block's data.
+                    std::unique_ptr<unsigned char[]> data;
+            };
+
             /// @brief Handle to storage opened.
             FsStorage m_storageHandle;
+
+            /// @brief Maximum number of blocks in the cache. 0 means the cache is disabled.
+            size_t m_blockCount = 0;
+
+            /// @brief Size of each cached block.
+            size_t m_blockSize = 0;
+
+            /// @brief Number of blocks to read ahead.
+            size_t m_readAheadBlocks = 0;
+
+            /// @brief Cached blocks. The front is the most recently used.
+            std::list<CacheBlock> m_cacheList;
+
+            /// @brief Map of block indexes to their place in the cache list.
+            std::unordered_map<int64_t, std::list<CacheBlock>::iterator> m_cacheMap;
+
+            /// @brief Protects the cache from the read ahead thread.
+            std::mutex m_cacheLock;
+
+            /// @brief Used to wake the read ahead thread.
+            std::condition_variable m_readAheadCondition;
+
+            /// @brief Thread that reads blocks ahead.
+            std::thread m_readAheadThread;
+
+            /// @brief Buffer the read ahead thread reads into.
+            std::unique_ptr<unsigned char[]> m_readAheadBuffer;
+
+            /// @brief First block the read ahead thread should read. -1 if there's nothing to do.
+            int64_t m_readAheadBlock = -1;
+
+            /// @brief Signals the read ahead thread to exit.
+            bool m_readAheadExit = false;
+
+            /// @brief Last block read through the cache. Used to detect sequential reading.
+            int64_t m_lastBlockRead = -1;
+
+            /// @brief Cache hit and miss counters.
+            uint64_t m_cacheHits = 0, m_cacheMisses = 0;
+
+            /// @brief Reads from the cache at the current offset.
+            /// @param buffer Buffer to read into.
+            /// @param bufferSize Size of Buffer.
+            /// @return Number of bytes read. -1 on failure.
+            ssize_t readFromCache(void *buffer, size_t bufferSize);
+
+            /// @brief Returns the block at blockIndex, reading it from storage if it isn't cached. m_cacheLock must be held.
+            /// @param blockIndex Index of the block.
+            /// @return Pointer to the block on success. nullptr on failure.
+            CacheBlock *getBlock(int64_t blockIndex);
+
+            /**
+             * @brief Makes room for blockIndex and places it before position in blockList. m_cacheLock must be held.
+             *
+             * @param blockIndex Index of the block.
+             * @param blockList List to place the block in. This is m_cacheList or a list of blocks that will be spliced into it.
+             * @param position Position in blockList to place the block before.
+             * @return Pointer to the empty block on success. nullptr if memory couldn't be allocated or there's nothing left to reuse.
+             */
+            CacheBlock *insertBlock(int64_t blockIndex, std::list<CacheBlock> &blockList, std::list<CacheBlock>::iterator position);
+
+            /// @brief Starts the read ahead thread if it's enabled.
+            void startReadAhead(void);
+
+            /// @brief Stops the read ahead thread if it's running.
+            void stopReadAhead(void);
+
+            /// @brief Function the read ahead thread runs.
+            void readAheadThreadFunction(void);
     };
 } // namespace fslib
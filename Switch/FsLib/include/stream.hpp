@@ -1,9 +1,31 @@
 #pragma once
+#include "hash.hpp"
 #include <cstddef>
+#include <span>
 #include <sys/types.h>
 
 namespace fslib
 {
+    /// @brief Buffer used for vectored reads.
+    struct ReadVector
+    {
+            /// @brief Buffer to read into.
+            void *buffer;
+
+            /// @brief Size of Buffer.
+            size_t bufferSize;
+    };
+
+    /// @brief Buffer used for vectored writes.
+    struct WriteVector
+    {
+            /// @brief Buffer to write from.
+            const void *buffer;
+
+            /// @brief Size of Buffer.
+            size_t bufferSize;
+    };
+
     /// @brief This is the base class all File and storage types are derived from.
     class Stream
     {
@@ -11,6 +33,9 @@ namespace fslib
             /// @brief Default Stream constructor.
             Stream(void) = default;
 
+            /// @brief Virtual so derived streams are destroyed correctly through a Stream pointer.
+            virtual ~Stream() = default;
+
             /// @brief Checks if stream was successfully opened.
             /// @return True on success. False on failure.
             bool isOpen(void) const;
@@ -36,8 +61,18 @@ namespace fslib
              *      1. FsLib::SeekOrigin::Beginning
              *      2. FsLib::SeekOrigin::Current
              *      3. FsLib::SeekOrigin::End
+             * @note This is virtual so streams that buffer data, like File, can flush it first even when seeking through a Stream.
              */
-            void seek(int64_t offset, uint8_t origin);
+            virtual void seek(int64_t offset, uint8_t origin);
+
+            /**
+             * @brief Attaches a hasher to the stream. Everything read through read, readv, and File's readLine and getByte is fed to it
+             * as it's read.
+             * @param hasher Hasher to attach. Passing nullptr detaches the current one.
+             * @note Positional reads aren't hashed since they don't move through the stream in order. The hasher isn't owned by the stream
+             * and needs to outlive it or be detached.
+             */
+            void setHasher(fslib::Hasher *hasher);
 
             /// @brief Used to seek from the beginning of the stream.
             static constexpr uint8_t beginning = 0;
@@ -59,7 +94,49 @@ namespace fslib
             /// @note This is handled by derived classes.
             bool m_isOpen = false;
 
+            /// @brief Optional hasher data read is fed to.
+            fslib::Hasher *m_hasher = nullptr;
+
+            /// @brief Feeds data to the hasher if one is attached.
+            /// @param data Data to hash.
+            /// @param dataSize Size of data.
+            inline void hashData(const void *data, size_t dataSize)
+            {
+                if (m_hasher && dataSize > 0)
+                {
+                    m_hasher->update(data, dataSize);
+                }
+            }
+
             /// @brief Ensures offset isn't out of bounds after a seek is performed.
             void ensureOffsetIsValid(void);
+
+            /// @brief Vectored reads and writes at or below this size go through one staging buffer and a single request.
+            static constexpr size_t vectorStagingLimit = 0x10000;
+
+            /// @brief Returns the combined size of all the buffers in vectors.
+            /// @param vectors Vectors to total.
+            /// @return Combined size.
+            template <typename VectorType>
+            static size_t getVectorSize(std::span<const VectorType> vectors)
+            {
+                size_t totalSize = 0;
+                for (const VectorType &vector : vectors)
+                {
+                    totalSize += vector.bufferSize;
+                }
+                return totalSize;
+            }
+
+            /// @brief Copies data from a staging buffer out to the buffers in vectors in order.
+            /// @param source Staging buffer to copy from.
+            /// @param sourceSize Number of valid bytes in Source.
+            /// @param vectors Vectors to copy to.
+            static void scatterToVectors(const unsigned char *source, size_t sourceSize, std::span<const fslib::ReadVector> vectors);
+
+            /// @brief Copies the buffers in vectors into one staging buffer in order.
+            /// @param vectors Vectors to copy from.
+            /// @param destination Staging buffer to copy to. This must be big enough to hold everything in vectors.
+            static void gatherFromVectors(std::span<const fslib::WriteVector> vectors, unsigned char *destination);
     };
 } // namespace fslib
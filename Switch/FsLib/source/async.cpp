@@ -0,0 +1,324 @@
+#include "async.hpp"
+#include "fslib.hpp"
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Defined out here so the header only needs the forward declaration. Everything in it is guarded by s_poolLock.
+class fslib::async::Strand
+{
+    public:
+        // Tasks waiting to run in the order they were submitted.
+        std::deque<fslib::async::Task> tasks;
+        // Whether the strand is in the ready queue or one of its tasks is running.
+        bool isScheduled = false;
+        // Tasks submitted that haven't finished yet, including the one running.
+        size_t pendingCount = 0;
+};
+
+namespace
+{
+    // Either a task to run on its own or a strand to run the next task of.
+    struct Job
+    {
+            std::shared_ptr<fslib::async::Strand> strand;
+            fslib::async::Task task;
+    };
+
+    // Everything below is guarded by this.
+    std::mutex s_poolLock;
+    // Workers wait on this for jobs.
+    std::condition_variable s_workCondition;
+    // Submitters wait on this for room in the queue.
+    std::condition_variable s_spaceCondition;
+    // Signalled every time a task finishes. waitForStrand and exit wait on this.
+    std::condition_variable s_idleCondition;
+    // Jobs ready to run. Strands are only in here once no matter how many tasks they have waiting.
+    std::deque<Job> s_readyJobs;
+    std::vector<std::thread> s_workers;
+    // Tasks submitted that haven't finished yet. Submitting blocks once this reaches s_queueSize.
+    size_t s_pendingTasks = 0;
+    size_t s_queueSize = 0;
+    bool s_isRunning = false;
+    bool s_isStopping = false;
+
+    // Submitting from a worker doesn't wait for room. If every worker did, nothing would ever finish to make some.
+    thread_local bool t_isWorker = false;
+    // Strand whose task the worker is running. nullptr if it isn't running one.
+    thread_local fslib::async::Strand *t_currentStrand = nullptr;
+} // namespace
+
+// Marks a task as finished and wakes anything waiting on it. This expects s_poolLock to be held.
+static void finishTask(fslib::async::Strand *strand)
+{
+    --s_pendingTasks;
+    if (strand)
+    {
+        --strand->pendingCount;
+    }
+    s_spaceCondition.notify_one();
+    s_idleCondition.notify_all();
+}
+
+static void worker(void)
+{
+    t_isWorker = true;
+
+    std::unique_lock<std::mutex> poolLock(s_poolLock);
+    while (true)
+    {
+        s_workCondition.wait(poolLock, []() { return s_isStopping || !s_readyJobs.empty(); });
+        if (s_readyJobs.empty())
+        {
+            return;
+        }
+
+        Job job = std::move(s_readyJobs.front());
+        s_readyJobs.pop_front();
+
+        // Only one task from a strand is taken at a time so its tasks stay in order.
+        fslib::async::Task task;
+        if (job.strand)
+        {
+            task = std::move(job.strand->tasks.front());
+            job.strand->tasks.pop_front();
+        }
+        else
+        {
+            task = std::move(job.task);
+        }
+
+        poolLock.unlock();
+        t_currentStrand = job.strand.get();
+        task();
+        t_currentStrand = nullptr;
+        // The task's captures need to be gone before anything waiting on it is woken up.
+        task = nullptr;
+        poolLock.lock();
+
+        finishTask(job.strand.get());
+        if (job.strand)
+        {
+            // The strand goes to the back so other handles and devices get a turn between its tasks.
+            if (job.strand->tasks.empty())
+            {
+                job.strand->isScheduled = false;
+            }
+            else
+            {
+                s_readyJobs.push_back(std::move(job));
+                s_workCondition.notify_one();
+            }
+        }
+    }
+}
+
+// This expects s_poolLock to be held.
+static void startPool(const fslib::async::Options &options)
+{
+    size_t workerCount = options.workerCount > 0 ? options.workerCount : 1;
+    s_queueSize = options.queueSize > 0 ? options.queueSize : 1;
+    s_isRunning = true;
+
+    s_workers.reserve(workerCount);
+    for (size_t i = 0; i < workerCount; i++)
+    {
+        s_workers.emplace_back(worker);
+    }
+}
+
+bool fslib::async::initialize(const fslib::async::Options &options)
+{
+    std::lock_guard<std::mutex> poolLock(s_poolLock);
+    if (s_isRunning)
+    {
+        return false;
+    }
+    startPool(options);
+    return true;
+}
+
+void fslib::async::exit(void)
+{
+    // A worker would be waiting on its own task to finish and then joining itself.
+    if (t_isWorker)
+    {
+        return;
+    }
+
+    std::vector<std::thread> workers;
+    {
+        std::unique_lock<std::mutex> poolLock(s_poolLock);
+        if (!s_isRunning)
+        {
+            return;
+        }
+        s_idleCondition.wait(poolLock, []() { return s_pendingTasks == 0; });
+        s_isStopping = true;
+        workers.swap(s_workers);
+    }
+    s_workCondition.notify_all();
+
+    for (std::thread &worker : workers)
+    {
+        worker.join();
+    }
+
+    std::lock_guard<std::mutex> poolLock(s_poolLock);
+    s_isRunning = false;
+    s_isStopping = false;
+}
+
+std::future<fslib::async::Completion<ssize_t>> fslib::async::readFile(const fslib::Path &filePath,
+                                                                      void *buffer,
+                                                                      size_t bufferSize,
+                                                                      fslib::async::CompletionFunction<ssize_t> onComplete)
+{
+    return fslib::async::request<ssize_t>(
+        nullptr,
+        [filePath, buffer, bufferSize]() -> ssize_t {
+            fslib::File file(filePath, FsOpenMode_Read);
+            if (!file.isOpen())
+            {
+                return -1;
+            }
+            return file.read(buffer, bufferSize);
+        },
+        [](ssize_t value) { return value < 0; },
+        std::move(onComplete));
+}
+
+std::future<fslib::async::Completion<ssize_t>> fslib::async::writeFile(const fslib::Path &filePath,
+                                                                       const void *buffer,
+                                                                       size_t bufferSize,
+                                                                       fslib::async::CompletionFunction<ssize_t> onComplete)
+{
+    return fslib::async::request<ssize_t>(
+        nullptr,
+        [filePath, buffer, bufferSize]() -> ssize_t {
+            fslib::File file(filePath, FsOpenMode_Create | FsOpenMode_Write, static_cast<int64_t>(bufferSize));
+            if (!file.isOpen())
+            {
+                return -1;
+            }
+            return file.write(buffer, bufferSize);
+        },
+        [](ssize_t value) { return value < 0; },
+        std::move(onComplete));
+}
+
+std::future<fslib::async::Completion<std::shared_ptr<fslib::Directory>>> fslib::async::listDirectory(
+    const fslib::Path &directoryPath,
+    bool sortedListing,
+    fslib::async::CompletionFunction<std::shared_ptr<fslib::Directory>> onComplete)
+{
+    return fslib::async::request<std::shared_ptr<fslib::Directory>>(
+        nullptr,
+        [directoryPath, sortedListing]() -> std::shared_ptr<fslib::Directory> {
+            std::shared_ptr<fslib::Directory> directory(new (std::nothrow) fslib::Directory(directoryPath, sortedListing));
+            if (!directory || !directory->isOpen())
+            {
+                return nullptr;
+            }
+            return directory;
+        },
+        [](const std::shared_ptr<fslib::Directory> &value) { return !value; },
+        std::move(onComplete));
+}
+
+std::future<fslib::async::Completion<bool>> fslib::async::deleteFile(const fslib::Path &filePath,
+                                                                     fslib::async::CompletionFunction<bool> onComplete)
+{
+    return fslib::async::request<bool>(
+        nullptr,
+        [filePath]() { return fslib::deleteFile(filePath); },
+        [](bool value) { return !value; },
+        std::move(onComplete));
+}
+
+std::future<fslib::async::Completion<bool>> fslib::async::deleteDirectory(const fslib::Path &directoryPath,
+                                                                          fslib::async::CompletionFunction<bool> onComplete)
+{
+    return fslib::async::request<bool>(
+        nullptr,
+        [directoryPath]() { return fslib::deleteDirectory(directoryPath); },
+        [](bool value) { return !value; },
+        std::move(onComplete));
+}
+
+std::future<fslib::async::Completion<bool>> fslib::async::deleteDirectoryRecursively(
+    const fslib::Path &directoryPath,
+    fslib::async::CompletionFunction<bool> onComplete)
+{
+    return fslib::async::request<bool>(
+        nullptr,
+        [directoryPath]() { return fslib::deleteDirectoryRecursively(directoryPath); },
+        [](bool value) { return !value; },
+        std::move(onComplete));
+}
+
+std::shared_ptr<fslib::async::Strand> fslib::async::createStrand(void)
+{
+    return std::make_shared<fslib::async::Strand>();
+}
+
+void fslib::async::submit(const std::shared_ptr<fslib::async::Strand> &strand, fslib::async::Task task)
+{
+    std::unique_lock<std::mutex> poolLock(s_poolLock);
+    if (!s_isRunning)
+    {
+        startPool({});
+    }
+
+    if (!t_isWorker)
+    {
+        s_spaceCondition.wait(poolLock, []() { return s_pendingTasks < s_queueSize; });
+    }
+    ++s_pendingTasks;
+
+    if (!strand)
+    {
+        s_readyJobs.push_back({nullptr, std::move(task)});
+    }
+    else
+    {
+        strand->tasks.push_back(std::move(task));
+        ++strand->pendingCount;
+        // A strand that's already scheduled picks this up after the tasks in front of it.
+        if (strand->isScheduled)
+        {
+            return;
+        }
+        strand->isScheduled = true;
+        s_readyJobs.push_back({strand, {}});
+    }
+    poolLock.unlock();
+    s_workCondition.notify_one();
+}
+
+void fslib::async::waitForStrand(const std::shared_ptr<fslib::async::Strand> &strand)
+{
+    std::unique_lock<std::mutex> poolLock(s_poolLock);
+    if (t_currentStrand != strand.get())
+    {
+        s_idleCondition.wait(poolLock, [&strand]() { return strand->pendingCount == 0; });
+        return;
+    }
+
+    // This is one of the strand's own tasks, so nothing queued behind it can run until it returns. Those are run here instead, in
+    // order. The calling task is still pending, but it's finished with everything waiting on the strand cares about.
+    while (!strand->tasks.empty())
+    {
+        fslib::async::Task task = std::move(strand->tasks.front());
+        strand->tasks.pop_front();
+
+        poolLock.unlock();
+        task();
+        task = nullptr;
+        poolLock.lock();
+
+        finishTask(strand.get());
+    }
+}
@@ -1,17 +1,15 @@
 #include "bisFileSystem.hpp"
+#include "error.hpp"
 #include "fslib.hpp"
-#include "string.hpp"
 #include <string>
 
-extern std::string g_fslibErrorString;
-
 bool fslib::openBisFileSystem(std::string_view deviceName, FsBisPartitionId partitionID)
 {
     FsFileSystem fileSystem;
     Result fsError = fsOpenBisFileSystem(&fileSystem, partitionID, "");
     if (R_FAILED(fsError))
     {
-        g_fslibErrorString = string::getFormattedString("Error opening BIS filesystem: 0x%08.", fsError);
+        fslib::error::setResult(fslib::Operation::OpenFileSystem, fsError, deviceName);
         return false;
     }
 
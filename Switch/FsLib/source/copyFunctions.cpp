@@ -0,0 +1,678 @@
+#include "copyFunctions.hpp"
+#include "error.hpp"
+#include "file.hpp"
+#include "fslib.hpp"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    // Default buffer size if options passed 0.
+    constexpr size_t DEFAULT_BUFFER_SIZE = 0x80000;
+    // Reading and writing can't overlap with less than this.
+    constexpr size_t MINIMUM_BUFFER_COUNT = 2;
+    // Every file being copied has its source and destination open.
+    constexpr size_t HANDLES_PER_FILE = 2;
+    // Reading the source tree needs a directory handle open.
+    constexpr size_t SCAN_HANDLES = 1;
+
+    // Shared between the reading thread and the writing one. Buffers are handed back and forth by index, so nothing is ever copied.
+    struct CopyRing
+    {
+            std::mutex ringLock;
+            std::condition_variable ringCondition;
+            std::vector<std::unique_ptr<unsigned char[]>> buffers;
+            std::vector<size_t> bufferLengths;
+            size_t bufferSize = 0;
+            size_t buffersFull = 0;
+            bool readFailed = false;
+            bool writeFailed = false;
+            // Errors are recorded per thread, so the reading thread leaves its error here for the writing one.
+            fslib::error::Record readError;
+    };
+
+    // Files waiting to be copied by copyDirectoryRecursively's workers. Source is first, destination is second.
+    struct CopyQueue
+    {
+            std::mutex queueLock;
+            std::condition_variable queueCondition;
+            std::deque<std::pair<fslib::Path, fslib::Path>> jobs;
+            bool scanFinished = false;
+            bool failed = false;
+            // Set if a worker was the first to fail. Its error is recorded again on the calling thread once the workers are done.
+            bool workerFailed = false;
+            fslib::error::Record workerError;
+            int64_t fileCount = 0;
+            int64_t bytesCopied = 0;
+    };
+
+    // Shared between dumpStorage's reading, writing, and hashing threads. A chunk can only be read into again once every thread
+    // using it is finished with it.
+    struct DumpRing
+    {
+            std::mutex ringLock;
+            std::condition_variable ringCondition;
+            std::vector<std::unique_ptr<unsigned char[]>> buffers;
+            std::vector<size_t> bufferLengths;
+            std::vector<int> usersRemaining;
+            size_t bufferSize = 0;
+            int usersPerChunk = 0;
+            int64_t chunksRead = 0;
+            bool readFailed = false;
+            bool failed = false;
+            // Errors are recorded per thread, so the reading thread leaves its error here for the writing one.
+            fslib::error::Record readError;
+    };
+} // namespace
+
+// Reads sourceFile into the ring until it's done or the writing side gives up.
+static void readThreadFunction(fslib::File &sourceFile, CopyRing &ring, int64_t fileSize, fslib::Hasher *hasher)
+{
+    size_t bufferCount = ring.buffers.size();
+    int64_t totalBytesRead = 0;
+    for (size_t readIndex = 0; totalBytesRead < fileSize; readIndex = (readIndex + 1) % bufferCount)
+    {
+        {
+            std::unique_lock<std::mutex> ringLock(ring.ringLock);
+            ring.ringCondition.wait(ringLock, [&ring, bufferCount]() { return ring.buffersFull < bufferCount || ring.writeFailed; });
+            if (ring.writeFailed)
+            {
+                return;
+            }
+        }
+
+        // This buffer belongs to this thread until it's marked full, so the lock isn't needed to read into it or hash it.
+        // Cleared first so a read that comes up short can be told apart from one that recorded an FS error.
+        fslib::error::clear();
+        ssize_t bytesRead = sourceFile.read(ring.buffers[readIndex].get(), ring.bufferSize);
+        if (hasher && bytesRead > 0)
+        {
+            hasher->update(ring.buffers[readIndex].get(), bytesRead);
+        }
+        else if (bytesRead == 0 && fslib::getLastOperation() == fslib::Operation::None)
+        {
+            // This isn't an FS error, but something still needs to be recorded for the writing thread.
+            fslib::error::setReason(fslib::Operation::ReadFile, "File ended before it was fully read.");
+        }
+        {
+            std::lock_guard<std::mutex> ringLock(ring.ringLock);
+            if (bytesRead <= 0)
+            {
+                ring.readFailed = true;
+                ring.readError = fslib::error::capture();
+            }
+            else
+            {
+                ring.bufferLengths[readIndex] = bytesRead;
+                ++ring.buffersFull;
+            }
+        }
+        ring.ringCondition.notify_all();
+
+        if (bytesRead <= 0)
+        {
+            return;
+        }
+        totalBytesRead += bytesRead;
+    }
+}
+
+// Copies source to destination through buffer one chunk at a time on the calling thread. copyDirectoryRecursively's workers use this
+// instead of copyFile so each worker only ever has its own buffer and no reading thread of its own.
+static bool copyFileWithBuffer(const fslib::Path &source,
+                               const fslib::Path &destination,
+                               unsigned char *buffer,
+                               size_t bufferSize,
+                               const fslib::CopyOptions &options,
+                               int64_t &bytesCopiedOut)
+{
+    fslib::File sourceFile(source, FsOpenMode_Read);
+    if (!sourceFile.isOpen())
+    {
+        return false;
+    }
+
+    int64_t fileSize = sourceFile.getSize();
+    fslib::File destinationFile(destination, FsOpenMode_Create | FsOpenMode_Write, fileSize);
+    if (!destinationFile.isOpen())
+    {
+        return false;
+    }
+
+    int64_t totalBytesCopied = 0;
+    while (totalBytesCopied < fileSize)
+    {
+        ssize_t chunkSize = static_cast<ssize_t>(std::min(static_cast<int64_t>(bufferSize), fileSize - totalBytesCopied));
+        if (sourceFile.read(buffer, chunkSize) != chunkSize || destinationFile.write(buffer, chunkSize) != chunkSize)
+        {
+            return false;
+        }
+        totalBytesCopied += chunkSize;
+
+        if (options.progress)
+        {
+            options.progress(totalBytesCopied, fileSize);
+        }
+    }
+    bytesCopiedOut = totalBytesCopied;
+    return true;
+}
+
+// Marks the queue as failed and keeps the calling worker's error if nothing failed before it. Only called with the queue's lock held.
+static void setWorkerFailed(CopyQueue &queue)
+{
+    if (!queue.failed)
+    {
+        queue.workerFailed = true;
+        queue.workerError = fslib::error::capture();
+    }
+    queue.failed = true;
+    queue.queueCondition.notify_all();
+}
+
+// Copies files from the queue until it's empty and the scan is finished or something fails.
+static void copyWorkerFunction(CopyQueue &queue, const fslib::CopyOptions &options, size_t bufferSize)
+{
+    std::unique_ptr<unsigned char[]> buffer(new (std::nothrow) unsigned char[bufferSize]);
+    if (!buffer)
+    {
+        std::lock_guard<std::mutex> queueLock(queue.queueLock);
+        fslib::error::setReason(fslib::Operation::Copy, "Couldn't allocate copy buffers.");
+        setWorkerFailed(queue);
+        return;
+    }
+
+    std::pair<fslib::Path, fslib::Path> job;
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> queueLock(queue.queueLock);
+            queue.queueCondition.wait(queueLock, [&queue]() { return !queue.jobs.empty() || queue.scanFinished || queue.failed; });
+            if (queue.failed || queue.jobs.empty())
+            {
+                return;
+            }
+            job = queue.jobs.front();
+            queue.jobs.pop_front();
+        }
+
+        int64_t bytesCopied = 0;
+        bool copied = copyFileWithBuffer(job.first, job.second, buffer.get(), bufferSize, options, bytesCopied);
+        {
+            std::lock_guard<std::mutex> queueLock(queue.queueLock);
+            if (!copied)
+            {
+                setWorkerFailed(queue);
+                return;
+            }
+            ++queue.fileCount;
+            queue.bytesCopied += bytesCopied;
+        }
+    }
+}
+
+// Returns whether block is entirely zeros. Comparing the block against itself shifted by one lets memcmp do the work.
+static bool isZeroBlock(const unsigned char *block, size_t blockSize)
+{
+    return blockSize == 0 || (block[0] == 0x00 && std::memcmp(block, block + 1, blockSize - 1) == 0);
+}
+
+// Reads the storage into the dump ring chunk by chunk.
+static void dumpReadThreadFunction(fslib::Storage &storage, DumpRing &ring, int64_t chunkCount)
+{
+    size_t bufferCount = ring.buffers.size();
+    for (int64_t chunk = 0; chunk < chunkCount; chunk++)
+    {
+        size_t readIndex = chunk % bufferCount;
+        {
+            std::unique_lock<std::mutex> ringLock(ring.ringLock);
+            ring.ringCondition.wait(ringLock, [&ring, readIndex]() { return ring.usersRemaining[readIndex] == 0 || ring.failed; });
+            if (ring.failed)
+            {
+                return;
+            }
+        }
+
+        ssize_t bytesRead = storage.read(ring.buffers[readIndex].get(), ring.bufferSize);
+        if (bytesRead == 0)
+        {
+            // Read errors return -1 and already recorded their Result. This is the storage coming up short.
+            fslib::error::setReason(fslib::Operation::ReadStorage, "Storage ended before it was fully read.");
+        }
+        {
+            std::lock_guard<std::mutex> ringLock(ring.ringLock);
+            if (bytesRead <= 0)
+            {
+                ring.readFailed = true;
+                ring.readError = fslib::error::capture();
+            }
+            else
+            {
+                ring.bufferLengths[readIndex] = bytesRead;
+                ring.usersRemaining[readIndex] = ring.usersPerChunk;
+                ++ring.chunksRead;
+            }
+        }
+        ring.ringCondition.notify_all();
+
+        if (bytesRead <= 0)
+        {
+            return;
+        }
+    }
+}
+
+// Waits for chunk to be read. Returns false if reading failed or something else did.
+static bool waitForChunk(DumpRing &ring, int64_t chunk)
+{
+    std::unique_lock<std::mutex> ringLock(ring.ringLock);
+    ring.ringCondition.wait(ringLock, [&ring, chunk]() { return ring.chunksRead > chunk || ring.readFailed || ring.failed; });
+    return ring.chunksRead > chunk && !ring.failed;
+}
+
+// Marks the caller as finished with the buffer at index. If success is false, everything else is told to stop.
+static void releaseChunk(DumpRing &ring, size_t index, bool success)
+{
+    {
+        std::lock_guard<std::mutex> ringLock(ring.ringLock);
+        --ring.usersRemaining[index];
+        ring.failed = ring.failed || !success;
+    }
+    ring.ringCondition.notify_all();
+}
+
+// Hashes every chunk as it's read.
+static void dumpHashThreadFunction(DumpRing &ring, int64_t chunkCount, fslib::Hasher &hasher)
+{
+    size_t bufferCount = ring.buffers.size();
+    for (int64_t chunk = 0; chunk < chunkCount; chunk++)
+    {
+        if (!waitForChunk(ring, chunk))
+        {
+            return;
+        }
+
+        size_t index = chunk % bufferCount;
+        hasher.update(ring.buffers[index].get(), ring.bufferLengths[index]);
+        releaseChunk(ring, index, true);
+    }
+}
+
+// Writes everything in chunk that isn't a zero block. Runs of data are written together.
+static bool writeChunk(fslib::File &destinationFile,
+                       const unsigned char *chunk,
+                       size_t chunkLength,
+                       int64_t chunkOffset,
+                       const fslib::DumpOptions &options,
+                       fslib::DumpResult &result)
+{
+    if (!options.skipZeroBlocks)
+    {
+        if (destinationFile.writeAt(chunkOffset, chunk, chunkLength) != static_cast<ssize_t>(chunkLength))
+        {
+            return false;
+        }
+        result.bytesWritten += chunkLength;
+        return true;
+    }
+
+    size_t runStart = 0;
+    for (size_t blockOffset = 0; blockOffset < chunkLength; blockOffset += options.zeroBlockSize)
+    {
+        size_t blockLength = std::min(options.zeroBlockSize, chunkLength - blockOffset);
+        if (!isZeroBlock(&chunk[blockOffset], blockLength))
+        {
+            continue;
+        }
+
+        // Write out whatever data came before this block.
+        size_t runLength = blockOffset - runStart;
+        if (runLength > 0 && destinationFile.writeAt(chunkOffset + runStart, &chunk[runStart], runLength) != static_cast<ssize_t>(runLength))
+        {
+            return false;
+        }
+        result.bytesWritten += runLength;
+        runStart = blockOffset + blockLength;
+
+        // Merge with the last range if they touch.
+        int64_t zeroOffset = chunkOffset + blockOffset;
+        if (!result.zeroRanges.empty() && result.zeroRanges.back().first + result.zeroRanges.back().second == zeroOffset)
+        {
+            result.zeroRanges.back().second += blockLength;
+        }
+        else
+        {
+            result.zeroRanges.emplace_back(zeroOffset, blockLength);
+        }
+        result.zeroBytesSkipped += blockLength;
+    }
+
+    size_t runLength = chunkLength - runStart;
+    if (runLength > 0 && destinationFile.writeAt(chunkOffset + runStart, &chunk[runStart], runLength) != static_cast<ssize_t>(runLength))
+    {
+        return false;
+    }
+    result.bytesWritten += runLength;
+    return true;
+}
+
+bool fslib::copyFile(const fslib::Path &source, const fslib::Path &destination, const fslib::CopyOptions &options)
+{
+    fslib::File sourceFile(source, FsOpenMode_Read);
+    if (!sourceFile.isOpen())
+    {
+        return false;
+    }
+
+    // Creating the destination at full size up front means it never has to be resized while copying.
+    int64_t fileSize = sourceFile.getSize();
+    fslib::File destinationFile(destination, FsOpenMode_Create | FsOpenMode_Write, fileSize);
+    if (!destinationFile.isOpen())
+    {
+        return false;
+    }
+
+    CopyRing ring;
+    ring.bufferSize = options.bufferSize > 0 ? options.bufferSize : DEFAULT_BUFFER_SIZE;
+    size_t bufferCount = std::max(options.bufferCount, MINIMUM_BUFFER_COUNT);
+    // No reason to allocate buffers that will never be used.
+    int64_t buffersNeeded = (fileSize + ring.bufferSize - 1) / ring.bufferSize;
+    if (buffersNeeded < static_cast<int64_t>(bufferCount))
+    {
+        bufferCount = std::max(static_cast<size_t>(buffersNeeded), static_cast<size_t>(1));
+    }
+
+    ring.buffers.resize(bufferCount);
+    ring.bufferLengths.resize(bufferCount, 0);
+    for (std::unique_ptr<unsigned char[]> &buffer : ring.buffers)
+    {
+        buffer.reset(new (std::nothrow) unsigned char[ring.bufferSize]);
+        if (!buffer)
+        {
+            fslib::error::setReason(fslib::Operation::Copy, "Couldn't allocate copy buffers.");
+            return false;
+        }
+    }
+
+    std::thread readThread(readThreadFunction, std::ref(sourceFile), std::ref(ring), fileSize, options.hasher);
+
+    int64_t totalBytesWritten = 0;
+    for (size_t writeIndex = 0; totalBytesWritten < fileSize; writeIndex = (writeIndex + 1) % bufferCount)
+    {
+        {
+            std::unique_lock<std::mutex> ringLock(ring.ringLock);
+            ring.ringCondition.wait(ringLock, [&ring]() { return ring.buffersFull > 0 || ring.readFailed; });
+            // The reading thread's error is recorded on this thread once it's joined.
+            if (ring.buffersFull == 0)
+            {
+                break;
+            }
+        }
+
+        size_t writeLength = ring.bufferLengths[writeIndex];
+        ssize_t bytesWritten = destinationFile.write(ring.buffers[writeIndex].get(), writeLength);
+        {
+            std::lock_guard<std::mutex> ringLock(ring.ringLock);
+            if (bytesWritten != static_cast<ssize_t>(writeLength))
+            {
+                ring.writeFailed = true;
+            }
+            else
+            {
+                --ring.buffersFull;
+            }
+        }
+        ring.ringCondition.notify_all();
+
+        if (bytesWritten != static_cast<ssize_t>(writeLength))
+        {
+            break;
+        }
+        totalBytesWritten += bytesWritten;
+
+        if (options.progress)
+        {
+            options.progress(totalBytesWritten, fileSize);
+        }
+    }
+    readThread.join();
+
+    // A failed write already recorded its own error on this thread.
+    if (ring.readFailed && !ring.writeFailed)
+    {
+        fslib::error::restore(ring.readError);
+    }
+    return totalBytesWritten == fileSize;
+}
+
+bool fslib::copyDirectoryRecursively(const fslib::Path &source,
+                                     const fslib::Path &destination,
+                                     const fslib::DirectoryCopyOptions &options,
+                                     fslib::CopyStats *statsOut)
+{
+    std::chrono::steady_clock::time_point copyStart = std::chrono::steady_clock::now();
+
+    if (!fslib::directoryExists(destination) && !fslib::createDirectory(destination))
+    {
+        return false;
+    }
+
+    // Every file being copied has a source and destination handle open and one is needed to read directories.
+    size_t availableHandles = options.maxOpenHandles > SCAN_HANDLES ? options.maxOpenHandles - SCAN_HANDLES : 0;
+    size_t workerCount = std::min(options.workerCount, availableHandles / HANDLES_PER_FILE);
+    workerCount = std::max(workerCount, static_cast<size_t>(1));
+
+    // One hasher can't be fed by more than one file at a time.
+    fslib::CopyOptions fileOptions = options.fileOptions;
+    fileOptions.hasher = nullptr;
+
+    size_t bufferSize = fileOptions.bufferSize > 0 ? fileOptions.bufferSize : DEFAULT_BUFFER_SIZE;
+    CopyQueue queue;
+    std::vector<std::thread> workers;
+    for (size_t i = 0; i < workerCount; i++)
+    {
+        workers.emplace_back(copyWorkerFunction, std::ref(queue), std::cref(fileOptions), bufferSize);
+    }
+
+    // The tree is walked with a stack instead of recursion. Each directory is created before any of its files are queued.
+    int64_t directoryCount = 0;
+    bool scanFailed = false;
+    bool filesQueued = false;
+    std::chrono::steady_clock::time_point firstQueued = copyStart;
+    std::vector<std::pair<fslib::Path, fslib::Path>> directoryStack;
+    directoryStack.emplace_back(source, destination);
+    while (!directoryStack.empty() && !scanFailed)
+    {
+        std::pair<fslib::Path, fslib::Path> current = directoryStack.back();
+        directoryStack.pop_back();
+
+        // Sorting is useless here.
+        fslib::Directory directory(current.first, false);
+        if (!directory.isOpen())
+        {
+            scanFailed = true;
+            break;
+        }
+
+        for (int64_t i = 0; i < directory.getCount(); i++)
+        {
+            fslib::Path sourcePath = current.first / directory[i];
+            fslib::Path destinationPath = current.second / directory[i];
+            if (directory.isDirectory(i))
+            {
+                if (!fslib::directoryExists(destinationPath) && !fslib::createDirectory(destinationPath))
+                {
+                    scanFailed = true;
+                    break;
+                }
+                ++directoryCount;
+                directoryStack.emplace_back(sourcePath, destinationPath);
+            }
+            else
+            {
+                if (!filesQueued)
+                {
+                    filesQueued = true;
+                    firstQueued = std::chrono::steady_clock::now();
+                }
+
+                {
+                    std::lock_guard<std::mutex> queueLock(queue.queueLock);
+                    // No point in queueing or reading the rest of the tree if a worker already failed.
+                    scanFailed = queue.failed;
+                    if (!scanFailed)
+                    {
+                        queue.jobs.emplace_back(sourcePath, destinationPath);
+                    }
+                }
+
+                if (scanFailed)
+                {
+                    break;
+                }
+                queue.queueCondition.notify_one();
+            }
+        }
+    }
+    std::chrono::steady_clock::time_point scanEnd = std::chrono::steady_clock::now();
+
+    {
+        std::lock_guard<std::mutex> queueLock(queue.queueLock);
+        queue.scanFinished = true;
+        queue.failed = queue.failed || scanFailed;
+    }
+    queue.queueCondition.notify_all();
+
+    for (std::thread &worker : workers)
+    {
+        worker.join();
+    }
+    std::chrono::steady_clock::time_point copyEnd = std::chrono::steady_clock::now();
+
+    if (queue.workerFailed)
+    {
+        fslib::error::restore(queue.workerError);
+    }
+
+    if (statsOut)
+    {
+        statsOut->fileCount = queue.fileCount;
+        statsOut->directoryCount = directoryCount;
+        statsOut->bytesCopied = queue.bytesCopied;
+        statsOut->scanTime = std::chrono::duration_cast<std::chrono::nanoseconds>(scanEnd - copyStart).count();
+        statsOut->copyTime = filesQueued ? std::chrono::duration_cast<std::chrono::nanoseconds>(copyEnd - firstQueued).count() : 0;
+        statsOut->totalTime = std::chrono::duration_cast<std::chrono::nanoseconds>(copyEnd - copyStart).count();
+    }
+    return !queue.failed;
+}
+
+bool fslib::dumpStorage(fslib::Storage &storage,
+                        const fslib::Path &destination,
+                        const fslib::DumpOptions &options,
+                        fslib::DumpResult *resultOut)
+{
+    if (!storage.isOpen())
+    {
+        fslib::error::setReason(fslib::Operation::DumpStorage, "Storage isn't open.");
+        return false;
+    }
+
+    if (options.skipZeroBlocks && options.zeroBlockSize == 0)
+    {
+        fslib::error::setReason(fslib::Operation::DumpStorage, "Block size can't be 0.");
+        return false;
+    }
+
+    // Creating the destination at full size means skipped blocks never need to be written.
+    int64_t storageSize = storage.getSize();
+    fslib::File destinationFile(destination, FsOpenMode_Create | FsOpenMode_Write, storageSize);
+    if (!destinationFile.isOpen())
+    {
+        return false;
+    }
+
+    DumpRing ring;
+    ring.bufferSize = options.chunkSize > 0 ? options.chunkSize : DEFAULT_BUFFER_SIZE;
+    ring.usersPerChunk = options.computeSha256 ? 2 : 1;
+    size_t bufferCount = std::max(options.bufferCount, MINIMUM_BUFFER_COUNT);
+    ring.buffers.resize(bufferCount);
+    ring.bufferLengths.resize(bufferCount, 0);
+    ring.usersRemaining.resize(bufferCount, 0);
+    for (std::unique_ptr<unsigned char[]> &buffer : ring.buffers)
+    {
+        buffer.reset(new (std::nothrow) unsigned char[ring.bufferSize]);
+        if (!buffer)
+        {
+            fslib::error::setReason(fslib::Operation::DumpStorage, "Couldn't allocate dump buffers.");
+            return false;
+        }
+    }
+
+    fslib::Hasher hasher(fslib::Hasher::sha256);
+
+    int64_t chunkCount = (storageSize + ring.bufferSize - 1) / ring.bufferSize;
+    storage.seek(0, fslib::Storage::beginning);
+    std::thread readThread(dumpReadThreadFunction, std::ref(storage), std::ref(ring), chunkCount);
+    std::thread hashThread;
+    if (options.computeSha256)
+    {
+        hashThread = std::thread(dumpHashThreadFunction, std::ref(ring), chunkCount, std::ref(hasher));
+    }
+
+    fslib::DumpResult result;
+    int64_t chunkOffset = 0;
+    for (int64_t chunk = 0; chunk < chunkCount; chunk++)
+    {
+        if (!waitForChunk(ring, chunk))
+        {
+            break;
+        }
+
+        size_t index = chunk % bufferCount;
+        size_t chunkLength = ring.bufferLengths[index];
+        bool chunkWritten = writeChunk(destinationFile, ring.buffers[index].get(), chunkLength, chunkOffset, options, result);
+        releaseChunk(ring, index, chunkWritten);
+        if (!chunkWritten)
+        {
+            break;
+        }
+        chunkOffset += chunkLength;
+        result.bytesRead += chunkLength;
+
+        if (options.progress)
+        {
+            options.progress(chunkOffset, storageSize);
+        }
+    }
+
+    readThread.join();
+    if (hashThread.joinable())
+    {
+        hashThread.join();
+    }
+
+    // The reading thread's error is recorded on this thread so the caller can see it. A failed write already recorded its own.
+    if (ring.readFailed && !ring.failed)
+    {
+        fslib::error::restore(ring.readError);
+    }
+
+    bool dumpSucceeded = result.bytesRead == storageSize;
+    if (dumpSucceeded && options.computeSha256)
+    {
+        hasher.getSha256(result.sha256);
+    }
+
+    if (resultOut)
+    {
+        *resultOut = std::move(result);
+    }
+    return dumpSucceeded;
+}
@@ -1,35 +1,166 @@
 #include "directory.hpp"
+#include "error.hpp"
 #include "errorCommon.h"
 #include "fslib.hpp"
-#include "string.hpp"
 #include <algorithm>
+#include <cctype>
 #include <cstring>
+#include <memory>
 #include <string>
 
-// fslib global error string.
-extern std::string g_fslibErrorString;
+namespace
+{
+    // Number of entries read from the directory at once. FsDirectoryEntry is 0x310 bytes, so this is about 49KB.
+    constexpr int64_t READ_BATCH_SIZE = 64;
+    // Guess at the average name length used to reserve the name arena up front.
+    constexpr size_t AVERAGE_NAME_LENGTH = 32;
+    // Marks the start of a run of digits in a natural sort key. Using '0' means numbers still sort where digits normally would.
+    constexpr uint8_t DIGIT_RUN_MARKER = '0';
+
+    // One of these is built per entry when sorting. Most comparisons are settled by the prefix without touching the key arena.
+    struct SortRecord
+    {
+            uint64_t prefix;
+            uint32_t keyOffset;
+            uint32_t keyLength;
+            uint32_t index;
+    };
+} // namespace
+
+// Simple case folding for the scripts likely to show up in file names. Anything not covered is returned as is.
+static uint32_t foldCodepoint(uint32_t codepoint)
+{
+    if ((codepoint >= 'A' && codepoint <= 'Z') || (codepoint >= 0xC0 && codepoint <= 0xDE && codepoint != 0xD7) ||
+        (codepoint >= 0x391 && codepoint <= 0x3AB && codepoint != 0x3A2) || (codepoint >= 0x410 && codepoint <= 0x42F) ||
+        (codepoint >= 0xFF21 && codepoint <= 0xFF3A))
+    {
+        return codepoint + 0x20;
+    }
+
+    if (codepoint >= 0x400 && codepoint <= 0x40F)
+    {
+        return codepoint + 0x50;
+    }
+
+    // Latin Extended-A alternates upper and lower case, but the pairs shift by one in the middle and at the end.
+    if ((codepoint >= 0x100 && codepoint <= 0x137) || (codepoint >= 0x14A && codepoint <= 0x177))
+    {
+        return codepoint | 1;
+    }
+
+    if ((codepoint >= 0x139 && codepoint <= 0x148) || (codepoint >= 0x179 && codepoint <= 0x17E))
+    {
+        return codepoint + (codepoint & 1);
+    }
 
-// Sorts by entry type, then alphabetically.
-static bool compareEntries(const FsDirectoryEntry &entryA, const FsDirectoryEntry &entryB)
+    if (codepoint == 0x178)
+    {
+        return 0xFF;
+    }
+    return codepoint;
+}
+
+// Decodes one UTF-8 codepoint from string. Returns the number of bytes used or 0 if the sequence isn't valid.
+static size_t decodeUtf8(const char *string, size_t length, uint32_t &codepointOut)
 {
-    if (entryA.type != entryB.type)
+    const unsigned char *bytes = reinterpret_cast<const unsigned char *>(string);
+    size_t units = bytes[0] < 0x80 ? 1 : (bytes[0] & 0xE0) == 0xC0 ? 2 : (bytes[0] & 0xF0) == 0xE0 ? 3 : (bytes[0] & 0xF8) == 0xF0 ? 4 : 0;
+    if (units == 0 || units > length)
     {
-        return entryA.type == FsDirEntryType_Dir;
+        return 0;
     }
 
-    size_t entryALength = std::char_traits<char>::length(entryA.name);
-    size_t entryBLength = std::char_traits<char>::length(entryB.name);
-    size_t shortestEntry = entryALength < entryBLength ? entryALength : entryBLength;
-    for (size_t i = 0; i < shortestEntry;)
+    static constexpr unsigned char LEAD_MASKS[] = {0x00, 0x7F, 0x1F, 0x0F, 0x07};
+    codepointOut = bytes[0] & LEAD_MASKS[units];
+    for (size_t i = 1; i < units; i++)
     {
-        int charA = std::tolower(entryA.name[i]);
-        int charB = std::tolower(entryB.name[i]);
-        if (charA != charB)
+        if ((bytes[i] & 0xC0) != 0x80)
         {
-            return charA < charB;
+            return 0;
         }
+        codepointOut = (codepointOut << 6) | (bytes[i] & 0x3F);
     }
-    return false;
+    return units;
+}
+
+// Appends codepoint to keyOut as UTF-8.
+static void encodeUtf8(uint32_t codepoint, std::vector<uint8_t> &keyOut)
+{
+    if (codepoint < 0x80)
+    {
+        keyOut.push_back(codepoint);
+    }
+    else if (codepoint < 0x800)
+    {
+        keyOut.push_back(0xC0 | (codepoint >> 6));
+        keyOut.push_back(0x80 | (codepoint & 0x3F));
+    }
+    else if (codepoint < 0x10000)
+    {
+        keyOut.push_back(0xE0 | (codepoint >> 12));
+        keyOut.push_back(0x80 | ((codepoint >> 6) & 0x3F));
+        keyOut.push_back(0x80 | (codepoint & 0x3F));
+    }
+    else
+    {
+        keyOut.push_back(0xF0 | (codepoint >> 18));
+        keyOut.push_back(0x80 | ((codepoint >> 12) & 0x3F));
+        keyOut.push_back(0x80 | ((codepoint >> 6) & 0x3F));
+        keyOut.push_back(0x80 | (codepoint & 0x3F));
+    }
+}
+
+// Appends name's collation key to keyOut. Keys are case folded and compare correctly byte by byte. If natural is set, runs of digits
+// are written as a marker, the number of significant digits, and then the digits so 2 comes before 10.
+static void appendCollationKey(const char *name, size_t nameLength, bool natural, std::vector<uint8_t> &keyOut)
+{
+    size_t i = 0;
+    while (i < nameLength)
+    {
+        if (natural && std::isdigit(static_cast<unsigned char>(name[i])))
+        {
+            size_t runEnd = i;
+            while (runEnd < nameLength && std::isdigit(static_cast<unsigned char>(name[runEnd])))
+            {
+                ++runEnd;
+            }
+
+            size_t firstDigit = i;
+            while (firstDigit < runEnd && name[firstDigit] == '0')
+            {
+                ++firstDigit;
+            }
+
+            size_t digitCount = runEnd - firstDigit;
+            keyOut.push_back(DIGIT_RUN_MARKER);
+            keyOut.push_back(digitCount > 0xFF ? 0xFF : digitCount);
+            keyOut.insert(keyOut.end(), name + firstDigit, name + runEnd);
+            i = runEnd;
+            continue;
+        }
+
+        uint32_t codepoint = 0;
+        size_t units = decodeUtf8(&name[i], nameLength - i, codepoint);
+        if (units == 0)
+        {
+            // Invalid UTF-8 is kept as is.
+            keyOut.push_back(static_cast<uint8_t>(name[i++]));
+            continue;
+        }
+        encodeUtf8(foldCodepoint(codepoint), keyOut);
+        i += units;
+    }
+}
+
+// Returns the first eight bytes of key as a big endian integer, padded with zeros. Comparing these compares the start of the keys.
+static uint64_t getKeyPrefix(const uint8_t *key, size_t keyLength)
+{
+    uint64_t prefix = 0;
+    for (size_t i = 0; i < sizeof(uint64_t); i++)
+    {
+        prefix = (prefix << 8) | (i < keyLength ? key[i] : 0);
+    }
+    return prefix;
 }
 
 fslib::Directory::Directory(const fslib::Path &directoryPath, bool sortedListing)
@@ -41,17 +172,18 @@ void fslib::Directory::open(const fslib::Path &directoryPath, bool sortedListing
 {
     // This so directories can be reused.
     m_wasRead = false;
+    m_directoryPath = directoryPath;
 
     if (!directoryPath.isValid())
     {
-        g_fslibErrorString = ERROR_INVALID_PATH;
+        fslib::error::setReason(fslib::Operation::OpenDirectory, ERROR_INVALID_PATH, directoryPath);
         return;
     }
 
     FsFileSystem *fileSystem;
-    if (!fslib::getFileSystemByDeviceName(directoryPath.getDeviceName(), &fileSystem))
+    if (!fslib::getFileSystemByPath(directoryPath, &fileSystem))
     {
-        g_fslibErrorString = ERROR_DEVICE_NOT_FOUND;
+        fslib::error::setReason(fslib::Operation::OpenDirectory, ERROR_DEVICE_NOT_FOUND, directoryPath);
         return;
     }
 
@@ -59,37 +191,84 @@ void fslib::Directory::open(const fslib::Path &directoryPath, bool sortedListing
         fsFsOpenDirectory(fileSystem, directoryPath.getPath(), FsDirOpenMode_ReadDirs | FsDirOpenMode_ReadFiles, &m_directoryHandle);
     if (R_FAILED(fsError))
     {
-        g_fslibErrorString = string::getFormattedString("Error opening directory: 0x%X.", fsError);
+        fslib::error::setResult(fslib::Operation::OpenDirectory, fsError, directoryPath);
         return;
     }
 
     fsError = fsDirGetEntryCount(&m_directoryHandle, &m_entryCount);
     if (R_FAILED(fsError))
     {
-        g_fslibErrorString = string::getFormattedString("Error opening reading entry count: 0x%X.", fsError);
+        Directory::close();
+        fslib::error::setResult(fslib::Operation::ReadDirectory, fsError, directoryPath);
         return;
     }
 
-    // Allocate the array. Reallocating this should free a previous array if there is one.
-    m_directoryList = std::make_unique<FsDirectoryEntry[]>(m_entryCount);
+    // Entries are read a batch at a time and only the name, size, and type are kept. Reset everything from a previous listing.
+    m_nameArena.clear();
+    m_nameOffsets.clear();
+    m_nameLengths.clear();
+    m_entrySizes.clear();
+    m_entryIsDirectory.clear();
+    m_nameArena.reserve(m_entryCount * AVERAGE_NAME_LENGTH);
+    m_nameOffsets.reserve(m_entryCount);
+    m_nameLengths.reserve(m_entryCount);
+    m_entrySizes.reserve(m_entryCount);
+    m_entryIsDirectory.reserve(m_entryCount);
+
+    int64_t batchSize = m_entryCount < READ_BATCH_SIZE ? m_entryCount : READ_BATCH_SIZE;
+    std::unique_ptr<FsDirectoryEntry[]> batch(new (std::nothrow) FsDirectoryEntry[batchSize > 0 ? batchSize : 1]);
+    if (!batch)
+    {
+        Directory::close();
+        fslib::error::setReason(fslib::Operation::OpenDirectory, "Couldn't allocate read buffer.", directoryPath);
+        return;
+    }
 
-    // This is how many entries the function says are read.
     int64_t totalEntriesRead = 0;
-    fsError = fsDirRead(&m_directoryHandle, &totalEntriesRead, m_entryCount, m_directoryList.get());
+    while (totalEntriesRead < m_entryCount)
+    {
+        int64_t entriesRead = 0;
+        fsError = fsDirRead(&m_directoryHandle, &entriesRead, batchSize, batch.get());
+        if (R_FAILED(fsError) || entriesRead <= 0)
+        {
+            break;
+        }
+
+        for (int64_t i = 0; i < entriesRead; i++)
+        {
+            const FsDirectoryEntry &entry = batch[i];
+            size_t nameLength = strnlen(entry.name, sizeof(entry.name));
+
+            m_nameOffsets.push_back(static_cast<uint32_t>(m_nameArena.size()));
+            m_nameLengths.push_back(static_cast<uint16_t>(nameLength));
+            m_entrySizes.push_back(entry.file_size);
+            m_entryIsDirectory.push_back(entry.type == FsDirEntryType_Dir);
+            m_nameArena.insert(m_nameArena.end(), entry.name, entry.name + nameLength);
+            m_nameArena.push_back('\0');
+        }
+        totalEntriesRead += entriesRead;
+    }
+    Directory::close();
+
     if (R_FAILED(fsError) || totalEntriesRead != m_entryCount)
     {
-        Directory::close();
-        g_fslibErrorString = string::getFormattedString("Error reading entries: 0x%X. %02d/%02d entries were read.");
+        if (R_FAILED(fsError))
+        {
+            fslib::error::setResult(fslib::Operation::ReadDirectory, fsError, directoryPath);
+        }
+        else
+        {
+            fslib::error::setReason(fslib::Operation::ReadDirectory, "Not every entry could be read.", directoryPath);
+        }
+        m_entryCount = 0;
         return;
     }
 
     // Sort if requested.
     if (sortedListing)
     {
-        std::sort(m_directoryList.get(), m_directoryList.get() + m_entryCount, compareEntries);
+        Directory::sort(Directory::sortName);
     }
-    // Close and success?
-    Directory::close();
     m_wasRead = true;
 }
 
@@ -109,7 +288,7 @@ int64_t fslib::Directory::getEntrySize(int index) const
     {
         return 0;
     }
-    return m_directoryList[index].file_size;
+    return m_entrySizes[index];
 }
 
 const char *fslib::Directory::getEntry(int index) const
@@ -118,7 +297,7 @@ const char *fslib::Directory::getEntry(int index) const
     {
         return nullptr;
     }
-    return m_directoryList[index].name;
+    return &m_nameArena[m_nameOffsets[index]];
 }
 
 bool fslib::Directory::isDirectory(int index) const
@@ -127,7 +306,7 @@ bool fslib::Directory::isDirectory(int index) const
     {
         return false;
     }
-    return m_directoryList[index].type == FsDirEntryType_Dir;
+    return m_entryIsDirectory[index];
 }
 
 const char *fslib::Directory::operator[](int index) const
@@ -136,7 +315,114 @@ const char *fslib::Directory::operator[](int index) const
     {
         return nullptr;
     }
-    return m_directoryList[index].name;
+    return &m_nameArena[m_nameOffsets[index]];
+}
+
+bool fslib::Directory::sort(uint8_t sortOrder, bool directoriesFirst, bool descending)
+{
+    if (m_entryCount == 0)
+    {
+        return true;
+    }
+
+    // Every order gets the folded name key so ties can fall back to it. Name orders use the start of the key as the prefix, the others
+    // use the value being sorted by.
+    bool natural = sortOrder == Directory::sortNatural;
+    bool prefixFromKey = sortOrder != Directory::sortSize && sortOrder != Directory::sortTimestamp;
+    std::vector<uint8_t> keyArena;
+    keyArena.reserve(m_nameArena.size() + (natural ? m_entryCount * 2 : 0));
+    std::vector<SortRecord> records(m_entryCount);
+    for (int64_t i = 0; i < m_entryCount; i++)
+    {
+        SortRecord &record = records[i];
+        record.keyOffset = keyArena.size();
+        appendCollationKey(&m_nameArena[m_nameOffsets[i]], m_nameLengths[i], natural, keyArena);
+        record.keyLength = keyArena.size() - record.keyOffset;
+        record.index = i;
+    }
+
+    if (sortOrder == Directory::sortTimestamp)
+    {
+        FsFileSystem *fileSystem;
+        if (!fslib::getFileSystemByPath(m_directoryPath, &fileSystem))
+        {
+            fslib::error::setReason(fslib::Operation::ReadDirectory, ERROR_DEVICE_NOT_FOUND, m_directoryPath);
+            return false;
+        }
+
+        // Entries whose timestamp can't be read sort as if it were 0.
+        fslib::PathBuilder entryPath(m_directoryPath);
+        for (int64_t i = 0; i < m_entryCount; i++)
+        {
+            FsTimeStampRaw timeStamp = {0};
+            Result fsError = -1;
+            if (entryPath.push(&m_nameArena[m_nameOffsets[i]]))
+            {
+                fsError = fsFsGetFileTimeStampRaw(fileSystem, entryPath.getPath().getPath(), &timeStamp);
+                entryPath.pop();
+            }
+            records[i].prefix = R_SUCCEEDED(fsError) && timeStamp.is_valid ? timeStamp.modified : 0;
+        }
+    }
+    else
+    {
+        for (SortRecord &record : records)
+        {
+            record.prefix = prefixFromKey ? getKeyPrefix(&keyArena[record.keyOffset], record.keyLength) : m_entrySizes[record.index];
+        }
+    }
+
+    size_t keyStart = prefixFromKey ? sizeof(uint64_t) : 0;
+    std::sort(records.begin(), records.end(), [&](const SortRecord &recordA, const SortRecord &recordB) {
+        bool directoryA = m_entryIsDirectory[recordA.index];
+        bool directoryB = m_entryIsDirectory[recordB.index];
+        if (directoriesFirst && directoryA != directoryB)
+        {
+            return directoryA;
+        }
+
+        if (recordA.prefix != recordB.prefix)
+        {
+            return descending ? recordA.prefix > recordB.prefix : recordA.prefix < recordB.prefix;
+        }
+
+        // Compare whatever the prefix didn't cover, then the raw names so entries differing only by case still have a set order.
+        int result = 0;
+        size_t shortestKey = std::min(recordA.keyLength, recordB.keyLength);
+        if (shortestKey > keyStart)
+        {
+            result = std::memcmp(&keyArena[recordA.keyOffset + keyStart], &keyArena[recordB.keyOffset + keyStart], shortestKey - keyStart);
+        }
+
+        if (result == 0 && recordA.keyLength != recordB.keyLength)
+        {
+            result = recordA.keyLength < recordB.keyLength ? -1 : 1;
+        }
+
+        if (result == 0)
+        {
+            result = std::strcmp(&m_nameArena[m_nameOffsets[recordA.index]], &m_nameArena[m_nameOffsets[recordB.index]]);
+        }
+        return descending ? result > 0 : result < 0;
+    });
+
+    std::vector<uint32_t> nameOffsets(m_entryCount);
+    std::vector<uint16_t> nameLengths(m_entryCount);
+    std::vector<int64_t> entrySizes(m_entryCount);
+    std::vector<uint8_t> entryIsDirectory(m_entryCount);
+    for (int64_t i = 0; i < m_entryCount; i++)
+    {
+        uint32_t index = records[i].index;
+        nameOffsets[i] = m_nameOffsets[index];
+        nameLengths[i] = m_nameLengths[index];
+        entrySizes[i] = m_entrySizes[index];
+        entryIsDirectory[i] = m_entryIsDirectory[index];
+    }
+    m_nameOffsets = std::move(nameOffsets);
+    m_nameLengths = std::move(nameLengths);
+    m_entrySizes = std::move(entrySizes);
+    m_entryIsDirectory = std::move(entryIsDirectory);
+    return true;
 }
 
 void fslib::Directory::close(void)
@@ -1,30 +1,84 @@
 #include "directoryFunctions.hpp"
+#include "error.hpp"
 #include "errorCommon.h"
 #include "fslib.hpp"
-#include "string.hpp"
+#include <algorithm>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <unordered_map>
 #include <switch.h>
 
-extern std::string g_fslibErrorString;
+namespace
+{
+    // Most directories createDirectoriesRecursively remembers as existing per device.
+    constexpr size_t KNOWN_DIRECTORY_LIMIT = 32;
+
+    // Directories known to exist paired with their device. The most recently used are at the back.
+    std::mutex s_knownDirectoryLock;
+    std::unordered_map<std::string, std::deque<std::string>> s_knownDirectories;
+} // namespace
+
+// Returns whether or not path is known to exist on deviceName. Hits are moved to the back so they're kept longer.
+static bool isKnownDirectory(std::string_view deviceName, std::string_view path)
+{
+    std::lock_guard<std::mutex> knownDirectoryLock(s_knownDirectoryLock);
+    auto findDevice = s_knownDirectories.find(std::string(deviceName));
+    if (findDevice == s_knownDirectories.end())
+    {
+        return false;
+    }
+
+    std::deque<std::string> &knownDirectories = findDevice->second;
+    auto findPath = std::find(knownDirectories.begin(), knownDirectories.end(), path);
+    if (findPath == knownDirectories.end())
+    {
+        return false;
+    }
+
+    std::string knownPath = std::move(*findPath);
+    knownDirectories.erase(findPath);
+    knownDirectories.push_back(std::move(knownPath));
+    return true;
+}
+
+// Remembers path exists on deviceName, forgetting the least recently used if there are too many.
+static void rememberDirectory(std::string_view deviceName, std::string_view path)
+{
+    std::lock_guard<std::mutex> knownDirectoryLock(s_knownDirectoryLock);
+    std::deque<std::string> &knownDirectories = s_knownDirectories[std::string(deviceName)];
+    knownDirectories.emplace_back(path);
+    if (knownDirectories.size() > KNOWN_DIRECTORY_LIMIT)
+    {
+        knownDirectories.pop_front();
+    }
+}
+
+void fslib::forgetKnownDirectories(std::string_view deviceName)
+{
+    std::lock_guard<std::mutex> knownDirectoryLock(s_knownDirectoryLock);
+    s_knownDirectories.erase(std::string(deviceName));
+}
 
 bool fslib::createDirectory(const fslib::Path &directoryPath)
 {
     if (!directoryPath.isValid())
     {
-        g_fslibErrorString = ERROR_INVALID_PATH;
+        fslib::error::setReason(fslib::Operation::CreateDirectory, ERROR_INVALID_PATH, directoryPath);
         return false;
     }
 
     FsFileSystem *fileSystem;
-    if (!fslib::getFileSystemByDeviceName(directoryPath.getDeviceName(), &fileSystem))
+    if (!fslib::getFileSystemByPath(directoryPath, &fileSystem))
     {
-        g_fslibErrorString = ERROR_DEVICE_NOT_FOUND;
+        fslib::error::setReason(fslib::Operation::CreateDirectory, ERROR_DEVICE_NOT_FOUND, directoryPath);
         return false;
     }
 
     Result fsError = fsFsCreateDirectory(fileSystem, directoryPath.getPath());
     if (R_FAILED(fsError))
     {
-        g_fslibErrorString = string::getFormattedString("Error creating directory: 0x%X.", fsError);
+        fslib::error::setResult(fslib::Operation::CreateDirectory, fsError, directoryPath);
         return false;
     }
 
@@ -33,20 +87,74 @@ bool fslib::createDirectory(const fslib::Path &directoryPath)
 
 bool fslib::createDirectoriesRecursively(const fslib::Path &directoryPath)
 {
-    size_t slashPosition = directoryPath.findFirstOf('/') + 1;
-    do
-    {
-        // Get next slash position.
-        slashPosition = directoryPath.findFirstOf('/', slashPosition);
-        // Get subpath up to that slash.
-        fslib::Path currentDirectory = directoryPath.subPath(slashPosition);
-        // Try to create it, but check to see if it exists first to prevent false failures.
-        if (!fslib::directoryExists(currentDirectory) && !fslib::createDirectory(currentDirectory))
+    if (!directoryPath.isValid())
+    {
+        fslib::error::setReason(fslib::Operation::CreateDirectory, ERROR_INVALID_PATH, directoryPath);
+        return false;
+    }
+
+    FsFileSystem *fileSystem;
+    if (!fslib::getFileSystemByPath(directoryPath, &fileSystem))
+    {
+        fslib::error::setReason(fslib::Operation::CreateDirectory, ERROR_DEVICE_NOT_FOUND, directoryPath);
+        return false;
+    }
+
+    // Work on a copy of the path without the device or trailing slashes. Cutting it at a slash gives each parent directory.
+    std::string_view deviceName = directoryPath.getDeviceName();
+    std::string pathBuffer = directoryPath.getPath();
+    while (pathBuffer.length() > 1 && pathBuffer.back() == '/')
+    {
+        pathBuffer.pop_back();
+    }
+
+    // Walk backwards until a directory that's known to exist or actually exists is found. The root always exists.
+    size_t existingEnd = pathBuffer.length();
+    while (existingEnd > 1)
+    {
+        std::string_view currentPath(pathBuffer.c_str(), existingEnd);
+        if (isKnownDirectory(deviceName, currentPath))
+        {
+            break;
+        }
+
+        pathBuffer[existingEnd] = '\0';
+        FsDirEntryType entryType;
+        Result fsError = fsFsGetEntryType(fileSystem, pathBuffer.c_str(), &entryType);
+        pathBuffer[existingEnd] = existingEnd < pathBuffer.length() ? '/' : '\0';
+        if (R_SUCCEEDED(fsError) && entryType != FsDirEntryType_Dir)
+        {
+            // A file with the directory's name is in the way. Nothing can be created under it.
+            fslib::error::setReason(fslib::Operation::CreateDirectory, "A file exists where a directory is needed.", directoryPath);
+            return false;
+        }
+        else if (R_SUCCEEDED(fsError))
+        {
+            rememberDirectory(deviceName, currentPath);
+            break;
+        }
+
+        size_t slashPosition = currentPath.find_last_of('/');
+        existingEnd = slashPosition == std::string_view::npos ? 0 : slashPosition;
+    }
+
+    // Create only what's missing after that.
+    while (existingEnd < pathBuffer.length())
+    {
+        size_t nextSlash = pathBuffer.find('/', existingEnd + 1);
+        size_t currentEnd = nextSlash == std::string::npos ? pathBuffer.length() : nextSlash;
+
+        pathBuffer[currentEnd] = '\0';
+        Result fsError = fsFsCreateDirectory(fileSystem, pathBuffer.c_str());
+        pathBuffer[currentEnd] = currentEnd < pathBuffer.length() ? '/' : '\0';
+        if (R_FAILED(fsError))
         {
+            fslib::error::setResult(fslib::Operation::CreateDirectory, fsError, directoryPath);
             return false;
         }
-        ++slashPosition;
-    } while (slashPosition < directoryPath.getLength());
+        rememberDirectory(deviceName, std::string_view(pathBuffer.c_str(), currentEnd));
+        existingEnd = currentEnd;
+    }
     return true;
 }
 
@@ -54,99 +162,145 @@ bool fslib::deleteDirectory(const fslib::Path &directoryPath)
 {
     if (!directoryPath.isValid())
     {
-        g_fslibErrorString = ERROR_INVALID_PATH;
+        fslib::error::setReason(fslib::Operation::DeleteDirectory, ERROR_INVALID_PATH, directoryPath);
         return false;
     }
 
     FsFileSystem *fileSystem;
-    if (!fslib::getFileSystemByDeviceName(directoryPath.getDeviceName(), &fileSystem))
+    if (!fslib::getFileSystemByPath(directoryPath, &fileSystem))
     {
-        g_fslibErrorString = ERROR_DEVICE_NOT_FOUND;
+        fslib::error::setReason(fslib::Operation::DeleteDirectory, ERROR_DEVICE_NOT_FOUND, directoryPath);
         return false;
     }
 
+    // Anything under this directory might be remembered as existing.
+    fslib::forgetKnownDirectories(directoryPath.getDeviceName());
+
     Result fsError = fsFsDeleteDirectory(fileSystem, directoryPath.getPath());
     if (R_FAILED(fsError))
     {
-        g_fslibErrorString = string::getFormattedString("Error deleting directory: 0x%X.", fsError);
+        fslib::error::setResult(fslib::Operation::DeleteDirectory, fsError, directoryPath);
         return false;
     }
     return true;
 }
 
-bool fslib::deleteDirectoryRecursively(const fslib::Path &directoryPath)
+bool fslib::deleteDirectoryRecursively(const fslib::Path &directoryPath, const fslib::DeleteProgressFunction &progress)
 {
-    fslib::Directory targetDirectory(directoryPath);
-    if (!targetDirectory.isOpen())
+    if (!directoryPath.isValid())
     {
-        g_fslibErrorString = string::getFormattedString("Error deleting directory recursively: %s", g_fslibErrorString.c_str());
+        fslib::error::setReason(fslib::Operation::DeleteDirectory, ERROR_INVALID_PATH, directoryPath);
         return false;
     }
 
-    for (int64_t i = 0; i < targetDirectory.getCount(); i++)
+    FsFileSystem *fileSystem;
+    if (!fslib::getFileSystemByPath(directoryPath, &fileSystem))
     {
-        fslib::Path targetPath = directoryPath / targetDirectory[i];
-        if (targetDirectory.isDirectory(i) && !fslib::deleteDirectoryRecursively(targetPath))
+        fslib::error::setReason(fslib::Operation::DeleteDirectory, ERROR_DEVICE_NOT_FOUND, directoryPath);
+        return false;
+    }
+
+    fslib::forgetKnownDirectories(directoryPath.getDeviceName());
+
+    // FS can delete the whole tree itself in one request. The root (device:/) can't be deleted, but it can be cleaned out instead.
+    bool isRoot = std::char_traits<char>::length(directoryPath.getPath()) <= 1;
+    Result fsError = isRoot ? fsFsCleanDirectoryRecursively(fileSystem, directoryPath.getPath())
+                            : fsFsDeleteDirectoryRecursively(fileSystem, directoryPath.getPath());
+    if (R_SUCCEEDED(fsError))
+    {
+        return true;
+    }
+
+    // Some file systems reject that, so fall back to walking the tree and deleting everything one at a time. The walk's path buffer
+    // is passed straight to FS after skipping the device so there's no Path built per entry.
+    size_t deviceLength = directoryPath.getPath() - directoryPath.cString();
+    int64_t entriesDeleted = 0;
+    bool deleteFailed = false;
+
+    fslib::WalkOptions walkOptions;
+    walkOptions.preVisit = [&](const fslib::WalkEntry &entry) {
+        if (entry.isDirectory)
         {
-            return false;
+            return fslib::WALK_CONTINUE;
         }
-        else if (!targetDirectory.isDirectory(i) && !fslib::deleteFile(targetPath))
+
+        Result deleteError = fsFsDeleteFile(fileSystem, entry.path + deviceLength);
+        if (R_FAILED(deleteError))
         {
-            return false;
+            fslib::error::setResult(fslib::Operation::DeleteFile, deleteError, std::string_view(entry.path));
+            deleteFailed = true;
+            return fslib::WALK_STOP;
         }
-    }
 
-    // This will prevent this function from trying to delete the root (device:/) and reporting failure. Nintendo's doesn't.
-    const char *pathBegin = std::char_traits<char>::find(directoryPath.cString(), directoryPath.getLength(), '/');
-    if (std::char_traits<char>::length(pathBegin) > 1 && !fslib::deleteDirectory(directoryPath))
-    {
-        return false;
-    }
-    return true;
-}
+        if (progress)
+        {
+            progress(++entriesDeleted);
+        }
+        return fslib::WALK_CONTINUE;
+    };
+    // Directories are empty by the time they're visited again.
+    walkOptions.postVisit = [&](const fslib::WalkEntry &entry) {
+        Result deleteError = fsFsDeleteDirectory(fileSystem, entry.path + deviceLength);
+        if (R_FAILED(deleteError))
+        {
+            fslib::error::setResult(fslib::Operation::DeleteDirectory, deleteError, std::string_view(entry.path));
+            deleteFailed = true;
+            return fslib::WALK_STOP;
+        }
 
-bool fslib::directoryExists(const fslib::Path &directoryPath)
-{
-    if (!directoryPath.isValid())
+        if (progress)
+        {
+            progress(++entriesDeleted);
+        }
+        return fslib::WALK_CONTINUE;
+    };
+
+    // The error for whatever entry failed is already recorded.
+    if (!fslib::walk(directoryPath, walkOptions) || deleteFailed)
     {
         return false;
     }
 
-    FsFileSystem *fileSystem;
-    if (!fslib::getFileSystemByDeviceName(directoryPath.getDeviceName(), &fileSystem))
+    // This will prevent this function from trying to delete the root (device:/) and reporting failure. Nintendo's doesn't.
+    if (!isRoot && !fslib::deleteDirectory(directoryPath))
     {
         return false;
     }
 
-    FsDir directoryHandle;
-    Result fsError = fsFsOpenDirectory(fileSystem, directoryPath.getPath(), FsDirOpenMode_ReadDirs | FsDirOpenMode_ReadFiles, &directoryHandle);
-    if (R_FAILED(fsError))
+    if (progress)
     {
-        return false;
+        progress(++entriesDeleted);
     }
-    fsDirClose(&directoryHandle);
     return true;
 }
 
+bool fslib::directoryExists(const fslib::Path &directoryPath)
+{
+    fslib::EntryInfo entryInfo;
+    return fslib::getEntryInfo(directoryPath, entryInfo, 0) && entryInfo.isDirectory;
+}
+
 bool fslib::renameDirectory(const fslib::Path &oldPath, const fslib::Path &newPath)
 {
     if (!oldPath.isValid() || !newPath.isValid() || oldPath.getDeviceName() != newPath.getDeviceName())
     {
-        g_fslibErrorString = ERROR_INVALID_PATH;
+        fslib::error::setReason(fslib::Operation::RenameDirectory, ERROR_INVALID_PATH, oldPath);
         return false;
     }
 
     FsFileSystem *fileSystem;
-    if (!fslib::getFileSystemByDeviceName(oldPath.getDeviceName(), &fileSystem))
+    if (!fslib::getFileSystemByPath(oldPath, &fileSystem))
     {
-        g_fslibErrorString = ERROR_DEVICE_NOT_FOUND;
+        fslib::error::setReason(fslib::Operation::RenameDirectory, ERROR_DEVICE_NOT_FOUND, oldPath);
         return false;
     }
 
+    fslib::forgetKnownDirectories(oldPath.getDeviceName());
+
     Result fsError = fsFsRenameDirectory(fileSystem, oldPath.getPath(), newPath.getPath());
     if (R_FAILED(fsError))
     {
-        g_fslibErrorString = string::getFormattedString("Error renaming directory: 0x%X.", fsError);
+        fslib::error::setResult(fslib::Operation::RenameDirectory, fsError, oldPath);
         return false;
     }
     return true;
@@ -0,0 +1,162 @@
+#include "directoryIterator.hpp"
+#include "error.hpp"
+#include "errorCommon.h"
+#include "fslib.hpp"
+#include <string>
+
+fslib::DirectoryIterator::DirectoryIterator(const fslib::Path &directoryPath, int64_t batchSize)
+{
+    DirectoryIterator::open(directoryPath, batchSize);
+}
+
+fslib::DirectoryIterator::~DirectoryIterator()
+{
+    DirectoryIterator::close();
+}
+
+void fslib::DirectoryIterator::open(const fslib::Path &directoryPath, int64_t batchSize)
+{
+    // So iterators can be reused.
+    DirectoryIterator::close();
+    m_batchCount = 0;
+    m_batchIndex = -1;
+    // This is cleared once the directory is actually open.
+    m_failed = true;
+
+    if (!directoryPath.isValid())
+    {
+        fslib::error::setReason(fslib::Operation::OpenDirectory, ERROR_INVALID_PATH, directoryPath);
+        return;
+    }
+
+    FsFileSystem *fileSystem;
+    if (!fslib::getFileSystemByPath(directoryPath, &fileSystem))
+    {
+        fslib::error::setReason(fslib::Operation::OpenDirectory, ERROR_DEVICE_NOT_FOUND, directoryPath);
+        return;
+    }
+
+    if (batchSize <= 0)
+    {
+        batchSize = DirectoryIterator::defaultBatchSize;
+    }
+
+    // Only reallocate the batch buffer if the size actually changed.
+    if (!m_batch || m_batchSize != batchSize)
+    {
+        m_batch.reset(new (std::nothrow) FsDirectoryEntry[batchSize]);
+        if (!m_batch)
+        {
+            m_batchSize = 0;
+            fslib::error::setReason(fslib::Operation::OpenDirectory, "Couldn't allocate batch buffer.", directoryPath);
+            return;
+        }
+        m_batchSize = batchSize;
+    }
+
+    Result fsError =
+        fsFsOpenDirectory(fileSystem, directoryPath.getPath(), FsDirOpenMode_ReadDirs | FsDirOpenMode_ReadFiles, &m_directoryHandle);
+    if (R_FAILED(fsError))
+    {
+        fslib::error::setResult(fslib::Operation::OpenDirectory, fsError, directoryPath);
+        return;
+    }
+    m_isOpen = true;
+    m_failed = false;
+}
+
+void fslib::DirectoryIterator::close(void)
+{
+    if (!m_isOpen)
+    {
+        return;
+    }
+    fsDirClose(&m_directoryHandle);
+    m_isOpen = false;
+}
+
+bool fslib::DirectoryIterator::isOpen(void) const
+{
+    return m_isOpen;
+}
+
+bool fslib::DirectoryIterator::failed(void) const
+{
+    return m_failed;
+}
+
+bool fslib::DirectoryIterator::next(void)
+{
+    if (m_batchIndex + 1 < m_batchCount)
+    {
+        ++m_batchIndex;
+        return true;
+    }
+
+    if (!DirectoryIterator::readBatch())
+    {
+        // Nothing left. There's no reason to keep the handle around.
+        DirectoryIterator::close();
+        m_batchCount = 0;
+        m_batchIndex = -1;
+        return false;
+    }
+    m_batchIndex = 0;
+    return true;
+}
+
+const FsDirectoryEntry *fslib::DirectoryIterator::getEntry(void) const
+{
+    if (m_batchIndex < 0 || m_batchIndex >= m_batchCount)
+    {
+        return nullptr;
+    }
+    return &m_batch[m_batchIndex];
+}
+
+const char *fslib::DirectoryIterator::getName(void) const
+{
+    const FsDirectoryEntry *entry = DirectoryIterator::getEntry();
+    return entry ? entry->name : nullptr;
+}
+
+int64_t fslib::DirectoryIterator::getSize(void) const
+{
+    const FsDirectoryEntry *entry = DirectoryIterator::getEntry();
+    return entry ? entry->file_size : 0;
+}
+
+bool fslib::DirectoryIterator::isDirectory(void) const
+{
+    const FsDirectoryEntry *entry = DirectoryIterator::getEntry();
+    return entry && entry->type == FsDirEntryType_Dir;
+}
+
+fslib::DirectoryIterator::Iterator fslib::DirectoryIterator::begin(void)
+{
+    return Iterator(DirectoryIterator::next() ? this : nullptr);
+}
+
+fslib::DirectoryIterator::Iterator fslib::DirectoryIterator::end(void)
+{
+    return Iterator(nullptr);
+}
+
+bool fslib::DirectoryIterator::readBatch(void)
+{
+    if (!m_isOpen)
+    {
+        return false;
+    }
+
+    int64_t entriesRead = 0;
+    Result fsError = fsDirRead(&m_directoryHandle, &entriesRead, m_batchSize, m_batch.get());
+    if (R_FAILED(fsError))
+    {
+        fslib::error::setResult(fslib::Operation::ReadDirectory, fsError);
+        m_failed = true;
+        return false;
+    }
+    m_batchCount = entriesRead;
+    return entriesRead > 0;
+}
@@ -0,0 +1,151 @@
+#include "error.hpp"
+#include "fslib.hpp"
+#include "string.hpp"
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <string>
+
+namespace
+{
+    // Longest path kept with an error. Anything longer is cut off.
+    constexpr size_t ERROR_PATH_LENGTH = FS_MAX_PATH;
+
+    // Everything needed to build the error string later. Recording an error only copies into this.
+    struct ErrorRecord
+    {
+            Result result = 0;
+            fslib::Operation operation = fslib::Operation::None;
+            // Either a string literal or nullptr if result is what failed.
+            const char *reason = nullptr;
+            char path[ERROR_PATH_LENGTH];
+            size_t pathLength = 0;
+            // Built by getErrorString the first time it's called after an error is recorded.
+            std::string errorString = "No errors encountered.";
+            bool isFormatted = true;
+    };
+
+    thread_local ErrorRecord t_lastError;
+
+    // What is printed after "Error" for each operation. Indexed by fslib::Operation.
+    constexpr const char *OPERATION_STRINGS[] = {"in FsLib",
+                                                 "mapping device",
+                                                 "committing data to device",
+                                                 "getting device space",
+                                                 "opening file system",
+                                                 "opening file",
+                                                 "reading from file",
+                                                 "writing to file",
+                                                 "flushing file",
+                                                 "resizing file",
+                                                 "getting file size",
+                                                 "setting buffer size",
+                                                 "creating file",
+                                                 "deleting file",
+                                                 "renaming file",
+                                                 "getting entry info",
+                                                 "opening directory",
+                                                 "reading directory",
+                                                 "creating directory",
+                                                 "deleting directory",
+                                                 "renaming directory",
+                                                 "opening storage",
+                                                 "reading from storage",
+                                                 "dumping storage",
+                                                 "copying",
+                                                 "walking directory"};
+    static_assert(std::size(OPERATION_STRINGS) == static_cast<size_t>(fslib::Operation::Walk) + 1);
+} // namespace
+
+// Copies the fields shared by both kinds of errors to the calling thread's record.
+static void recordError(fslib::Operation operation, Result result, const char *reason, std::string_view path)
+{
+    t_lastError.result = result;
+    t_lastError.operation = operation;
+    t_lastError.reason = reason;
+    t_lastError.pathLength = std::min(path.length(), ERROR_PATH_LENGTH);
+    std::memcpy(t_lastError.path, path.data(), t_lastError.pathLength);
+    t_lastError.isFormatted = false;
+}
+
+void fslib::error::setResult(fslib::Operation operation, Result result, std::string_view path)
+{
+    recordError(operation, result, nullptr, path);
+}
+
+void fslib::error::setResult(fslib::Operation operation, Result result, const fslib::Path &path)
+{
+    recordError(operation, result, nullptr, std::string_view(path.cString(), path.getLength()));
+}
+
+void fslib::error::setReason(fslib::Operation operation, const char *reason, std::string_view path)
+{
+    recordError(operation, 0, reason, path);
+}
+
+void fslib::error::setReason(fslib::Operation operation, const char *reason, const fslib::Path &path)
+{
+    recordError(operation, 0, reason, std::string_view(path.cString(), path.getLength()));
+}
+
+void fslib::error::clear(void)
+{
+    t_lastError.result = 0;
+    t_lastError.operation = fslib::Operation::None;
+    t_lastError.reason = nullptr;
+    t_lastError.pathLength = 0;
+    t_lastError.errorString = "No errors encountered.";
+    t_lastError.isFormatted = true;
+}
+
+fslib::error::Record fslib::error::capture(void)
+{
+    return {t_lastError.result, t_lastError.operation, t_lastError.reason, std::string(t_lastError.path, t_lastError.pathLength)};
+}
+
+void fslib::error::restore(const fslib::error::Record &record)
+{
+    recordError(record.operation, record.result, record.reason, record.path);
+}
+
+const char *fslib::getErrorString(void)
+{
+    if (t_lastError.isFormatted)
+    {
+        return t_lastError.errorString.c_str();
+    }
+
+    const char *operationString = OPERATION_STRINGS[static_cast<size_t>(t_lastError.operation)];
+    const char *pathSeparator = t_lastError.pathLength > 0 ? " " : "";
+    int pathLength = static_cast<int>(t_lastError.pathLength);
+    if (t_lastError.reason)
+    {
+        t_lastError.errorString = string::getFormattedString("Error %s%s%.*s: %s",
+                                                             operationString,
+                                                             pathSeparator,
+                                                             pathLength,
+                                                             t_lastError.path,
+                                                             t_lastError.reason);
+    }
+    else
+    {
+        t_lastError.errorString = string::getFormattedString("Error %s%s%.*s: 0x%X.",
+                                                             operationString,
+                                                             pathSeparator,
+                                                             pathLength,
+                                                             t_lastError.path,
+                                                             t_lastError.result);
+    }
+    t_lastError.isFormatted = true;
+    return t_lastError.errorString.c_str();
+}
+
+Result fslib::getLastResult(void)
+{
+    return t_lastError.result;
+}
+
+fslib::Operation fslib::getLastOperation(void)
+{
+    return t_lastError.operation;
+}
@@ -1,9 +1,12 @@
 #include "file.hpp"
+#include "error.hpp"
 #include "errorCommon.h"
 #include "fileFunctions.hpp"
 #include "fslib.hpp"
-#include "string.hpp"
+#include <algorithm>
+#include <atomic>
 #include <cstdarg>
+#include <cstring>
 #include <string>
 
 namespace
@@ -11,11 +14,19 @@ namespace
     // Buffer size for writef.
     constexpr size_t VA_BUFFER_SIZE = 0x1000;
     // These two strings are use multiple times in the reading and writing functions for errors.
-    const char *ERROR_NOT_OPEN_FOR_READING = "Error: File not open for reading.";
-    const char *ERROR_NOT_OPEN_FOR_WRITING = "Error: File not open for writing.";
+    const char *ERROR_NOT_OPEN_FOR_READING = "File not open for reading.";
+    const char *ERROR_NOT_OPEN_FOR_WRITING = "File not open for writing.";
 } // namespace
 
-extern std::string g_fslibErrorString;
+// Returns a pointer to the first '\n' or '\r' in buffer. memchr is used since it's much faster than checking byte by byte.
+static const char *findLineBreak(const char *buffer, size_t bufferSize)
+{
+    const char *newLine = static_cast<const char *>(std::memchr(buffer, '\n', bufferSize));
+    // There's no point in searching past the new line for a carriage return.
+    size_t searchLength = newLine ? newLine - buffer : bufferSize;
+    const char *carriageReturn = static_cast<const char *>(std::memchr(buffer, '\r', searchLength));
+    return carriageReturn ? carriageReturn : newLine;
+}
 
 fslib::File::File(const fslib::Path &filePath, uint32_t openFlags, int64_t fileSize)
 {
@@ -31,10 +42,12 @@ void fslib::File::open(const fslib::Path &filePath, uint32_t openFlags, int64_t
 {
     // So this class can be reused.
     File::close();
+    // Anything left in the read buffer belongs to the last file.
+    m_readBufferLength = 0;
 
     if (!filePath.isValid())
     {
-        g_fslibErrorString = ERROR_INVALID_PATH;
+        fslib::error::setReason(fslib::Operation::OpenFile, ERROR_INVALID_PATH, filePath);
         return;
     }
 
@@ -45,9 +58,9 @@ void fslib::File::open(const fslib::Path &filePath, uint32_t openFlags, int64_t
     }
 
     FsFileSystem *fileSystem;
-    if (!fslib::getFileSystemByDeviceName(filePath.getDeviceName(), &fileSystem))
+    if (!fslib::getFileSystemByPath(filePath, &fileSystem))
     {
-        g_fslibErrorString = ERROR_DEVICE_NOT_FOUND;
+        fslib::error::setReason(fslib::Operation::OpenFile, ERROR_DEVICE_NOT_FOUND, filePath);
         return;
     }
 
@@ -71,19 +84,20 @@ void fslib::File::open(const fslib::Path &filePath, uint32_t openFlags, int64_t
     Result fsError = fsFsOpenFile(fileSystem, filePath.getPath(), openFlags, &m_fileHandle);
     if (R_FAILED(fsError))
     {
-        g_fslibErrorString = string::getFormattedString("Error opening file: 0x%X.", fsError);
+        fslib::error::setResult(fslib::Operation::OpenFile, fsError, filePath);
         return;
     }
 
     fsError = fsFileGetSize(&m_fileHandle, &m_streamSize);
     if (R_FAILED(fsError))
     {
-        g_fslibErrorString = string::getFormattedString("Error getting file's size: 0x%X.", fsError);
+        fslib::error::setResult(fslib::Operation::GetFileSize, fsError, filePath);
         return;
     }
     // Save flags and set offset.
     m_openFlags = openFlags;
     m_offset = (m_openFlags & FsOpenMode_Append) ? m_streamSize : 0;
+    m_allocatedSize = m_streamSize;
     // We're good?
     m_isOpen = true;
 }
@@ -92,6 +106,9 @@ void fslib::File::close(void)
 {
     if (m_isOpen)
     {
+        // Anything still buffered needs to make it to the file and any extra space allocated needs to go before the handle is gone.
+        File::flushWriteBuffer();
+        File::trimToSize();
         fsFileClose(&m_fileHandle);
         m_isOpen = false;
     }
@@ -102,22 +119,58 @@ bool fslib::File::isOpen(void) const
     return m_isOpen;
 }
 
+void fslib::File::seek(int64_t offset, uint8_t origin)
+{
+    // Buffered writes are only ever contiguous, so they need to go out before the offset moves.
+    File::flushWriteBuffer();
+    Stream::seek(offset, origin);
+}
+
 ssize_t fslib::File::read(void *buffer, size_t bufferSize)
 {
     if (!m_isOpen || !File::isOpenForReading())
     {
-        g_fslibErrorString = ERROR_NOT_OPEN_FOR_READING;
+        fslib::error::setReason(fslib::Operation::ReadFile, ERROR_NOT_OPEN_FOR_READING);
+        return -1;
+    }
+
+    // Make sure anything waiting to be written is actually in the file before reading from it.
+    if (!File::flushWriteBuffer())
+    {
         return -1;
     }
 
+    // The file can be bigger on the device than it really is if it was grown ahead of time. Never read past the real end.
+    if (Stream::endOfStream())
+    {
+        return 0;
+    }
+    else if (m_offset + static_cast<int64_t>(bufferSize) > m_streamSize)
+    {
+        bufferSize = m_streamSize - m_offset;
+    }
+
+    // Small reads are served from the read buffer if it's enabled. Larger ones go straight to the file.
+    if (m_readBuffer && bufferSize < m_readBufferSize)
+    {
+        size_t bytesCopied = File::readFromBuffer(buffer, bufferSize);
+        if (bytesCopied < bufferSize && File::fillReadBuffer())
+        {
+            bytesCopied += File::readFromBuffer(static_cast<unsigned char *>(buffer) + bytesCopied, bufferSize - bytesCopied);
+        }
+        Stream::hashData(buffer, bytesCopied);
+        return bytesCopied;
+    }
+
     uint64_t bytesRead = 0;
     Result fsError = fsFileRead(&m_fileHandle, m_offset, buffer, bufferSize, FsReadOption_None, &bytesRead);
     if (R_FAILED(fsError) || bytesRead > bufferSize) // Carrying over that last one from 3DS...
     {
-        g_fslibErrorString = string::getFormattedString("Error reading from file: 0x%X.", fsError);
+        fslib::error::setResult(fslib::Operation::ReadFile, fsError);
         // I don't think this is a problem on Switch like on 3DS, but just in case.
         bytesRead = m_offset + static_cast<int64_t>(bufferSize) > m_streamSize ? m_streamSize - m_offset : bufferSize;
     }
+    Stream::hashData(buffer, bytesRead);
     m_offset += bytesRead;
     return bytesRead;
 }
@@ -126,7 +179,45 @@ bool fslib::File::readLine(char *lineOut, size_t lineLength)
 {
     if (!m_isOpen || !File::isOpenForReading())
     {
-        g_fslibErrorString = ERROR_NOT_OPEN_FOR_READING;
+        fslib::error::setReason(fslib::Operation::ReadFile, ERROR_NOT_OPEN_FOR_READING);
+        return false;
+    }
+
+    if (!File::flushWriteBuffer())
+    {
+        return false;
+    }
+
+    // With a read buffer, whole chunks of the line can be scanned and copied at once.
+    if (m_readBuffer)
+    {
+        size_t lineOffset = 0;
+        while (lineOffset < lineLength)
+        {
+            if (!File::offsetIsBuffered() && (Stream::endOfStream() || !File::fillReadBuffer()))
+            {
+                return false;
+            }
+
+            const char *bufferedData = reinterpret_cast<const char *>(&m_readBuffer[m_offset - m_readBufferOffset]);
+            size_t bytesAvailable = m_readBufferLength - (m_offset - m_readBufferOffset);
+            size_t searchLength = std::min(bytesAvailable, lineLength - lineOffset);
+
+            const char *lineBreak = findLineBreak(bufferedData, searchLength);
+            size_t copyLength = lineBreak ? lineBreak - bufferedData : searchLength;
+            std::memcpy(&lineOut[lineOffset], bufferedData, copyLength);
+            // The line break is consumed too, so it needs to be hashed along with the line.
+            Stream::hashData(bufferedData, lineBreak ? copyLength + 1 : copyLength);
+            lineOffset += copyLength;
+            m_offset += copyLength;
+
+            if (lineBreak)
+            {
+                // Skip over the line break so the next call starts on the next line.
+                ++m_offset;
+                return true;
+            }
+        }
         return false;
     }
 
@@ -158,35 +249,188 @@ signed char fslib::File::getByte(void)
 {
     if (!m_isOpen || !File::isOpenForReading())
     {
-        g_fslibErrorString = ERROR_NOT_OPEN_FOR_READING;
+        fslib::error::setReason(fslib::Operation::ReadFile, ERROR_NOT_OPEN_FOR_READING);
+        return -1;
+    }
+
+    if (!File::flushWriteBuffer() || Stream::endOfStream())
+    {
         return -1;
     }
 
+    if (m_readBuffer)
+    {
+        if (!File::offsetIsBuffered() && !File::fillReadBuffer())
+        {
+            return -1;
+        }
+        unsigned char byte = m_readBuffer[m_offset++ - m_readBufferOffset];
+        Stream::hashData(&byte, 1);
+        return static_cast<signed char>(byte);
+    }
+
     // I don't want to call another function just for this.
     char character = 0x00;
     uint64_t bytesRead = 0;
     Result fsError = fsFileRead(&m_fileHandle, m_offset++, &character, 1, FsReadOption_None, &bytesRead);
     if (R_FAILED(fsError) || bytesRead == 0)
     {
-        g_fslibErrorString = string::getFormattedString("Error reading byte from file: 0x%X.", fsError);
+        fslib::error::setResult(fslib::Operation::ReadFile, fsError);
         return -1;
     }
 
+    Stream::hashData(&character, 1);
     return character;
 }
 
+ssize_t fslib::File::readv(std::span<const fslib::ReadVector> vectors)
+{
+    if (!m_isOpen || !File::isOpenForReading())
+    {
+        fslib::error::setReason(fslib::Operation::ReadFile, ERROR_NOT_OPEN_FOR_READING);
+        return -1;
+    }
+
+    if (!File::flushWriteBuffer())
+    {
+        return -1;
+    }
+
+    if (Stream::endOfStream())
+    {
+        return 0;
+    }
+    int64_t totalSize = std::min(static_cast<int64_t>(Stream::getVectorSize(vectors)), m_streamSize - m_offset);
+    if (totalSize == 0)
+    {
+        return 0;
+    }
+
+    // Lots of small buffers are cheaper to read in one go and split up after.
+    std::unique_ptr<unsigned char[]> stagingBuffer;
+    if (vectors.size() > 1 && totalSize <= static_cast<int64_t>(Stream::vectorStagingLimit))
+    {
+        stagingBuffer.reset(new (std::nothrow) unsigned char[totalSize]);
+    }
+
+    if (stagingBuffer)
+    {
+        uint64_t bytesRead = 0;
+        Result fsError = fsFileRead(&m_fileHandle, m_offset, stagingBuffer.get(), totalSize, FsReadOption_None, &bytesRead);
+        if (R_FAILED(fsError))
+        {
+            fslib::error::setResult(fslib::Operation::ReadFile, fsError);
+            return -1;
+        }
+        Stream::scatterToVectors(stagingBuffer.get(), bytesRead, vectors);
+        Stream::hashData(stagingBuffer.get(), bytesRead);
+        m_offset += bytesRead;
+        return bytesRead;
+    }
+
+    int64_t totalBytesRead = 0;
+    for (const fslib::ReadVector &vector : vectors)
+    {
+        uint64_t readSize = std::min(static_cast<int64_t>(vector.bufferSize), totalSize - totalBytesRead);
+        if (readSize == 0)
+        {
+            break;
+        }
+
+        uint64_t bytesRead = 0;
+        Result fsError = fsFileRead(&m_fileHandle, m_offset, vector.buffer, readSize, FsReadOption_None, &bytesRead);
+        if (R_FAILED(fsError))
+        {
+            fslib::error::setResult(fslib::Operation::ReadFile, fsError);
+            return -1;
+        }
+        Stream::hashData(vector.buffer, bytesRead);
+        m_offset += bytesRead;
+        totalBytesRead += bytesRead;
+
+        if (bytesRead < readSize)
+        {
+            break;
+        }
+    }
+    return totalBytesRead;
+}
+
+ssize_t fslib::File::readAt(int64_t offset, void *buffer, size_t bufferSize)
+{
+    if (!m_isOpen || !File::isOpenForReading())
+    {
+        fslib::error::setReason(fslib::Operation::ReadFile, ERROR_NOT_OPEN_FOR_READING);
+        return -1;
+    }
+
+    // writeAt can change the size from another thread.
+    int64_t fileSize = std::atomic_ref<int64_t>(m_streamSize).load(std::memory_order_acquire);
+    if (offset < 0 || offset >= fileSize)
+    {
+        return 0;
+    }
+    else if (offset + static_cast<int64_t>(bufferSize) > fileSize)
+    {
+        bufferSize = fileSize - offset;
+    }
+
+    uint64_t bytesRead = 0;
+    Result fsError = fsFileRead(&m_fileHandle, offset, buffer, bufferSize, FsReadOption_None, &bytesRead);
+    if (R_FAILED(fsError))
+    {
+        fslib::error::setResult(fslib::Operation::ReadFile, fsError);
+        return -1;
+    }
+    return bytesRead;
+}
+
 ssize_t fslib::File::write(const void *buffer, size_t bufferSize)
 {
-    if (!m_isOpen || !File::isOpenForWriting() || !File::resizeIfNeeded(bufferSize))
+    if (!m_isOpen || !File::isOpenForWriting())
+    {
+        fslib::error::setReason(fslib::Operation::WriteFile, ERROR_NOT_OPEN_FOR_WRITING);
+        return -1;
+    }
+
+    // Whatever is in the read buffer might be stale after this.
+    m_readBufferLength = 0;
+
+    // Small writes are merged in the write buffer if it's enabled. Since every seek and read flushes it, the data in it always ends
+    // at the current offset.
+    if (m_writeBuffer && bufferSize < m_writeBufferSize)
+    {
+        if (m_writeBufferLength + bufferSize > m_writeBufferSize && !File::flushWriteBuffer())
+        {
+            return -1;
+        }
+
+        if (m_writeBufferLength == 0)
+        {
+            m_writeBufferOffset = m_offset;
+        }
+
+        std::memcpy(&m_writeBuffer[m_writeBufferLength], buffer, bufferSize);
+        m_writeBufferLength += bufferSize;
+        m_offset += bufferSize;
+        // The file isn't actually resized until the buffer is flushed, but it should look like it was.
+        if (m_offset > m_streamSize)
+        {
+            m_streamSize = m_offset;
+        }
+        return bufferSize;
+    }
+
+    // Anything already buffered has to go first to keep everything in order.
+    if (!File::flushWriteBuffer() || !File::resizeIfNeeded(m_offset, bufferSize))
     {
-        g_fslibErrorString = ERROR_NOT_OPEN_FOR_WRITING;
         return -1;
     }
 
     Result fsError = fsFileWrite(&m_fileHandle, m_offset, buffer, bufferSize, FsWriteOption_None);
     if (R_FAILED(fsError))
     {
-        g_fslibErrorString = string::getFormattedString("Error writing to file: 0x%X.", fsError);
+        fslib::error::setResult(fslib::Operation::WriteFile, fsError);
         return -1;
     }
     // There's no real way to verify this was successful on Switch
@@ -194,6 +438,116 @@ ssize_t fslib::File::write(const void *buffer, size_t bufferSize)
     return bufferSize;
 }
 
+ssize_t fslib::File::writev(std::span<const fslib::WriteVector> vectors)
+{
+    if (!m_isOpen || !File::isOpenForWriting())
+    {
+        fslib::error::setReason(fslib::Operation::WriteFile, ERROR_NOT_OPEN_FOR_WRITING);
+        return -1;
+    }
+
+    // Whatever is in the read buffer might be stale after this.
+    m_readBufferLength = 0;
+
+    // The file only needs to be resized once for everything.
+    size_t totalSize = Stream::getVectorSize(vectors);
+    if (!File::flushWriteBuffer() || !File::resizeIfNeeded(m_offset, totalSize))
+    {
+        return -1;
+    }
+
+    // Lots of small buffers are cheaper to merge and write in one go.
+    std::unique_ptr<unsigned char[]> stagingBuffer;
+    if (vectors.size() > 1 && totalSize <= Stream::vectorStagingLimit)
+    {
+        stagingBuffer.reset(new (std::nothrow) unsigned char[totalSize]);
+    }
+
+    if (stagingBuffer)
+    {
+        Stream::gatherFromVectors(vectors, stagingBuffer.get());
+        Result fsError = fsFileWrite(&m_fileHandle, m_offset, stagingBuffer.get(), totalSize, FsWriteOption_None);
+        if (R_FAILED(fsError))
+        {
+            fslib::error::setResult(fslib::Operation::WriteFile, fsError);
+            return -1;
+        }
+        m_offset += totalSize;
+        return totalSize;
+    }
+
+    for (const fslib::WriteVector &vector : vectors)
+    {
+        Result fsError = fsFileWrite(&m_fileHandle, m_offset, vector.buffer, vector.bufferSize, FsWriteOption_None);
+        if (R_FAILED(fsError))
+        {
+            fslib::error::setResult(fslib::Operation::WriteFile, fsError);
+            return -1;
+        }
+        m_offset += vector.bufferSize;
+    }
+    return totalSize;
+}
+
+ssize_t fslib::File::writeAt(int64_t offset, const void *buffer, size_t bufferSize)
+{
+    if (!m_isOpen || !File::isOpenForWriting())
+    {
+        fslib::error::setReason(fslib::Operation::WriteFile, ERROR_NOT_OPEN_FOR_WRITING);
+        return -1;
+    }
+
+    if (offset < 0)
+    {
+        fslib::error::setReason(fslib::Operation::WriteFile, "Invalid offset passed to writeAt.");
+        return -1;
+    }
+
+    std::atomic_ref<int64_t> allocatedSize(m_allocatedSize);
+    std::atomic_ref<int64_t> streamSize(m_streamSize);
+    int64_t requiredSize = offset + static_cast<int64_t>(bufferSize);
+    // The lock is only taken when the file actually needs to grow. The size is checked again in case another thread already grew it.
+    if (requiredSize > allocatedSize.load(std::memory_order_acquire))
+    {
+        std::lock_guard<std::mutex> resizeLock(m_resizeLock);
+        int64_t currentSize = allocatedSize.load(std::memory_order_acquire);
+        if (requiredSize > currentSize)
+        {
+            int64_t newFileSize = File::getGrowthSize(requiredSize);
+            Result fsError = fsFileSetSize(&m_fileHandle, newFileSize);
+            if (R_FAILED(fsError) && newFileSize > requiredSize)
+            {
+                newFileSize = requiredSize;
+                fsError = fsFileSetSize(&m_fileHandle, newFileSize);
+            }
+
+            if (R_FAILED(fsError))
+            {
+                fslib::error::setResult(fslib::Operation::ResizeFile, fsError);
+                return -1;
+            }
+            allocatedSize.store(newFileSize, std::memory_order_release);
+        }
+    }
+
+    Result fsError = fsFileWrite(&m_fileHandle, offset, buffer, bufferSize, FsWriteOption_None);
+    if (R_FAILED(fsError))
+    {
+        fslib::error::setResult(fslib::Operation::WriteFile, fsError);
+        return -1;
+    }
+
+    // Only raise the size. Another thread might have written further already.
+    int64_t fileSize = streamSize.load(std::memory_order_acquire);
+    while (requiredSize > fileSize && !streamSize.compare_exchange_weak(fileSize, requiredSize, std::memory_order_acq_rel))
+    {
+        // compare_exchange_weak reloads fileSize when it fails.
+    }
+    // Anything in the read buffer might be stale now.
+    std::atomic_ref<size_t>(m_readBufferLength).store(0, std::memory_order_release);
+    return bufferSize;
+}
+
 bool fslib::File::writef(const char *format, ...)
 {
     char vaBuffer[VA_BUFFER_SIZE] = {0};
@@ -209,9 +563,20 @@ bool fslib::File::writef(const char *format, ...)
 bool fslib::File::putByte(char byte)
 {
     // L o L
-    if (!m_isOpen || !File::isOpenForWriting() || !File::resizeIfNeeded(1))
+    if (!m_isOpen || !File::isOpenForWriting())
+    {
+        fslib::error::setReason(fslib::Operation::WriteFile, ERROR_NOT_OPEN_FOR_WRITING);
+        return false;
+    }
+
+    // This is exactly what the write buffer is for.
+    if (m_writeBuffer)
+    {
+        return File::write(&byte, 1) == 1;
+    }
+
+    if (!File::resizeIfNeeded(m_offset, 1))
     {
-        g_fslibErrorString = ERROR_NOT_OPEN_FOR_WRITING;
         return false;
     }
 
@@ -219,9 +584,10 @@ bool fslib::File::putByte(char byte)
     Result fsError = fsFileWrite(&m_fileHandle, m_offset++, &byte, 1, FsWriteOption_None);
     if (R_FAILED(fsError))
     {
-        g_fslibErrorString = string::getFormattedString("Error writing a single, tiny, miniscule byte to file: 0x%X.", fsError);
+        fslib::error::setResult(fslib::Operation::WriteFile, fsError);
         return false;
     }
+    m_readBufferLength = 0;
     return true;
 }
 
@@ -241,41 +607,224 @@ bool fslib::File::flush(void)
 {
     if (!m_isOpen || !File::isOpenForWriting())
     {
-        g_fslibErrorString = ERROR_NOT_OPEN_FOR_WRITING;
+        fslib::error::setReason(fslib::Operation::FlushFile, ERROR_NOT_OPEN_FOR_WRITING);
+        return false;
+    }
+
+    if (!File::flushWriteBuffer() || !File::trimToSize())
+    {
         return false;
     }
 
     Result fsError = fsFileFlush(&m_fileHandle);
     if (R_FAILED(fsError))
     {
-        g_fslibErrorString = string::getFormattedString("Error flushing file: 0x%X.", fsError);
+        fslib::error::setResult(fslib::Operation::FlushFile, fsError);
         return false;
     }
     return true;
 }
 
-bool fslib::File::resizeIfNeeded(size_t bufferSize)
+bool fslib::File::setReadBufferSize(size_t bufferSize)
 {
-    // Size remaining in file.
-    size_t spaceRemaining = m_streamSize - m_offset;
+    // Whatever was buffered is gone either way.
+    m_readBufferLength = 0;
 
-    // Resize isn't needed. Buffer will fit.
-    if (bufferSize <= spaceRemaining)
+    if (bufferSize == 0)
     {
+        m_readBuffer.reset();
+        m_readBufferSize = 0;
         return true;
     }
 
-    // Calculate new file size needed to fit buffer.
-    int64_t newFileSize = m_offset + bufferSize;
+    m_readBuffer.reset(new (std::nothrow) unsigned char[bufferSize]);
+    if (!m_readBuffer)
+    {
+        m_readBufferSize = 0;
+        fslib::error::setReason(fslib::Operation::SetBufferSize, "Couldn't allocate read buffer.");
+        return false;
+    }
+    m_readBufferSize = bufferSize;
+    return true;
+}
+
+bool fslib::File::setWriteBufferSize(size_t bufferSize)
+{
+    // Pending data has to be written before the buffer can be replaced.
+    if (!File::flushWriteBuffer())
+    {
+        return false;
+    }
+
+    if (bufferSize == 0)
+    {
+        m_writeBuffer.reset();
+        m_writeBufferSize = 0;
+        return true;
+    }
+
+    m_writeBuffer.reset(new (std::nothrow) unsigned char[bufferSize]);
+    if (!m_writeBuffer)
+    {
+        m_writeBufferSize = 0;
+        fslib::error::setReason(fslib::Operation::SetBufferSize, "Couldn't allocate write buffer.");
+        return false;
+    }
+    m_writeBufferSize = bufferSize;
+    return true;
+}
+
+bool fslib::File::flushWriteBuffer(void)
+{
+    if (m_writeBufferLength == 0)
+    {
+        return true;
+    }
+
+    // The buffer is emptied no matter what happens so a failure doesn't get retried forever.
+    size_t writeLength = m_writeBufferLength;
+    m_writeBufferLength = 0;
+
+    if (!File::resizeIfNeeded(m_writeBufferOffset, writeLength))
+    {
+        return false;
+    }
+
+    Result fsError = fsFileWrite(&m_fileHandle, m_writeBufferOffset, m_writeBuffer.get(), writeLength, FsWriteOption_None);
+    if (R_FAILED(fsError))
+    {
+        fslib::error::setResult(fslib::Operation::WriteFile, fsError);
+        return false;
+    }
+    return true;
+}
+
+void fslib::File::setGrowthPolicy(uint8_t growthMode, int64_t extentSize, int64_t maxGrowth)
+{
+    m_growthMode = growthMode;
+    // An extent size of 0 would never grow anything.
+    m_extentSize = extentSize > 0 ? extentSize : 1;
+    m_maxGrowth = maxGrowth;
+}
+
+bool fslib::File::resizeIfNeeded(int64_t offset, size_t bufferSize)
+{
+    // Calculate file size needed to fit buffer.
+    int64_t requiredSize = offset + static_cast<int64_t>(bufferSize);
+
+    // Resize isn't needed. Buffer will fit.
+    if (requiredSize > m_allocatedSize)
+    {
+        int64_t newFileSize = File::getGrowthSize(requiredSize);
+        Result fsError = fsFileSetSize(&m_fileHandle, newFileSize);
+        // Growing past what's needed can fail when what's needed wouldn't. Save data with little space left is an example.
+        if (R_FAILED(fsError) && newFileSize > requiredSize)
+        {
+            newFileSize = requiredSize;
+            fsError = fsFileSetSize(&m_fileHandle, newFileSize);
+        }
+
+        if (R_FAILED(fsError))
+        {
+            fslib::error::setResult(fslib::Operation::ResizeFile, fsError);
+            return false;
+        }
+        m_allocatedSize = newFileSize;
+    }
+
+    // The file can be bigger than this on the device, but only what's been written counts as its size.
+    if (requiredSize > m_streamSize)
+    {
+        m_streamSize = requiredSize;
+    }
+    return true;
+}
+
+int64_t fslib::File::getGrowthSize(int64_t requiredSize) const
+{
+    int64_t growth = 0;
+    switch (m_growthMode)
+    {
+        case File::growDouble:
+        {
+            growth = m_allocatedSize;
+        }
+        break;
 
-    Result fsError = fsFileSetSize(&m_fileHandle, newFileSize);
+        case File::growFixed:
+        {
+            // Round what's missing up to the next extent.
+            int64_t shortfall = requiredSize - m_allocatedSize;
+            growth = ((shortfall + m_extentSize - 1) / m_extentSize) * m_extentSize;
+        }
+        break;
+
+        default:
+        {
+            return requiredSize;
+        }
+        break;
+    }
+
+    if (m_maxGrowth > 0 && growth > m_maxGrowth)
+    {
+        growth = m_maxGrowth;
+    }
+    // No matter what, the write needs to fit.
+    return std::max(m_allocatedSize + growth, requiredSize);
+}
+
+bool fslib::File::trimToSize(void)
+{
+    if (m_allocatedSize <= m_streamSize)
+    {
+        return true;
+    }
+
+    Result fsError = fsFileSetSize(&m_fileHandle, m_streamSize);
     if (R_FAILED(fsError))
     {
-        g_fslibErrorString = string::getFormattedString("Error resizing file to fit buffer: 0x%X.", fsError);
+        fslib::error::setResult(fslib::Operation::ResizeFile, fsError);
         return false;
     }
-    // Update size
-    m_streamSize = newFileSize;
-    // Yay.
+    m_allocatedSize = m_streamSize;
     return true;
 }
+
+bool fslib::File::fillReadBuffer(void)
+{
+    // This is reset first so a failed read doesn't leave old data looking valid.
+    m_readBufferLength = 0;
+
+    // Don't buffer anything past the real end of the file.
+    if (Stream::endOfStream())
+    {
+        return false;
+    }
+    uint64_t readSize = std::min(static_cast<int64_t>(m_readBufferSize), m_streamSize - m_offset);
+
+    uint64_t bytesRead = 0;
+    Result fsError = fsFileRead(&m_fileHandle, m_offset, m_readBuffer.get(), readSize, FsReadOption_None, &bytesRead);
+    if (R_FAILED(fsError) || bytesRead > readSize)
+    {
+        fslib::error::setResult(fslib::Operation::ReadFile, fsError);
+        return false;
+    }
+    m_readBufferOffset = m_offset;
+    m_readBufferLength = bytesRead;
+    return bytesRead > 0;
+}
+
+size_t fslib::File::readFromBuffer(void *buffer, size_t bufferSize)
+{
+    if (!File::offsetIsBuffered())
+    {
+        return 0;
+    }
+
+    size_t bufferOffset = m_offset - m_readBufferOffset;
+    size_t bytesToCopy = std::min(m_readBufferLength - bufferOffset, bufferSize);
+    std::memcpy(buffer, &m_readBuffer[bufferOffset], bytesToCopy);
+    m_offset += bytesToCopy;
+    return bytesToCopy;
+}
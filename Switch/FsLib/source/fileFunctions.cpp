@@ -1,30 +1,28 @@
 #include "fileFunctions.hpp"
+#include "error.hpp"
 #include "errorCommon.h"
 #include "fslib.hpp"
-#include "string.hpp"
 #include <switch.h>
 
-extern std::string g_fslibErrorString;
-
 bool fslib::createFile(const fslib::Path &filePath, int64_t fileSize)
 {
     if (!filePath.isValid())
     {
-        g_fslibErrorString = ERROR_INVALID_PATH;
+        fslib::error::setReason(fslib::Operation::CreateFile, ERROR_INVALID_PATH, filePath);
         return false;
     }
 
     FsFileSystem *fileSystem;
-    if (!fslib::getFileSystemByDeviceName(filePath.getDeviceName(), &fileSystem))
+    if (!fslib::getFileSystemByPath(filePath, &fileSystem))
     {
-        g_fslibErrorString = ERROR_DEVICE_NOT_FOUND;
+        fslib::error::setReason(fslib::Operation::CreateFile, ERROR_DEVICE_NOT_FOUND, filePath);
         return false;
     }
 
     Result fsError = fsFsCreateFile(fileSystem, filePath.getPath(), fileSize, 0);
     if (R_FAILED(fsError))
     {
-        g_fslibErrorString = string::getFormattedString("Error creating file: 0x%X.", fsError);
+        fslib::error::setResult(fslib::Operation::CreateFile, fsError, filePath);
         return false;
     }
 
@@ -33,48 +31,29 @@ bool fslib::createFile(const fslib::Path &filePath, int64_t fileSize)
 
 bool fslib::fileExists(const fslib::Path &filePath)
 {
-    if (!filePath.isValid())
-    {
-        g_fslibErrorString = ERROR_INVALID_PATH;
-        return false;
-    }
-
-    FsFileSystem *fileSystem;
-    if (!fslib::getFileSystemByDeviceName(filePath.getDeviceName(), &fileSystem))
-    {
-        g_fslibErrorString = ERROR_DEVICE_NOT_FOUND;
-        return false;
-    }
-
-    FsFile fileHandle;
-    Result fsError = fsFsOpenFile(fileSystem, filePath.getPath(), FsOpenMode_Read, &fileHandle);
-    if (R_FAILED(fsError))
-    {
-        return false;
-    }
-    fsFileClose(&fileHandle);
-    return true;
+    fslib::EntryInfo entryInfo;
+    return fslib::getEntryInfo(filePath, entryInfo, 0) && !entryInfo.isDirectory;
 }
 
 bool fslib::deleteFile(const fslib::Path &filePath)
 {
     if (!filePath.isValid())
     {
-        g_fslibErrorString = ERROR_INVALID_PATH;
+        fslib::error::setReason(fslib::Operation::DeleteFile, ERROR_INVALID_PATH, filePath);
         return false;
     }
 
     FsFileSystem *fileSystem;
-    if (!fslib::getFileSystemByDeviceName(filePath.getDeviceName(), &fileSystem))
+    if (!fslib::getFileSystemByPath(filePath, &fileSystem))
     {
-        g_fslibErrorString = ERROR_DEVICE_NOT_FOUND;
+        fslib::error::setReason(fslib::Operation::DeleteFile, ERROR_DEVICE_NOT_FOUND, filePath);
         return false;
     }
 
     Result fsError = fsFsDeleteFile(fileSystem, filePath.getPath());
     if (R_FAILED(fsError))
     {
-        g_fslibErrorString = string::getFormattedString("Error deleting file: 0x%X.", fsError);
+        fslib::error::setResult(fslib::Operation::DeleteFile, fsError, filePath);
         return false;
     }
     return true;
@@ -82,58 +61,105 @@ bool fslib::deleteFile(const fslib::Path &filePath)
 
 int64_t fslib::getFileSize(const fslib::Path &filePath)
 {
-    if (!filePath.isValid())
+    fslib::EntryInfo entryInfo;
+    if (!fslib::getEntryInfo(filePath, entryInfo, ENTRY_INFO_SIZE))
     {
-        g_fslibErrorString = ERROR_INVALID_PATH;
         return -1;
     }
 
-    FsFileSystem *fileSystem;
-    if (!fslib::getFileSystemByDeviceName(filePath.getDeviceName(), &fileSystem))
+    if (entryInfo.isDirectory)
     {
-        g_fslibErrorString = ERROR_DEVICE_NOT_FOUND;
+        fslib::error::setReason(fslib::Operation::GetFileSize, "Path is a directory.", filePath);
         return -1;
     }
+    return entryInfo.size;
+}
 
-    FsFile fileHandle;
-    Result fsError = fsFsOpenFile(fileSystem, filePath.getPath(), FsOpenMode_Read, &fileHandle);
-    if (R_FAILED(fsError))
+bool fslib::getEntryInfo(const fslib::Path &entryPath, fslib::EntryInfo &infoOut, uint8_t infoFlags)
+{
+    if (!entryPath.isValid())
     {
-        g_fslibErrorString = string::getFormattedString("Error opening file to get size: 0x%X.", fsError);
-        return -1;
+        fslib::error::setReason(fslib::Operation::GetEntryInfo, ERROR_INVALID_PATH, entryPath);
+        return false;
     }
 
-    int64_t fileSize = 0;
-    fsError = fsFileGetSize(&fileHandle, &fileSize);
-    if (R_FAILED(fsError))
+    FsFileSystem *fileSystem;
+    if (!fslib::getFileSystemByPath(entryPath, &fileSystem))
     {
+        fslib::error::setReason(fslib::Operation::GetEntryInfo, ERROR_DEVICE_NOT_FOUND, entryPath);
+        return false;
+    }
+
+    infoOut = {};
+
+    // If the size is wanted, the file has to be opened anyway. Opening it successfully also means it's a file, so the type doesn't need
+    // to be asked for separately.
+    FsFile fileHandle;
+    Result openError = (infoFlags & ENTRY_INFO_SIZE) ? fsFsOpenFile(fileSystem, entryPath.getPath(), FsOpenMode_Read, &fileHandle) : 0;
+    bool isFile = (infoFlags & ENTRY_INFO_SIZE) && R_SUCCEEDED(openError);
+    if (isFile)
+    {
+        Result fsError = fsFileGetSize(&fileHandle, &infoOut.size);
         fsFileClose(&fileHandle);
-        g_fslibErrorString = string::getFormattedString("Error getting file size: 0x%X.", fsError);
-        return -1;
+        if (R_FAILED(fsError))
+        {
+            fslib::error::setResult(fslib::Operation::GetFileSize, fsError, entryPath);
+            return false;
+        }
+    }
+    else
+    {
+        FsDirEntryType entryType;
+        Result fsError = fsFsGetEntryType(fileSystem, entryPath.getPath(), &entryType);
+        if (R_FAILED(fsError))
+        {
+            fslib::error::setResult(fslib::Operation::GetEntryInfo, fsError, entryPath);
+            return false;
+        }
+
+        // The open only failing because the entry is a directory is expected. A file that couldn't be opened means its size is unknown.
+        if ((infoFlags & ENTRY_INFO_SIZE) && entryType == FsDirEntryType_File)
+        {
+            fslib::error::setResult(fslib::Operation::OpenFile, openError, entryPath);
+            return false;
+        }
+        infoOut.isDirectory = entryType == FsDirEntryType_Dir;
+    }
+
+    if (infoFlags & ENTRY_INFO_TIMESTAMPS)
+    {
+        // Not every file system supports this, so failing isn't an error.
+        FsTimeStampRaw timeStamp = {0};
+        if (R_SUCCEEDED(fsFsGetFileTimeStampRaw(fileSystem, entryPath.getPath(), &timeStamp)) && timeStamp.is_valid)
+        {
+            infoOut.hasTimestamps = true;
+            infoOut.created = timeStamp.created;
+            infoOut.modified = timeStamp.modified;
+            infoOut.accessed = timeStamp.accessed;
+        }
     }
-    fsFileClose(&fileHandle);
-    return fileSize;
+    return true;
 }
 
 bool fslib::renameFile(const fslib::Path &oldPath, const fslib::Path &newPath)
 {
     if (!oldPath.isValid() || !newPath.isValid() || oldPath.getDeviceName() != newPath.getDeviceName())
     {
-        g_fslibErrorString = ERROR_INVALID_PATH;
+        fslib::error::setReason(fslib::Operation::RenameFile, ERROR_INVALID_PATH, oldPath);
         return false;
     }
 
     FsFileSystem *fileSystem;
-    if (!fslib::getFileSystemByDeviceName(oldPath.getDeviceName(), &fileSystem))
+    if (!fslib::getFileSystemByPath(oldPath, &fileSystem))
     {
-        g_fslibErrorString = ERROR_DEVICE_NOT_FOUND;
+        fslib::error::setReason(fslib::Operation::RenameFile, ERROR_DEVICE_NOT_FOUND, oldPath);
         return false;
     }
 
     Result fsError = fsFsRenameFile(fileSystem, oldPath.getPath(), newPath.getPath());
     if (R_FAILED(fsError))
     {
-        g_fslibErrorString = string::getFormattedString("Error renaming file: 0x%X.", fsError);
+        fslib::error::setResult(fslib::Operation::RenameFile, fsError, oldPath);
         return false;
     }
     return true;
@@ -1,25 +1,185 @@
 #include "fslib.hpp"
 #include "dev.hpp"
+#include "error.hpp"
 #include "errorCommon.h"
-#include "string.hpp"
+#include <array>
+#include <atomic>
 #include <cstring>
-#include <unordered_map>
+#include <mutex>
 
 namespace
 {
     // This is always what the sd card is mounted to.
     constexpr std::string_view SD_CARD_DEVICE = "sdmc";
-    // FsFileSystems paired with their mount point.
-    std::unordered_map<std::string_view, FsFileSystem> s_deviceMap;
+    // Most file systems that can be mapped at once.
+    constexpr size_t DEVICE_SLOT_COUNT = 64;
+    // Device names are stored as zero padded 64 bit words so lookups can read them without taking the lock.
+    constexpr size_t DEVICE_NAME_WORDS = 4;
+    constexpr size_t DEVICE_NAME_LENGTH = DEVICE_NAME_WORDS * sizeof(uint64_t);
+    // Device IDs are the slot in the low byte and how many times the slot has been mapped in the rest.
+    constexpr uint32_t DEVICE_ID_SLOT_BITS = 8;
+    constexpr uint32_t DEVICE_ID_SLOT_MASK = (1 << DEVICE_ID_SLOT_BITS) - 1;
+    constexpr uint32_t DEVICE_ID_MAX_MOUNT_COUNT = 0xFFFFFFFF >> DEVICE_ID_SLOT_BITS;
+
+    using DeviceName = std::array<uint64_t, DEVICE_NAME_WORDS>;
+
+    // The device ID works as the slot's sequence lock. It's 0 while the slot is free, so the name can only change while lookups are
+    // skipping the slot. Lookups that race a close and remap see a different ID when they check again and ignore what they read.
+    // This only protects the lookup itself. Nothing stops a close from happening while the file system a lookup returned is in use.
+    struct DeviceSlot
+    {
+            std::atomic<uint32_t> deviceID = fslib::INVALID_DEVICE_ID;
+            std::array<std::atomic<uint64_t>, DEVICE_NAME_WORDS> name;
+            FsFileSystem fileSystem;
+            // Only touched with the lock held.
+            uint32_t mountCount = 0;
+    };
+
+    std::array<DeviceSlot, DEVICE_SLOT_COUNT> s_deviceSlots;
+    // Taken by anything that maps or closes a device. Lookups never take it.
+    std::mutex s_deviceLock;
 } // namespace
 
-// This error string is shared globally, but I didn't want it extern'd in the header.
-std::string g_fslibErrorString = "No errors encountered.";
+// Copies deviceName into a zero padded DeviceName. Returns false if it's empty or too long to store.
+static bool encodeDeviceName(std::string_view deviceName, DeviceName &nameOut)
+{
+    if (deviceName.empty() || deviceName.length() > DEVICE_NAME_LENGTH)
+    {
+        return false;
+    }
+    nameOut.fill(0);
+    std::memcpy(nameOut.data(), deviceName.data(), deviceName.length());
+    return true;
+}
 
-// This is for opening functions to search and make sure there are no duplicate uses of the same device name.
-static inline bool deviceNameIsInUse(std::string_view deviceName)
+// Returns the slot deviceID is mapped to. nullptr if the ID is stale or invalid.
+static DeviceSlot *findSlot(uint32_t deviceID)
 {
-    return s_deviceMap.find(deviceName) != s_deviceMap.end();
+    size_t slotIndex = deviceID & DEVICE_ID_SLOT_MASK;
+    if (deviceID == fslib::INVALID_DEVICE_ID || slotIndex >= DEVICE_SLOT_COUNT)
+    {
+        return nullptr;
+    }
+
+    DeviceSlot &slot = s_deviceSlots[slotIndex];
+    return slot.deviceID.load(std::memory_order_acquire) == deviceID ? &slot : nullptr;
+}
+
+// Searches the slots for deviceName without locking.
+static uint32_t findDeviceID(std::string_view deviceName)
+{
+    DeviceName name;
+    if (!encodeDeviceName(deviceName, name))
+    {
+        return fslib::INVALID_DEVICE_ID;
+    }
+
+    for (DeviceSlot &slot : s_deviceSlots)
+    {
+        uint32_t deviceID = slot.deviceID.load(std::memory_order_acquire);
+        if (deviceID == fslib::INVALID_DEVICE_ID)
+        {
+            continue;
+        }
+
+        bool nameMatches = true;
+        for (size_t i = 0; i < DEVICE_NAME_WORDS; i++)
+        {
+            nameMatches = slot.name[i].load(std::memory_order_relaxed) == name[i] && nameMatches;
+        }
+
+        // The name only counts if the slot wasn't closed or remapped while it was being read.
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (nameMatches && slot.deviceID.load(std::memory_order_relaxed) == deviceID)
+        {
+            return deviceID;
+        }
+    }
+    return fslib::INVALID_DEVICE_ID;
+}
+
+// Returns the name stored in slot. Only called with the lock held.
+static std::string getSlotName(const DeviceSlot &slot)
+{
+    char name[DEVICE_NAME_LENGTH];
+    for (size_t i = 0; i < DEVICE_NAME_WORDS; i++)
+    {
+        uint64_t nameWord = slot.name[i].load(std::memory_order_relaxed);
+        std::memcpy(&name[i * sizeof(uint64_t)], &nameWord, sizeof(uint64_t));
+    }
+    return std::string(name, strnlen(name, DEVICE_NAME_LENGTH));
+}
+
+// Places fileSystem in a free slot under deviceName. Only called with the lock held.
+static uint32_t addDevice(std::string_view deviceName, const FsFileSystem &fileSystem)
+{
+    DeviceName name;
+    if (!encodeDeviceName(deviceName, name))
+    {
+        fslib::error::setReason(fslib::Operation::MapDevice, "Device names need to be between 1 and 32 characters.", deviceName);
+        return fslib::INVALID_DEVICE_ID;
+    }
+
+    for (size_t i = 0; i < DEVICE_SLOT_COUNT; i++)
+    {
+        DeviceSlot &slot = s_deviceSlots[i];
+        if (slot.deviceID.load(std::memory_order_relaxed) != fslib::INVALID_DEVICE_ID)
+        {
+            continue;
+        }
+
+        // Everything written here has to be visible before the ID is.
+        std::atomic_thread_fence(std::memory_order_release);
+        // Memcpy the handle to be 100% sure we have it 1:1.
+        std::memcpy(&slot.fileSystem, &fileSystem, sizeof(FsFileSystem));
+        for (size_t j = 0; j < DEVICE_NAME_WORDS; j++)
+        {
+            slot.name[j].store(name[j], std::memory_order_relaxed);
+        }
+
+        // The mount count starts over at 1 so an ID is never 0.
+        slot.mountCount = slot.mountCount % DEVICE_ID_MAX_MOUNT_COUNT + 1;
+        uint32_t deviceID = (slot.mountCount << DEVICE_ID_SLOT_BITS) | i;
+        slot.deviceID.store(deviceID, std::memory_order_release);
+        return deviceID;
+    }
+    fslib::error::setReason(fslib::Operation::MapDevice, "No device slots are free.", deviceName);
+    return fslib::INVALID_DEVICE_ID;
+}
+
+// Closes the file system in slot and frees it. Only called with the lock held.
+static void closeSlot(DeviceSlot &slot)
+{
+    std::string deviceName = getSlotName(slot);
+    slot.deviceID.store(fslib::INVALID_DEVICE_ID, std::memory_order_release);
+    fsFsClose(&slot.fileSystem);
+    fslib::forgetKnownDirectories(deviceName);
+}
+
+// Resolves path's device. Paths that still have a valid device ID cached skip searching the slots entirely.
+static FsFileSystem *findFileSystem(const fslib::Path &path)
+{
+    DeviceSlot *slot = findSlot(path.getDeviceCache());
+    if (slot)
+    {
+        return &slot->fileSystem;
+    }
+
+    uint32_t deviceID = findDeviceID(path.getDeviceName());
+    slot = findSlot(deviceID);
+    if (!slot)
+    {
+        return nullptr;
+    }
+    path.setDeviceCache(deviceID);
+    return &slot->fileSystem;
+}
+
+// Returns the file system mapped to deviceName. nullptr if there isn't one.
+static FsFileSystem *findFileSystem(std::string_view deviceName)
+{
+    DeviceSlot *slot = findSlot(findDeviceID(deviceName));
+    return slot ? &slot->fileSystem : nullptr;
 }
 
 bool fslib::initialize(void)
@@ -30,69 +190,105 @@ bool fslib::initialize(void)
     Result fsError = fsOpenSdCardFileSystem(&sdmc);
     if (R_FAILED(fsError))
     {
+        fslib::error::setResult(fslib::Operation::OpenFileSystem, fsError, SD_CARD_DEVICE);
         return false;
     }
-    // Memcpy the handle to be 100% sure we have it 1:1.
-    std::memcpy(&s_deviceMap[SD_CARD_DEVICE], &sdmc, sizeof(FsFileSystem));
 
-    return true;
+    std::lock_guard<std::mutex> deviceLock(s_deviceLock);
+    return addDevice(SD_CARD_DEVICE, sdmc) != fslib::INVALID_DEVICE_ID;
 }
 
 void fslib::exit(void)
 {
-    // Loop through and close all open devices in map.
-    for (auto &[deviceName, fileSystem] : s_deviceMap)
+    // Requests still running could be using the devices about to be closed.
+    fslib::async::exit();
+
+    // Loop through and close all open devices.
+    std::lock_guard<std::mutex> deviceLock(s_deviceLock);
+    for (DeviceSlot &slot : s_deviceSlots)
     {
         // This is call directly instead of closeFileSystem because that guards against closing the SD.
-        fsFsClose(&fileSystem);
+        if (slot.deviceID.load(std::memory_order_relaxed) != fslib::INVALID_DEVICE_ID)
+        {
+            closeSlot(slot);
+        }
     }
 }
 
-const char *fslib::getErrorString(void)
-{
-    return g_fslibErrorString.c_str();
-}
-
 bool fslib::mapFileSystem(std::string_view deviceName, FsFileSystem *fileSystem)
 {
     if (deviceName == SD_CARD_DEVICE)
     {
-        g_fslibErrorString = "Error: sdmc is a reserved device name.";
+        fslib::error::setReason(fslib::Operation::MapDevice, "sdmc is a reserved device name.", deviceName);
         return false;
     }
 
-    if (deviceNameIsInUse(deviceName))
+    std::lock_guard<std::mutex> deviceLock(s_deviceLock);
+    DeviceSlot *slot = findSlot(findDeviceID(deviceName));
+    if (slot)
     {
-        fslib::closeFileSystem(deviceName);
+        closeSlot(*slot);
     }
 
-    std::memcpy(&s_deviceMap[deviceName], fileSystem, sizeof(FsFileSystem));
+    return addDevice(deviceName, *fileSystem) != fslib::INVALID_DEVICE_ID;
+}
 
-    return true;
+uint32_t fslib::getDeviceID(std::string_view deviceName)
+{
+    return findDeviceID(deviceName);
 }
 
 bool fslib::getFileSystemByDeviceName(std::string_view deviceName, FsFileSystem **fileSystemOut)
 {
-    if (!deviceNameIsInUse(deviceName))
+    FsFileSystem *fileSystem = findFileSystem(deviceName);
+    if (!fileSystem)
+    {
+        return false;
+    }
+    *fileSystemOut = fileSystem;
+    return true;
+}
+
+bool fslib::getFileSystemByDeviceID(uint32_t deviceID, FsFileSystem **fileSystemOut)
+{
+    DeviceSlot *slot = findSlot(deviceID);
+    if (!slot)
     {
         return false;
     }
-    *fileSystemOut = &s_deviceMap[deviceName];
+    *fileSystemOut = &slot->fileSystem;
+    return true;
+}
+
+bool fslib::getFileSystemByPath(const fslib::Path &path, FsFileSystem **fileSystemOut)
+{
+    FsFileSystem *fileSystem = findFileSystem(path);
+    if (!fileSystem)
+    {
+        return false;
+    }
+    *fileSystemOut = fileSystem;
     return true;
 }
 
 bool fslib::commitDataToFileSystem(std::string_view deviceName)
 {
-    if (!deviceNameIsInUse(deviceName))
+    return fslib::commitDataToFileSystem(findDeviceID(deviceName));
+}
+
+bool fslib::commitDataToFileSystem(uint32_t deviceID)
+{
+    DeviceSlot *slot = findSlot(deviceID);
+    if (!slot)
     {
-        g_fslibErrorString = ERROR_DEVICE_NOT_FOUND;
+        fslib::error::setReason(fslib::Operation::CommitDevice, ERROR_DEVICE_NOT_FOUND);
         return false;
     }
 
-    Result fsError = fsFsCommit(&s_deviceMap[deviceName]);
+    Result fsError = fsFsCommit(&slot->fileSystem);
     if (R_FAILED(fsError))
     {
-        g_fslibErrorString = string::getFormattedString("Error committing data to device: 0x%X.", fsError);
+        fslib::error::setResult(fslib::Operation::CommitDevice, fsError);
         return false;
     }
     return true;
@@ -105,20 +301,21 @@ bool fslib::getDeviceFreeSpace(const fslib::Path &deviceRoot, int64_t &sizeOut)
 
     if (!deviceRoot.isValid())
     {
-        g_fslibErrorString = ERROR_INVALID_PATH;
+        fslib::error::setReason(fslib::Operation::GetDeviceSpace, ERROR_INVALID_PATH, deviceRoot);
         return false;
     }
 
-    if (!deviceNameIsInUse(deviceRoot.getDeviceName()))
+    FsFileSystem *fileSystem = findFileSystem(deviceRoot);
+    if (!fileSystem)
     {
-        g_fslibErrorString = ERROR_DEVICE_NOT_FOUND;
+        fslib::error::setReason(fslib::Operation::GetDeviceSpace, ERROR_DEVICE_NOT_FOUND, deviceRoot);
         return false;
     }
 
-    Result fsError = fsFsGetFreeSpace(&s_deviceMap[deviceRoot.getDeviceName()], deviceRoot.getPath(), &sizeOut);
+    Result fsError = fsFsGetFreeSpace(fileSystem, deviceRoot.getPath(), &sizeOut);
     if (R_FAILED(fsError))
     {
-        g_fslibErrorString = string::getFormattedString("Error getting device free space: 0x%X.", fsError);
+        fslib::error::setResult(fslib::Operation::GetDeviceSpace, fsError, deviceRoot);
         return false;
     }
 
@@ -131,20 +328,21 @@ bool fslib::getDeviceTotalSpace(const fslib::Path &deviceRoot, int64_t &sizeOut)
 
     if (!deviceRoot.isValid())
     {
-        g_fslibErrorString = ERROR_INVALID_PATH;
+        fslib::error::setReason(fslib::Operation::GetDeviceSpace, ERROR_INVALID_PATH, deviceRoot);
         return false;
     }
 
-    if (!deviceNameIsInUse(deviceRoot.getDeviceName()))
+    FsFileSystem *fileSystem = findFileSystem(deviceRoot);
+    if (!fileSystem)
     {
-        g_fslibErrorString = ERROR_DEVICE_NOT_FOUND;
+        fslib::error::setReason(fslib::Operation::GetDeviceSpace, ERROR_DEVICE_NOT_FOUND, deviceRoot);
         return false;
     }
 
-    Result fsError = fsFsGetTotalSpace(&s_deviceMap[deviceRoot.getDeviceName()], deviceRoot.getPath(), &sizeOut);
+    Result fsError = fsFsGetTotalSpace(fileSystem, deviceRoot.getPath(), &sizeOut);
     if (R_FAILED(fsError))
     {
-        g_fslibErrorString = string::getFormattedString("Error getting device total space: 0x%X.", fsError);
+        fslib::error::setResult(fslib::Operation::GetDeviceSpace, fsError, deviceRoot);
         return false;
     }
 
@@ -153,20 +351,20 @@ bool fslib::getDeviceTotalSpace(const fslib::Path &deviceRoot, int64_t &sizeOut)
 
 bool fslib::closeFileSystem(std::string_view deviceName)
 {
-    // Block closing sdmc. Only exiting FsLib can do that.
-    if (deviceName == SD_CARD_DEVICE)
-    {
-        return false;
-    }
+    return fslib::closeFileSystem(findDeviceID(deviceName));
+}
 
-    if (!deviceNameIsInUse(deviceName))
+bool fslib::closeFileSystem(uint32_t deviceID)
+{
+    std::lock_guard<std::mutex> deviceLock(s_deviceLock);
+    DeviceSlot *slot = findSlot(deviceID);
+    // Block closing sdmc. Only exiting FsLib can do that.
+    if (!slot || getSlotName(*slot) == SD_CARD_DEVICE)
     {
         return false;
     }
-    // Close file system.
-    fsFsClose(&s_deviceMap[deviceName]);
-    // Erase from map so everything works right.
-    s_deviceMap.erase(deviceName);
+    // Close the file system and free the slot. Paths still caching the old ID will look the device up again.
+    closeSlot(*slot);
     // Done
     return true;
 }
@@ -0,0 +1,45 @@
+#include "hash.hpp"
+
+fslib::Hasher::Hasher(uint8_t hashTypes) : m_hashTypes(hashTypes)
+{
+    Hasher::reset();
+}
+
+void fslib::Hasher::reset(void)
+{
+    m_crc32 = 0;
+    m_length = 0;
+    sha256ContextCreate(&m_sha256Context);
+}
+
+void fslib::Hasher::update(const void *data, size_t dataSize)
+{
+    if (m_hashTypes & Hasher::crc32)
+    {
+        // LibNX's CRC32 can be continued in chunks by passing the last result as the seed.
+        m_crc32 = crc32CalculateWithSeed(m_crc32, data, dataSize);
+    }
+
+    if (m_hashTypes & Hasher::sha256)
+    {
+        sha256ContextUpdate(&m_sha256Context, data, dataSize);
+    }
+    m_length += dataSize;
+}
+
+uint32_t fslib::Hasher::getCrc32(void) const
+{
+    return m_crc32;
+}
+
+void fslib::Hasher::getSha256(uint8_t *hashOut) const
+{
+    // Getting the hash finalizes the context, so a copy is used to keep this one going.
+    Sha256Context hashContext = m_sha256Context;
+    sha256ContextGetHash(&hashContext, hashOut);
+}
+
+uint64_t fslib::Hasher::getLength(void) const
+{
+    return m_length;
+}
@@ -1,4 +1,6 @@
 #include "path.hpp"
+#include "pathLiteral.hpp"
+#include <algorithm>
 #include <cstring>
 #include <string>
 #include <switch.h>
@@ -8,31 +10,19 @@ namespace
     const char *FORBIDDEN_PATH_CHARACTERS = "<>:\"|?*";
 } // namespace
 
-std::string ensureSdmcPrefix(const char *path)
-{
-    const char *defaultDevice = "sdmc:";
-    if (std::strncmp(path, defaultDevice, std::strlen(defaultDevice)) == 0)
-    {
-        return std::string(path);
-    }
-    return std::string(defaultDevice) + path;
-}
-
-// This will get the trimmed down version of the path with no beginning or trailing slashes. Passing NULL or nullptr to pathBegin will skip trimming the beginning.
-static void getTrimmedPath(const char *path, const char **pathBegin, size_t &pathLengthOut)
+// This will get the trimmed down version of the path with no beginning or trailing slashes.
+static void getTrimmedPath(const char *path, size_t pathLength, const char **pathBegin, size_t &pathLengthOut)
 {
     // Get where the beginning of the path begins after slashes.
-    if (pathBegin)
+    const char *pathEnd = path + pathLength;
+    while (path < pathEnd && *path == '/')
     {
-        while (*path == '/')
-        {
-            ++path;
-        }
-        *pathBegin = path;
+        ++path;
     }
+    *pathBegin = path;
 
-    // Get the length of the path starting at that beginning. Loop backwards until we have
-    for (pathLengthOut = std::char_traits<char>::length(path); pathLengthOut > 0; pathLengthOut--)
+    // Loop backwards from the end until we hit something that isn't a slash.
+    for (pathLengthOut = pathEnd - path; pathLengthOut > 0; pathLengthOut--)
     {
         if (path[pathLengthOut - 1] != '/')
         {
@@ -46,24 +36,35 @@ fslib::Path::Path(const fslib::Path &path)
     *this = path;
 }
 
+fslib::Path::Path(fslib::Path &&path) noexcept
+{
+    *this = std::move(path);
+}
+
 fslib::Path::Path(const char *pathData)
 {
-    *this = ensureSdmcPrefix(pathData);
+    Path::assignPath(pathData, std::char_traits<char>::length(pathData));
 }
 
 fslib::Path::Path(const std::string &pathData)
 {
-    *this = ensureSdmcPrefix(pathData.c_str());
+    Path::assignPath(pathData.c_str(), pathData.length());
 }
 
 fslib::Path::Path(std::string_view pathData)
 {
-    *this = ensureSdmcPrefix(pathData.data());
+    Path::assignPath(pathData.data(), pathData.length());
 }
 
 fslib::Path::Path(const std::filesystem::path &pathData)
 {
-    *this = ensureSdmcPrefix(pathData.c_str());
+    const std::string &pathString = pathData.native();
+    Path::assignPath(pathString.c_str(), pathString.length());
+}
+
+fslib::Path::Path(const fslib::PathLiteral &literal)
+{
+    Path::assignCheckedPath(literal.cString(), literal.getLength(), literal.getDeviceName().length());
 }
 
 fslib::Path::~Path()
@@ -73,8 +74,8 @@ fslib::Path::~Path()
 
 bool fslib::Path::isValid(void) const
 {
-    return m_path && m_deviceEnd && std::char_traits<char>::length(m_deviceEnd + 1) > 0 &&
-           std::strpbrk(m_deviceEnd + 1, FORBIDDEN_PATH_CHARACTERS) == NULL;
+    return m_deviceEnd != Path::notFound && m_pathLength > m_deviceEnd + 1 &&
+           std::strpbrk(&m_path[m_deviceEnd + 1], FORBIDDEN_PATH_CHARACTERS) == NULL;
 }
 
 fslib::Path fslib::Path::subPath(size_t pathLength) const
@@ -85,13 +86,15 @@ fslib::Path fslib::Path::subPath(size_t pathLength) const
     }
 
     fslib::Path newPath;
-    if (newPath.allocatePath(m_pathSize))
+    if (newPath.reservePath(pathLength + 1))
     {
         // Copy the sub path to newPath's buffer.
         std::memcpy(newPath.m_path, m_path, pathLength);
-        // Make sure newPath's data is its own.
-        newPath.m_deviceEnd = std::strchr(newPath.m_path, ':');
-        newPath.m_pathLength = std::char_traits<char>::length(newPath.m_path);
+        newPath.m_path[pathLength] = '\0';
+        newPath.m_pathLength = pathLength;
+        // The device is only kept if the sub path still contains all of it.
+        newPath.m_deviceEnd = m_deviceEnd < pathLength ? m_deviceEnd : Path::notFound;
+        newPath.m_deviceCache.store(m_deviceEnd < pathLength ? Path::getDeviceCache() : 0, std::memory_order_relaxed);
     }
     // Not sure returning this empty on failure is the best idea, but it might be the only option.
     return newPath;
@@ -162,12 +165,20 @@ const char *fslib::Path::cString(void) const
 
 std::string_view fslib::Path::getDeviceName(void) const
 {
-    return std::string_view(m_path, m_deviceEnd - m_path);
+    if (m_deviceEnd == Path::notFound)
+    {
+        return std::string_view();
+    }
+    return std::string_view(m_path, m_deviceEnd);
 }
 
 const char *fslib::Path::getPath(void) const
 {
-    return m_deviceEnd + 1;
+    if (m_deviceEnd == Path::notFound)
+    {
+        return m_path;
+    }
+    return &m_path[m_deviceEnd + 1];
 }
 
 size_t fslib::Path::getLength(void) const
@@ -175,164 +186,295 @@ size_t fslib::Path::getLength(void) const
     return m_pathLength;
 }
 
+uint32_t fslib::Path::getDeviceCache(void) const
+{
+    return m_deviceCache.load(std::memory_order_relaxed);
+}
+
+void fslib::Path::setDeviceCache(uint32_t deviceCache) const
+{
+    m_deviceCache.store(deviceCache, std::memory_order_relaxed);
+}
+
 fslib::Path &fslib::Path::operator=(const fslib::Path &path)
 {
-    if (!Path::allocatePath(path.m_pathSize))
+    if (this == &path || !Path::reservePath(path.m_pathLength + 1))
     {
         // Not sure this is the best idea. To do: Throw allocation error or something?
         return *this;
     }
 
-    // Copy path's data and correct m_deviceEnd so it points to this instance's m_Path.
-    std::memcpy(m_path, path.m_path, path.m_pathSize);
-    m_pathSize = path.m_pathSize;
+    // Only the used part of the buffer needs to be copied.
+    std::memcpy(m_path, path.m_path, path.m_pathLength + 1);
     m_pathLength = path.m_pathLength;
-    m_deviceEnd = std::strchr(m_path, ':');
+    m_deviceEnd = path.m_deviceEnd;
+    // Same device, so the same slot.
+    m_deviceCache.store(path.getDeviceCache(), std::memory_order_relaxed);
 
     return *this;
 }
 
-fslib::Path &fslib::Path::operator=(const char *pathData)
+fslib::Path &fslib::Path::operator=(fslib::Path &&path) noexcept
 {
-    // Need to calculate m_path's size since Switch expects FS_MAX_PATH starting from first '/'.
-    m_deviceEnd = std::strchr(pathData, ':');
-    if (!m_deviceEnd)
+    if (this == &path)
     {
-        // This means the path is invalid. Should figure something out here.
         return *this;
     }
 
-    // To do: Double check if the + 1 is really needed.
-    m_pathSize = FS_MAX_PATH + ((m_deviceEnd - pathData) + 1);
-    if (!Path::allocatePath(m_pathSize))
+    if (path.m_path == path.m_inlinePath)
     {
-        // To do: Throw some kind of allocation error?
-        return *this;
+        // Nothing to take. The inline buffer has to be copied.
+        Path::freePath();
+        std::memcpy(m_inlinePath, path.m_inlinePath, path.m_pathLength + 1);
     }
+    else
+    {
+        // Take path's heap buffer.
+        Path::freePath();
+        m_path = path.m_path;
+        m_pathSize = path.m_pathSize;
+        path.m_path = path.m_inlinePath;
+        path.m_pathSize = Path::inlineSize;
+    }
+    m_pathLength = path.m_pathLength;
+    m_deviceEnd = path.m_deviceEnd;
+    m_deviceCache.store(path.getDeviceCache(), std::memory_order_relaxed);
 
-    // Going to use this and ignore where it says the path begins.
-    size_t pathLength = 0;
-    const char *pathBegin = NULL;
-    getTrimmedPath(m_deviceEnd + 1, &pathBegin, pathLength);
+    path.m_path[0] = '\0';
+    path.m_pathLength = 0;
+    path.m_deviceEnd = Path::notFound;
+    path.m_deviceCache.store(0, std::memory_order_relaxed);
 
-    // Copy the device string first.
-    std::memcpy(m_path, pathData, (m_deviceEnd - pathData) + 2);
-    // Copy the rest of the path beginning where the slashes end.
-    std::memcpy(&m_path[std::char_traits<char>::length(m_path)], pathBegin, pathLength);
-    // Set the rest
-    m_deviceEnd = std::strchr(m_path, ':');
-    m_pathLength = std::char_traits<char>::length(m_path);
+    return *this;
+}
 
-    // Should be good to go.
+fslib::Path &fslib::Path::operator=(const char *pathData)
+{
+    Path::assignPath(pathData, std::char_traits<char>::length(pathData));
     return *this;
 }
 
 fslib::Path &fslib::Path::operator=(const std::string &pathData)
 {
-    return *this = pathData.c_str();
+    Path::assignPath(pathData.c_str(), pathData.length());
+    return *this;
 }
 
 fslib::Path &fslib::Path::operator=(std::string_view pathData)
 {
-    return *this = pathData.data();
+    Path::assignPath(pathData.data(), pathData.length());
+    return *this;
 }
 
 fslib::Path &fslib::Path::operator=(const std::filesystem::path &pathData)
 {
-    return *this = pathData.string().c_str();
+    const std::string &pathString = pathData.native();
+    Path::assignPath(pathString.c_str(), pathString.length());
+    return *this;
 }
 
-fslib::Path &fslib::Path::operator/=(const char *pathData)
+fslib::Path &fslib::Path::operator=(const fslib::PathLiteral &literal)
 {
-    // Get trimmed path without beginning and trailing slashes.
-    size_t pathLength = 0;
-    const char *pathBegin = nullptr;
-    getTrimmedPath(pathData, &pathBegin, pathLength);
-
-    if ((m_pathLength + pathLength) + 1 >= m_pathSize)
-    {
-        // Something here someday.
-        return *this;
-    }
-
-    // This is to avoid doubling up slashes after the device root.
-    if (m_path[m_pathLength - 1] != '/')
-    {
-        m_path[m_pathLength++] = '/';
-    }
-
-    // Memcpy to the end of the current path starting at pathBegin.
-    std::memcpy(&m_path[m_pathLength], pathBegin, pathLength);
-
-    m_pathLength += pathLength;
+    Path::assignCheckedPath(literal.cString(), literal.getLength(), literal.getDeviceName().length());
+    return *this;
+}
 
+fslib::Path &fslib::Path::operator/=(const char *pathData)
+{
+    Path::appendPath(pathData, std::char_traits<char>::length(pathData));
     return *this;
 }
 
 fslib::Path &fslib::Path::operator/=(const std::string &pathData)
 {
-    return *this /= pathData.c_str();
+    Path::appendPath(pathData.c_str(), pathData.length());
+    return *this;
 }
 
 fslib::Path &fslib::Path::operator/=(std::string_view pathData)
 {
-    return *this /= pathData.data();
+    Path::appendPath(pathData.data(), pathData.length());
+    return *this;
 }
 
 fslib::Path &fslib::Path::operator/=(const std::filesystem::path &pathData)
 {
-    return *this /= pathData.string().c_str();
+    const std::string &pathString = pathData.native();
+    Path::appendPath(pathString.c_str(), pathString.length());
+    return *this;
 }
 
 fslib::Path &fslib::Path::operator+=(const char *pathData)
 {
-    // If it's too long to fit into the buffer, bail.
-    size_t pathLength = std::char_traits<char>::length(pathData);
-    if (m_pathLength + pathLength >= m_pathSize)
-    {
-        return *this;
-    }
-    // Memcpy to the end.
-    std::memcpy(&m_path[m_pathLength], pathData, pathLength);
-    // Should be good. segfault
+    Path::concatenatePath(pathData, std::char_traits<char>::length(pathData));
     return *this;
 }
 
 fslib::Path &fslib::Path::operator+=(const std::string &pathData)
 {
-    return *this += pathData.c_str();
+    Path::concatenatePath(pathData.c_str(), pathData.length());
+    return *this;
 }
 
 fslib::Path &fslib::Path::operator+=(std::string_view pathData)
 {
-    return *this += pathData.data();
+    Path::concatenatePath(pathData.data(), pathData.length());
+    return *this;
 }
 
 fslib::Path &fslib::Path::operator+=(const std::filesystem::path &pathData)
 {
-    return *this += pathData.string().c_str();
+    const std::string &pathString = pathData.native();
+    Path::concatenatePath(pathString.c_str(), pathString.length());
+    return *this;
 }
 
-bool fslib::Path::allocatePath(uint16_t pathSize)
+void fslib::Path::assignPath(const char *pathData, size_t pathLength)
 {
-    // Call this first just incase so we don't be leakin all over.
-    Path::freePath();
+    // Assigning part of this path to itself would overwrite the source while copying.
+    if (pathData >= m_path && pathData < m_path + m_pathSize)
+    {
+        std::string pathCopy(pathData, pathLength);
+        Path::assignPath(pathCopy.c_str(), pathCopy.length());
+        return;
+    }
+
+    // The device only counts if it comes before the first slash. Anything without one goes to the SD card.
+    std::string_view device = "sdmc";
+    const char *colon = static_cast<const char *>(std::memchr(pathData, ':', pathLength));
+    const char *slash = static_cast<const char *>(std::memchr(pathData, '/', pathLength));
+    if (colon && (!slash || colon < slash))
+    {
+        device = std::string_view(pathData, colon - pathData);
+        pathLength -= (colon - pathData) + 1;
+        pathData = colon + 1;
+    }
+
+    size_t trimmedLength = 0;
+    const char *pathBegin = nullptr;
+    getTrimmedPath(pathData, pathLength, &pathBegin, trimmedLength);
+
+    // device:/ + path + NULL.
+    size_t newLength = device.length() + 2 + trimmedLength;
+    m_pathLength = 0;
+    m_path[0] = '\0';
+    m_deviceCache.store(0, std::memory_order_relaxed);
+    m_deviceEnd = device.length();
+    if (trimmedLength >= FS_MAX_PATH || !Path::reservePath(newLength + 1))
+    {
+        // This means the path is invalid. Should figure something out here.
+        m_deviceEnd = Path::notFound;
+        return;
+    }
+
+    std::memcpy(m_path, device.data(), device.length());
+    m_path[device.length()] = ':';
+    m_path[device.length() + 1] = '/';
+    std::memcpy(&m_path[device.length() + 2], pathBegin, trimmedLength);
+    m_path[newLength] = '\0';
+    m_pathLength = newLength;
+}
 
-    m_path = new (std::nothrow) char[pathSize];
-    if (!m_path)
+void fslib::Path::assignCheckedPath(const char *pathData, size_t pathLength, uint16_t deviceEnd)
+{
+    m_pathLength = 0;
+    m_path[0] = '\0';
+    m_deviceCache.store(0, std::memory_order_relaxed);
+    m_deviceEnd = deviceEnd;
+    if (!Path::reservePath(pathLength + 1))
+    {
+        m_deviceEnd = Path::notFound;
+        return;
+    }
+
+    std::memcpy(m_path, pathData, pathLength);
+    m_path[pathLength] = '\0';
+    m_pathLength = pathLength;
+}
+
+void fslib::Path::appendPath(const char *pathData, size_t pathLength)
+{
+    if (pathData >= m_path && pathData < m_path + m_pathSize)
+    {
+        std::string pathCopy(pathData, pathLength);
+        Path::appendPath(pathCopy.c_str(), pathCopy.length());
+        return;
+    }
+
+    // Get trimmed path without beginning and trailing slashes.
+    size_t trimmedLength = 0;
+    const char *pathBegin = nullptr;
+    getTrimmedPath(pathData, pathLength, &pathBegin, trimmedLength);
+
+    // This is to avoid doubling up slashes after the device root.
+    bool needsSlash = m_pathLength > 0 && m_path[m_pathLength - 1] != '/';
+    size_t newLength = m_pathLength + (needsSlash ? 1 : 0) + trimmedLength;
+    if (m_deviceEnd == Path::notFound || newLength - (m_deviceEnd + 1) >= FS_MAX_PATH || !Path::reservePath(newLength + 1))
+    {
+        // Something here someday.
+        return;
+    }
+
+    if (needsSlash)
+    {
+        m_path[m_pathLength++] = '/';
+    }
+    std::memcpy(&m_path[m_pathLength], pathBegin, trimmedLength);
+    m_pathLength = newLength;
+    m_path[m_pathLength] = '\0';
+}
+
+void fslib::Path::concatenatePath(const char *pathData, size_t pathLength)
+{
+    if (pathData >= m_path && pathData < m_path + m_pathSize)
+    {
+        std::string pathCopy(pathData, pathLength);
+        Path::concatenatePath(pathCopy.c_str(), pathCopy.length());
+        return;
+    }
+
+    // If it's too long to fit into the buffer, bail.
+    size_t newLength = m_pathLength + pathLength;
+    if (m_deviceEnd == Path::notFound || newLength - (m_deviceEnd + 1) >= FS_MAX_PATH || !Path::reservePath(newLength + 1))
+    {
+        return;
+    }
+
+    std::memcpy(&m_path[m_pathLength], pathData, pathLength);
+    m_pathLength = newLength;
+    m_path[m_pathLength] = '\0';
+}
+
+bool fslib::Path::reservePath(size_t pathSize)
+{
+    if (pathSize <= m_pathSize)
+    {
+        return true;
+    }
+
+    // Allocate enough for the longest path the device allows so this only happens once per path.
+    size_t deviceLength = m_deviceEnd == Path::notFound ? 0 : m_deviceEnd + 1;
+    size_t heapSize = std::max(pathSize, deviceLength + FS_MAX_PATH + 1);
+    char *heapPath = new (std::nothrow) char[heapSize];
+    if (!heapPath)
     {
         return false;
     }
-    // memset to all 0x00 just to be safe.
-    std::memset(m_path, 0x00, pathSize);
+
+    std::memcpy(heapPath, m_path, m_pathLength + 1);
+    Path::freePath();
+    m_path = heapPath;
+    m_pathSize = heapSize;
     return true;
 }
 
 void fslib::Path::freePath(void)
 {
-    if (m_path)
+    if (m_path != m_inlinePath)
     {
         delete[] m_path;
+        m_path = m_inlinePath;
+        m_pathSize = Path::inlineSize;
     }
 }
 
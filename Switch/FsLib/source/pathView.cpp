@@ -0,0 +1,58 @@
+#include "pathView.hpp"
+#include "path.hpp"
+#include "pathBuilder.hpp"
+#include "pathLiteral.hpp"
+#include <cstring>
+
+namespace
+{
+    const char *FORBIDDEN_PATH_CHARACTERS = "<>:\"|?*";
+} // namespace
+
+fslib::PathView::PathView(const fslib::Path &path)
+    : m_path(path.m_path), m_deviceEnd(path.m_deviceEnd), m_pathLength(path.m_pathLength)
+{
+}
+
+fslib::PathView::PathView(const fslib::PathBuilder &builder) : PathView(builder.getPath())
+{
+}
+
+fslib::PathView::PathView(const fslib::PathLiteral &literal)
+    : m_path(literal.cString()), m_deviceEnd(literal.getDeviceName().length()), m_pathLength(literal.getLength())
+{
+}
+
+bool fslib::PathView::isValid(void) const
+{
+    return m_deviceEnd != fslib::Path::notFound && m_pathLength > m_deviceEnd + 1 &&
+           std::strpbrk(&m_path[m_deviceEnd + 1], FORBIDDEN_PATH_CHARACTERS) == NULL;
+}
+
+const char *fslib::PathView::cString(void) const
+{
+    return m_path;
+}
+
+std::string_view fslib::PathView::getDeviceName(void) const
+{
+    if (m_deviceEnd == fslib::Path::notFound)
+    {
+        return std::string_view();
+    }
+    return std::string_view(m_path, m_deviceEnd);
+}
+
+const char *fslib::PathView::getPath(void) const
+{
+    if (m_deviceEnd == fslib::Path::notFound)
+    {
+        return m_path;
+    }
+    return &m_path[m_deviceEnd + 1];
+}
+
+size_t fslib::PathView::getLength(void) const
+{
+    return m_pathLength;
+}
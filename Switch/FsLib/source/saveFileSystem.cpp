@@ -1,10 +1,8 @@
 #include "saveFileSystem.hpp"
+#include "error.hpp"
 #include "fslib.hpp"
-#include "string.hpp"
 #include <switch.h>
 
-extern std::string g_fslibErrorString;
-
 bool fslib::openSystemSaveFileSystem(std::string_view deviceName,
                                      uint64_t systemSaveID,
                                      FsSaveDataSpaceId saveDataSpaceID,
@@ -22,7 +20,7 @@ bool fslib::openSystemSaveFileSystem(std::string_view deviceName,
     Result fsError = fsOpenSaveDataFileSystemBySystemSaveDataId(&fileSystem, saveDataSpaceID, &saveDataAttributes);
     if (R_FAILED(fsError))
     {
-        g_fslibErrorString = string::getFormattedString("Error opening system save data: 0x%X.", fsError);
+        fslib::error::setResult(fslib::Operation::OpenFileSystem, fsError, deviceName);
         return false;
     }
 
@@ -52,7 +50,7 @@ bool fslib::openAccountSaveFileSystem(std::string_view deviceName,
     Result fsError = fsOpenSaveDataFileSystem(&fileSystem, saveDataSpaceID, &saveDataAttributes);
     if (R_FAILED(fsError))
     {
-        g_fslibErrorString = string::getFormattedString("Error opening account save data: 0x%X.", fsError);
+        fslib::error::setResult(fslib::Operation::OpenFileSystem, fsError, deviceName);
         return false;
     }
 
@@ -78,7 +76,7 @@ bool fslib::openBCATSaveFileSystem(std::string_view deviceName, uint64_t applica
     Result fsError = fsOpenSaveDataFileSystem(&fileSystem, FsSaveDataSpaceId_User, &saveDataAttributes);
     if (R_FAILED(fsError))
     {
-        g_fslibErrorString = string::getFormattedString("Error opening BCAT save data: 0x%X.", fsError);
+        fslib::error::setResult(fslib::Operation::OpenFileSystem, fsError, deviceName);
         return false;
     }
 
@@ -104,7 +102,7 @@ bool fslib::openDeviceSaveFileSystem(std::string_view deviceName, uint64_t appli
     Result fsError = fsOpenSaveDataFileSystem(&fileSystem, FsSaveDataSpaceId_User, &saveDataAttributes);
     if (R_FAILED(fsError))
     {
-        g_fslibErrorString = string::getFormattedString("Error opening device save data: 0x%X.", fsError);
+        fslib::error::setResult(fslib::Operation::OpenFileSystem, fsError, deviceName);
         return false;
     }
 
@@ -130,7 +128,7 @@ bool fslib::openTemporarySaveFileSystem(std::string_view deviceName)
     Result fsError = fsOpenSaveDataFileSystem(&fileSystem, FsSaveDataSpaceId_User, &saveDataAttributes);
     if (R_FAILED(fsError))
     {
-        g_fslibErrorString = string::getFormattedString("Error opening temporary save data: 0x%X.", fsError);
+        fslib::error::setResult(fslib::Operation::OpenFileSystem, fsError, deviceName);
         return false;
     }
 
@@ -160,7 +158,7 @@ bool fslib::openCacheSaveFileSystem(std::string_view deviceName,
     Result fsError = fsOpenSaveDataFileSystem(&fileSystem, saveDataSpaceID, &saveDataAttributes);
     if (R_FAILED(fsError))
     {
-        g_fslibErrorString = string::getFormattedString("Error opening cache save data: 0x%X.", fsError);
+        fslib::error::setResult(fslib::Operation::OpenFileSystem, fsError, deviceName);
         return false;
     }
 
@@ -186,7 +184,7 @@ bool fslib::openSystemBCATSaveFileSystem(std::string_view deviceName, uint64_t s
     Result fsError = fsOpenSaveDataFileSystemBySystemSaveDataId(&fileSystem, FsSaveDataSpaceId_User, &saveDataAttributes);
     if (R_FAILED(fsError))
     {
-        g_fslibErrorString = string::getFormattedString("Error opening system bcat save data: 0x%X.", fsError);
+        fslib::error::setResult(fslib::Operation::OpenFileSystem, fsError, deviceName);
         return false;
     }
 
@@ -1,10 +1,10 @@
 #include "storage.hpp"
-#include "string.hpp"
+#include "error.hpp"
+#include <algorithm>
+#include <cstring>
+#include <memory>
 #include <string>
 
-// Globally used error string.
-extern std::string g_fslibErrorString;
-
 fslib::Storage::Storage(FsBisPartitionId partitionID)
 {
     Storage::open(partitionID);
@@ -16,6 +16,8 @@ fslib::Storage::~Storage()
     {
         Storage::close();
     }
+    // Close only stops the thread if the storage was open.
+    Storage::stopReadAhead();
 }
 
 void fslib::Storage::open(FsBisPartitionId partitionID)
@@ -26,23 +28,29 @@ void fslib::Storage::open(FsBisPartitionId partitionID)
     Result fsError = fsOpenBisStorage(&m_storageHandle, partitionID);
     if (R_FAILED(fsError))
     {
-        g_fslibErrorString = string::getFormattedString("Error opening partition ID %X: 0x%X.", partitionID, fsError);
+        fslib::error::setResult(fslib::Operation::OpenStorage, fsError);
         return;
     }
 
     fsError = fsStorageGetSize(&m_storageHandle, &m_streamSize);
     if (R_FAILED(fsError))
     {
-        g_fslibErrorString = string::getFormattedString("Error getting storage size: 0x%X.", fsError);
+        fslib::error::setResult(fslib::Operation::OpenStorage, fsError);
         return;
     }
     // Offset is always 0 since storage is read only.
     m_offset = 0;
     m_isOpen = true;
+    Storage::startReadAhead();
 }
 
 void fslib::Storage::close(void)
 {
+    // The read ahead thread can't be using the handle when it's closed and nothing cached belongs to the next storage opened.
+    Storage::stopReadAhead();
+    m_cacheList.clear();
+    m_cacheMap.clear();
+    m_lastBlockRead = -1;
     fsStorageClose(&m_storageHandle);
 }
 
@@ -53,17 +61,86 @@ ssize_t fslib::Storage::read(void *buffer, size_t bufferSize)
         bufferSize = m_streamSize - m_offset;
     }
 
+    // Small reads go through the cache if it's enabled.
+    if (m_blockCount > 0 && bufferSize < m_blockSize)
+    {
+        ssize_t bytesRead = Storage::readFromCache(buffer, bufferSize);
+        if (bytesRead > 0)
+        {
+            Stream::hashData(buffer, bytesRead);
+        }
+        return bytesRead;
+    }
+
     Result fsError = fsStorageRead(&m_storageHandle, m_offset, buffer, static_cast<uint64_t>(bufferSize));
     if (R_FAILED(fsError))
     {
-        g_fslibErrorString = string::getFormattedString("Error reading from storage: 0x%X.", fsError);
-        return 0;
+        fslib::error::setResult(fslib::Operation::ReadStorage, fsError);
+        return -1;
     }
     // There isn't really a way to make sure this worked 100%...
+    Stream::hashData(buffer, bufferSize);
     m_offset += bufferSize;
     return bufferSize;
 }
 
+ssize_t fslib::Storage::readv(std::span<const fslib::ReadVector> vectors)
+{
+    if (Stream::endOfStream())
+    {
+        return 0;
+    }
+
+    int64_t totalSize = std::min(static_cast<int64_t>(Stream::getVectorSize(vectors)), m_streamSize - m_offset);
+    if (totalSize == 0)
+    {
+        return 0;
+    }
+
+    // Lots of small buffers are cheaper to read in one go and split up after.
+    std::unique_ptr<unsigned char[]> stagingBuffer;
+    if (vectors.size() > 1 && totalSize <= static_cast<int64_t>(Stream::vectorStagingLimit))
+    {
+        stagingBuffer.reset(new (std::nothrow) unsigned char[totalSize]);
+    }
+
+    if (stagingBuffer)
+    {
+        Result fsError = fsStorageRead(&m_storageHandle, m_offset, stagingBuffer.get(), totalSize);
+        if (R_FAILED(fsError))
+        {
+            fslib::error::setResult(fslib::Operation::ReadStorage, fsError);
+            return -1;
+        }
+        Stream::scatterToVectors(stagingBuffer.get(), totalSize, vectors);
+        Stream::hashData(stagingBuffer.get(), totalSize);
+        m_offset += totalSize;
+        return totalSize;
+    }
+
+    int64_t totalBytesRead = 0;
+    for (const fslib::ReadVector &vector : vectors)
+    {
+        uint64_t readSize = std::min(static_cast<int64_t>(vector.bufferSize), totalSize - totalBytesRead);
+        if (readSize == 0)
+        {
+            break;
+        }
+
+        Result fsError = fsStorageRead(&m_storageHandle, m_offset, vector.buffer, readSize);
+        if (R_FAILED(fsError))
+        {
+            fslib::error::setResult(fslib::Operation::ReadStorage, fsError);
+            return -1;
+        }
+        // Same as read. There's no way to know how much was actually read.
+        Stream::hashData(vector.buffer, readSize);
+        m_offset += readSize;
+        totalBytesRead += readSize;
+    }
+    return totalBytesRead;
+}
+
 signed char fslib::Storage::readByte(void)
 {
     if (m_offset >= m_streamSize)
@@ -71,12 +148,279 @@ signed char fslib::Storage::readByte(void)
         return -1;
     }
 
+    if (m_blockCount > 0)
+    {
+        char byte = 0x00;
+        return Storage::readFromCache(&byte, 1) == 1 ? byte : -1;
+    }
+
     char byte = 0x00;
     Result fsError = fsStorageRead(&m_storageHandle, m_offset++, &byte, 1);
     if (R_FAILED(fsError))
     {
-        g_fslibErrorString = string::getFormattedString("Error reading byte from storage: 0x%X.", fsError);
+        fslib::error::setResult(fslib::Operation::ReadStorage, fsError);
         return -1;
     }
     return byte;
 }
+
+bool fslib::Storage::setBlockCache(size_t blockCount, size_t blockSize, size_t readAheadBlocks)
+{
+    // The thread needs to be stopped before anything it uses is changed.
+    Storage::stopReadAhead();
+    m_cacheList.clear();
+    m_cacheMap.clear();
+    m_readAheadBuffer.reset();
+    m_lastBlockRead = -1;
+    m_cacheHits = 0;
+    m_cacheMisses = 0;
+    m_blockCount = 0;
+    m_blockSize = 0;
+    m_readAheadBlocks = 0;
+
+    if (blockCount == 0)
+    {
+        return true;
+    }
+    else if (blockSize == 0)
+    {
+        fslib::error::setReason(fslib::Operation::SetBufferSize, "Block size can't be 0.");
+        return false;
+    }
+
+    m_blockCount = blockCount;
+    m_blockSize = blockSize;
+    // Reading ahead more than the cache can hold would just push out what was read ahead.
+    m_readAheadBlocks = std::min(readAheadBlocks, blockCount - 1);
+    if (m_readAheadBlocks > 0)
+    {
+        m_readAheadBuffer.reset(new (std::nothrow) unsigned char[m_blockSize * m_readAheadBlocks]);
+        if (!m_readAheadBuffer)
+        {
+            // The cache still works without this.
+            m_readAheadBlocks = 0;
+            fslib::error::setReason(fslib::Operation::SetBufferSize, "Couldn't allocate read ahead buffer.");
+            return false;
+        }
+    }
+
+    if (m_isOpen)
+    {
+        Storage::startReadAhead();
+    }
+    return true;
+}
+
+uint64_t fslib::Storage::getCacheHits(void) const
+{
+    return m_cacheHits;
+}
+
+uint64_t fslib::Storage::getCacheMisses(void) const
+{
+    return m_cacheMisses;
+}
+
+ssize_t fslib::Storage::readFromCache(void *buffer, size_t bufferSize)
+{
+    unsigned char *bufferOut = static_cast<unsigned char *>(buffer);
+    size_t bytesCopied = 0;
+
+    std::lock_guard<std::mutex> cacheLock(m_cacheLock);
+    while (bytesCopied < bufferSize)
+    {
+        int64_t blockIndex = m_offset / static_cast<int64_t>(m_blockSize);
+        CacheBlock *block = Storage::getBlock(blockIndex);
+        if (!block)
+        {
+            return bytesCopied > 0 ? static_cast<ssize_t>(bytesCopied) : -1;
+        }
+
+        size_t blockOffset = m_offset - (blockIndex * static_cast<int64_t>(m_blockSize));
+        if (blockOffset >= block->length)
+        {
+            break;
+        }
+
+        size_t copySize = std::min(block->length - blockOffset, bufferSize - bytesCopied);
+        std::memcpy(&bufferOut[bytesCopied], &block->data[blockOffset], copySize);
+        bytesCopied += copySize;
+        m_offset += copySize;
+    }
+    return bytesCopied;
+}
+
+fslib::Storage::CacheBlock *fslib::Storage::getBlock(int64_t blockIndex)
+{
+    auto findBlock = m_cacheMap.find(blockIndex);
+    if (findBlock != m_cacheMap.end())
+    {
+        ++m_cacheHits;
+        // Just used, so it goes to the front.
+        m_cacheList.splice(m_cacheList.begin(), m_cacheList, findBlock->second);
+    }
+    else
+    {
+        ++m_cacheMisses;
+        CacheBlock *block = Storage::insertBlock(blockIndex, m_cacheList, m_cacheList.begin());
+        if (!block)
+        {
+            return nullptr;
+        }
+
+        int64_t blockOffset = blockIndex * static_cast<int64_t>(m_blockSize);
+        size_t readSize = std::min(static_cast<int64_t>(m_blockSize), m_streamSize - blockOffset);
+        Result fsError = fsStorageRead(&m_storageHandle, blockOffset, block->data.get(), readSize);
+        if (R_FAILED(fsError))
+        {
+            // Send the block to the back so it's the first one reused.
+            m_cacheMap.erase(blockIndex);
+            block->blockIndex = -1;
+            m_cacheList.splice(m_cacheList.end(), m_cacheList, m_cacheList.begin());
+            fslib::error::setResult(fslib::Operation::ReadStorage, fsError);
+            return nullptr;
+        }
+        block->length = readSize;
+    }
+
+    // Moving on to the next block means reading is sequential, so get the blocks after it ready.
+    if (m_readAheadBlocks > 0 && blockIndex == m_lastBlockRead + 1)
+    {
+        m_readAheadBlock = blockIndex + 1;
+        m_readAheadCondition.notify_one();
+    }
+    m_lastBlockRead = blockIndex;
+    return &m_cacheList.front();
+}
+
+fslib::Storage::CacheBlock *fslib::Storage::insertBlock(int64_t blockIndex,
+                                                        std::list<CacheBlock> &blockList,
+                                                        std::list<CacheBlock>::iterator position)
+{
+    // Blocks waiting in another list to be spliced in still count against the cache's size.
+    size_t blocksUsed = m_cacheList.size() + (&blockList != &m_cacheList ? blockList.size() : 0);
+    std::list<CacheBlock>::iterator newBlock;
+    if (blocksUsed >= m_blockCount)
+    {
+        if (m_cacheList.empty())
+        {
+            return nullptr;
+        }
+
+        // Reuse the least recently used block's memory.
+        CacheBlock &oldestBlock = m_cacheList.back();
+        if (oldestBlock.blockIndex != -1)
+        {
+            m_cacheMap.erase(oldestBlock.blockIndex);
+        }
+        blockList.splice(position, m_cacheList, std::prev(m_cacheList.end()));
+        newBlock = std::prev(position);
+    }
+    else
+    {
+        newBlock = blockList.emplace(position);
+        newBlock->data.reset(new (std::nothrow) unsigned char[m_blockSize]);
+        if (!newBlock->data)
+        {
+            blockList.erase(newBlock);
+            fslib::error::setReason(fslib::Operation::ReadStorage, "Couldn't allocate cache block.");
+            return nullptr;
+        }
+    }
+
+    newBlock->blockIndex = blockIndex;
+    newBlock->length = 0;
+    m_cacheMap[blockIndex] = newBlock;
+    return &*newBlock;
+}
+
+void fslib::Storage::startReadAhead(void)
+{
+    if (m_readAheadBlocks == 0 || m_readAheadThread.joinable())
+    {
+        return;
+    }
+
+    m_readAheadExit = false;
+    m_readAheadBlock = -1;
+    m_readAheadThread = std::thread(&fslib::Storage::readAheadThreadFunction, this);
+}
+
+void fslib::Storage::stopReadAhead(void)
+{
+    if (!m_readAheadThread.joinable())
+    {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> cacheLock(m_cacheLock);
+        m_readAheadExit = true;
+    }
+    m_readAheadCondition.notify_one();
+    m_readAheadThread.join();
+}
+
+void fslib::Storage::readAheadThreadFunction(void)
+{
+    std::unique_lock<std::mutex> cacheLock(m_cacheLock);
+    while (true)
+    {
+        m_readAheadCondition.wait(cacheLock, [this]() { return m_readAheadExit || m_readAheadBlock != -1; });
+        if (m_readAheadExit)
+        {
+            return;
+        }
+
+        int64_t firstBlock = m_readAheadBlock;
+        m_readAheadBlock = -1;
+
+        int64_t totalBlocks = (m_streamSize + static_cast<int64_t>(m_blockSize) - 1) / static_cast<int64_t>(m_blockSize);
+        int64_t endBlock = std::min(firstBlock + static_cast<int64_t>(m_readAheadBlocks), totalBlocks);
+        // Blocks already cached don't need to be read again.
+        while (firstBlock < endBlock && m_cacheMap.contains(firstBlock))
+        {
+            ++firstBlock;
+        }
+
+        if (firstBlock >= endBlock)
+        {
+            continue;
+        }
+
+        int64_t readOffset = firstBlock * static_cast<int64_t>(m_blockSize);
+        size_t readSize = std::min((endBlock - firstBlock) * static_cast<int64_t>(m_blockSize), m_streamSize - readOffset);
+
+        // Everything is read with one request. The cache isn't locked while reading so it can still be used.
+        cacheLock.unlock();
+        Result fsError = fsStorageRead(&m_storageHandle, readOffset, m_readAheadBuffer.get(), readSize);
+        cacheLock.lock();
+        if (R_FAILED(fsError) || m_readAheadExit)
+        {
+            // Not the end of the world. The blocks will just be read when they're needed.
+            continue;
+        }
+
+        // Blocks read ahead might never be used, so they go in at the least recently used end instead of pushing out blocks that
+        // are. They're gathered in their own list first so they don't replace each other, and only move up once they're read.
+        std::list<CacheBlock> readAheadList;
+        for (int64_t blockIndex = firstBlock; blockIndex < endBlock; blockIndex++)
+        {
+            if (m_cacheMap.contains(blockIndex))
+            {
+                continue;
+            }
+
+            CacheBlock *block = Storage::insertBlock(blockIndex, readAheadList, readAheadList.end());
+            if (!block)
+            {
+                break;
+            }
+
+            size_t bufferOffset = (blockIndex - firstBlock) * m_blockSize;
+            block->length = std::min(m_blockSize, readSize - bufferOffset);
+            std::memcpy(block->data.get(), &m_readAheadBuffer[bufferOffset], block->length);
+        }
+        m_cacheList.splice(m_cacheList.end(), readAheadList);
+    }
+}
@@ -1,4 +1,6 @@
 #include "stream.hpp"
+#include <algorithm>
+#include <cstring>
 
 bool fslib::Stream::isOpen(void) const
 {
@@ -46,6 +48,11 @@ void fslib::Stream::seek(int64_t offset, uint8_t origin)
     Stream::ensureOffsetIsValid();
 }
 
+void fslib::Stream::setHasher(fslib::Hasher *hasher)
+{
+    m_hasher = hasher;
+}
+
 void fslib::Stream::ensureOffsetIsValid(void)
 {
     if (m_offset < 0)
@@ -57,3 +64,29 @@ void fslib::Stream::ensureOffsetIsValid(void)
         m_offset = m_streamSize - 1;
     }
 }
+
+void fslib::Stream::scatterToVectors(const unsigned char *source, size_t sourceSize, std::span<const fslib::ReadVector> vectors)
+{
+    size_t sourceOffset = 0;
+    for (const fslib::ReadVector &vector : vectors)
+    {
+        if (sourceOffset >= sourceSize)
+        {
+            break;
+        }
+
+        size_t copySize = std::min(vector.bufferSize, sourceSize - sourceOffset);
+        std::memcpy(vector.buffer, &source[sourceOffset], copySize);
+        sourceOffset += copySize;
+    }
+}
+
+void fslib::Stream::gatherFromVectors(std::span<const fslib::WriteVector> vectors, unsigned char *destination)
+{
+    size_t destinationOffset = 0;
+    for (const fslib::WriteVector &vector : vectors)
+    {
+        std::memcpy(&destination[destinationOffset], vector.buffer, vector.bufferSize);
+        destinationOffset += vector.bufferSize;
+    }
+}